@@ -31,6 +31,12 @@ namespace STL
             free(p);
         }
 
+        // 与pool_alloc接口一致，使malloc_alloc可作为容器的Alloc参数
+        static void deallocate(void *p, size_t)
+        {
+            free(p);
+        }
+
         // 仿真C++的set_new_handler()
         static void (*set_malloc_handler(void (*f)()))()
         {
@@ -98,6 +104,13 @@ namespace STL
     public:
         static void * allocate(size_t n);
         static void deallocate(void *p, size_t n);
+
+        // 整批分配count个大小为n的区块，以区块首部的next串成链表（末块的next为nullptr），返回首块
+        // 先取free_list上现有的区块，不足的部分直接从内存池成块切出
+        static void * allocate_chain(size_t n, size_t count);
+
+        // 整批释放由next串起的区块链表[first, last]，整条链表一次挂回free_list
+        static void deallocate_chain(void *first, void *last, size_t n);
     };
     
     // 初值
@@ -139,6 +152,65 @@ namespace STL
         *my_free_node = q;
     }
    
+    void * pool_alloc::allocate_chain(size_t n, size_t count)
+    {
+        FreeNode *head = nullptr;
+        FreeNode **link = &head;
+        if (n > static_cast<size_t>(MAX_BYTES)) {
+            try {
+                for ( ; count; --count) {
+                    *link = reinterpret_cast<FreeNode *>(malloc_alloc::allocate(n));
+                    link = &(*link)->next;
+                }
+            } catch(...) {
+                *link = nullptr;
+                while (head) {
+                    FreeNode *q = head->next;
+                    malloc_alloc::deallocate(head);
+                    head = q;
+                }
+                throw;
+            }
+            *link = nullptr;
+            return head;
+        }
+        const size_t size = ROUND_UP(n);
+        FreeNode *&my_free_node = free_list[FREE_LIST_INDEX(n)];
+        for ( ; count && my_free_node; --count) {
+            *link = my_free_node;
+            link = &my_free_node->next;
+            my_free_node = my_free_node->next;
+        }
+        while (count) {
+            // 每次至多切出4096个区块，以免内存池一次向heap要太多空间
+            int n_nodes = count < 4096 ? static_cast<int>(count) : 4096;
+            char *chunk = chunk_alloc(size, n_nodes);
+            for (int i = 0; i < n_nodes; ++i) {
+                *link = reinterpret_cast<FreeNode *>(chunk + i * size);
+                link = &(*link)->next;
+            }
+            count -= n_nodes;
+        }
+        *link = nullptr;
+        return head;
+    }
+
+    void pool_alloc::deallocate_chain(void *first, void *last, size_t n)
+    {
+        if (n > static_cast<size_t>(MAX_BYTES)) {
+            FreeNode *q = reinterpret_cast<FreeNode *>(first);
+            while (q) {
+                FreeNode *next = q == last ? nullptr : q->next;
+                malloc_alloc::deallocate(q);
+                q = next;
+            }
+            return;
+        }
+        FreeNode **my_free_node = free_list + FREE_LIST_INDEX(n);
+        reinterpret_cast<FreeNode *>(last)->next = *my_free_node;
+        *my_free_node = reinterpret_cast<FreeNode *>(first);
+    }
+
     // free_list无可用时调用，为free_list填充空间
     // 新的空间取自内存池，取得20个新节点
     // 若内存池空间不足，则获得节点数会＜20
@@ -11,6 +11,14 @@ using std::endl;
 
 namespace STL
 {    
+    // Alloc是否提供整批分配与释放的接口allocate_chain、deallocate_chain
+    template <class Alloc, class = void>
+    struct has_chain_alloc : public false_type {};
+
+    template <class Alloc>
+    struct has_chain_alloc<Alloc, typename void_type<decltype(Alloc::allocate_chain(size_t(), size_t()))>::type>
+    : public true_type {};
+
     // 空间分配器allocator
     template <class T, class Alloc>
     class allocator
@@ -43,6 +51,71 @@ namespace STL
         static void deallocate(T *p, size_t n) { if (0 != n) Alloc::deallocate(p, sizeof(T) * n); }
 
         static size_type max_size() { return size_t(-1) / sizeof(value_type); }
+
+        // 整批分配与释放：多块空间以块首的指针串成链表，末块的链接为nullptr
+        // Alloc提供相应接口时一次完成，否则逐块分配、释放
+        static pointer& chain_next(pointer p)
+        {
+            static_assert(sizeof(T) >= sizeof(void*), "allocator: chain link does not fit in T");
+            return *reinterpret_cast<pointer*>(p);
+        }
+
+        /**
+         *  @brief  分配count个对象的空间，返回链表的首块
+         */
+        static pointer allocate_chain(size_t count)
+        { return count ? allocate_chain(count, has_chain_alloc<Alloc>()) : nullptr; }
+
+        /**
+         *  @brief  释放链表[first, last]中的count块空间
+         */
+        static void deallocate_chain(pointer first, pointer last, size_t count)
+        {
+            if (count)
+                deallocate_chain(first, last, has_chain_alloc<Alloc>());
+        }
+
+    private:
+        static pointer allocate_chain(size_t count, STL::true_type)
+        {
+            if (count > max_size())
+                THROW_BAD_ALLOC();
+            return static_cast<pointer>(Alloc::allocate_chain(sizeof(T), count));
+        }
+
+        static pointer allocate_chain(size_t count, STL::false_type)
+        {
+            pointer head = nullptr;
+            try {
+                for ( ; count; --count) {
+                    pointer p = allocate();
+                    chain_next(p) = head;
+                    head = p;
+                }
+            } catch(...) {
+                while (head) {
+                    pointer p = chain_next(head);
+                    deallocate(head);
+                    head = p;
+                }
+                throw;
+            }
+            return head;
+        }
+
+        static void deallocate_chain(pointer first, pointer last, STL::true_type)
+        { Alloc::deallocate_chain(first, last, sizeof(T)); }
+
+        static void deallocate_chain(pointer first, pointer last, STL::false_type)
+        {
+            for (;;) {
+                pointer next = chain_next(first);
+                deallocate(first);
+                if (first == last)
+                    break;
+                first = next;
+            }
+        }
     };
 
 } /* namespace STL */
@@ -0,0 +1,1003 @@
+#ifndef TINYSTL_BTREE_H_
+#define TINYSTL_BTREE_H_
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "algobase.h"
+#include "allocator.h"
+#include "construct.h"
+#include "iterator.h"
+#include "type_traits.h"
+
+using std::pair;
+
+namespace STL
+{
+
+    // 每个节点存放的元素个数，使叶节点约为256字节（4个缓存行），至少为3
+    template <class Value>
+    struct btree_node_values
+    {
+        enum {
+            target  = 256,
+            raw     = (target - 2 * sizeof(void*)) / sizeof(Value),
+            value   = raw < 3 ? 3 : (raw > 255 ? 255 : raw)
+        };
+    };
+
+    template <class Value, int N>
+    struct btree_internal_node;
+
+    /**
+     *  B树节点，内部节点与叶节点都存放元素
+     *  叶节点只有此结构；内部节点为btree_internal_node，末尾多出N + 1个孩子指针
+     */
+    template <class Value, int N>
+    struct btree_node
+    {
+        btree_node*     parent;     // 根节点的parent为nullptr
+        unsigned short  position;   // 本节点在父节点children中的下标
+        unsigned short  count;      // 元素个数
+        bool            leaf;
+        typename std::aligned_storage<sizeof(Value), alignof(Value)>::type slots[N];
+
+        Value* value(int i) { return reinterpret_cast<Value*>(&slots[i]); }
+        const Value* value(int i) const { return reinterpret_cast<const Value*>(&slots[i]); }
+
+        btree_node*& child(int i);
+        btree_node* child(int i) const;
+    };
+
+    template <class Value, int N>
+    struct btree_internal_node : public btree_node<Value, N>
+    {
+        btree_node<Value, N>* children[N + 1];
+    };
+
+    template <class Value, int N>
+    inline btree_node<Value, N>*& btree_node<Value, N>::child(int i)
+    { return static_cast<btree_internal_node<Value, N>*>(this)->children[i]; }
+
+    template <class Value, int N>
+    inline btree_node<Value, N>* btree_node<Value, N>::child(int i) const
+    { return static_cast<const btree_internal_node<Value, N>*>(this)->children[i]; }
+
+
+    /**
+     *  B树迭代器，以（节点，下标）表示一个元素
+     *  end()为（最右叶节点，其元素个数）
+     */
+    template <class Value, class Ref, class Ptr, int N>
+    struct btree_iterator
+    {
+        using iterator          = btree_iterator<Value, Value&, Value*, N>;
+        using const_iterator    = btree_iterator<Value, const Value&, const Value*, N>;
+        using Self              = btree_iterator;
+        using node_type         = btree_node<Value, N>;
+
+        using iterator_category = STL::bidirectional_iterator_tag;
+        using value_type        = Value;
+        using pointer           = Ptr;
+        using reference         = Ref;
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+
+        node_type*  node;
+        int         position;
+
+        btree_iterator() noexcept : node(nullptr), position(0) { }
+        btree_iterator(node_type* n, int i) noexcept : node(n), position(i) { }
+        btree_iterator(const iterator& x) noexcept : node(x.node), position(x.position) { }
+
+        iterator M_const_cast() const noexcept { return iterator(node, position); }
+
+        reference operator*() const noexcept { return *node->value(position); }
+        pointer operator->() const noexcept { return node->value(position); }
+
+        void increment()
+        {
+            if (node->leaf) {
+                if (++position < node->count)
+                    return;
+                // 叶节点已走完，向上找到第一个尚未走完的祖先；走到根仍未找到则为end()
+                Self save = *this;
+                while (position == node->count && node->parent) {
+                    position = node->position;
+                    node = node->parent;
+                }
+                if (position == node->count)
+                    *this = save;
+            } else {
+                // 右侧子树的最左叶节点
+                node = node->child(position + 1);
+                while (!node->leaf)
+                    node = node->child(0);
+                position = 0;
+            }
+        }
+
+        void decrement()
+        {
+            if (node->leaf) {
+                if (--position >= 0)
+                    return;
+                Self save = *this;
+                while (position < 0 && node->parent) {
+                    position = node->position - 1;
+                    node = node->parent;
+                }
+                if (position < 0)
+                    *this = save;
+            } else {
+                // 左侧子树的最右叶节点
+                node = node->child(position);
+                while (!node->leaf)
+                    node = node->child(node->count);
+                position = node->count - 1;
+            }
+        }
+
+        Self& operator++() { increment(); return *this; }
+        Self operator++(int) { Self tmp = *this; increment(); return tmp; }
+        Self& operator--() { decrement(); return *this; }
+        Self operator--(int) { Self tmp = *this; decrement(); return tmp; }
+
+        bool operator==(const Self& x) const noexcept { return node == x.node && position == x.position; }
+        bool operator!=(const Self& x) const noexcept { return !(*this == x); }
+    };
+
+
+    /**
+     *  B树，模板参数与rb_tree相同，可作为set/map的底层容器
+     *
+     *  @tparam  Key        键值类型
+     *  @tparam  Val        元素类型
+     *  @tparam  KeyOfValue 从元素中取出Key的函数对象
+     *  @tparam  Compare    键值比较函数
+     *  @tparam  Alloc      空间分配器
+     *
+     *  每个节点连续存放多个有序元素，树高约为log_N(n)，查找时访问的缓存行远少于rb_tree，
+     *  每个元素分摊的指针开销也小得多
+     *  元素在节点间移动，任何插入或删除都使所有迭代器失效（erase返回的迭代器除外）
+     */
+    template <class Key, class Val, class KeyOfValue, class Compare,
+              class Alloc = STL::pool_alloc>
+    class btree
+    {
+    public:
+        enum { node_values = btree_node_values<Val>::value };
+
+    private:
+        using node_type         = btree_node<Val, node_values>;
+        using internal_type     = btree_internal_node<Val, node_values>;
+        using leaf_allocator    = STL::allocator<node_type, Alloc>;
+        using internal_allocator = STL::allocator<internal_type, Alloc>;
+
+        // 非根节点至少含有的元素个数
+        enum { min_values = (node_values - 1) / 2 };
+
+    public:
+        using key_type          = Key;
+        using value_type        = Val;
+        using pointer           = value_type*;
+        using const_pointer     = const value_type*;
+        using reference         = value_type&;
+        using const_reference   = const value_type&;
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+
+        using iterator          = btree_iterator<Val, Val&, Val*, node_values>;
+        using const_iterator    = btree_iterator<Val, const Val&, const Val*, node_values>;
+
+    private:
+        node_type*  root;
+        node_type*  leftmost;       // 最左叶节点，即begin()所在节点
+        node_type*  rightmost;      // 最右叶节点，即end()所在节点
+        size_type   node_count;     // 元素个数
+        Compare     key_compare;
+        KeyOfValue  get_key;
+
+    private:
+        // 节点的分配与释放
+
+        node_type* new_leaf(node_type* parent)
+        {
+            node_type* n = leaf_allocator::allocate();
+            n->parent = parent;
+            n->position = 0;
+            n->count = 0;
+            n->leaf = true;
+            return n;
+        }
+
+        node_type* new_internal(node_type* parent)
+        {
+            node_type* n = internal_allocator::allocate();
+            n->parent = parent;
+            n->position = 0;
+            n->count = 0;
+            n->leaf = false;
+            return n;
+        }
+
+        void free_node(node_type* n)
+        {
+            if (n->leaf)
+                leaf_allocator::deallocate(n);
+            else
+                internal_allocator::deallocate(static_cast<internal_type*>(n));
+        }
+
+        // 析构以n为根的子树中的所有元素并释放节点
+        void destroy_subtree(node_type* n)
+        {
+            STL::destroy(n->value(0), n->value(0) + n->count);
+            if (!n->leaf)
+                for (int i = 0; i <= n->count; ++i)
+                    destroy_subtree(n->child(i));
+            free_node(n);
+        }
+
+        // 复制以x为根的子树，parent为新子树的父节点
+        node_type* clone_subtree(const node_type* x, node_type* parent)
+        {
+            node_type* n = x->leaf ? new_leaf(parent) : new_internal(parent);
+            n->position = x->position;
+            try {
+                for ( ; n->count < x->count; ++n->count)
+                    STL::construct(n->value(n->count), *x->value(n->count));
+            } catch(...) {
+                STL::destroy(n->value(0), n->value(0) + n->count);
+                free_node(n);
+                throw;
+            }
+            if (!n->leaf) {
+                int i = 0;
+                try {
+                    for ( ; i <= x->count; ++i)
+                        n->child(i) = clone_subtree(x->child(i), n);
+                } catch(...) {
+                    for (int j = 0; j < i; ++j)
+                        destroy_subtree(n->child(j));
+                    STL::destroy(n->value(0), n->value(0) + n->count);
+                    free_node(n);
+                    throw;
+                }
+            }
+            return n;
+        }
+
+        void set_child(node_type* p, int i, node_type* c)
+        {
+            p->child(i) = c;
+            c->parent = p;
+            c->position = static_cast<unsigned short>(i);
+        }
+
+        // 将src节点第j个元素移到dst节点第i个位置（未构造的空位）
+        static void move_value(node_type* dst, int i, node_type* src, int j)
+        {
+            STL::construct(dst->value(i), std::move(*src->value(j)));
+            STL::destroy(src->value(j));
+        }
+
+        // 在节点n的位置i处腾出一个空位，[i, count)的元素右移一位；内部节点的孩子[i + 1, count + 1)随之右移
+        void shift_right(node_type* n, int i)
+        {
+            for (int j = n->count; j > i; --j)
+                move_value(n, j, n, j - 1);
+            if (!n->leaf)
+                for (int j = n->count + 1; j > i + 1; --j)
+                    set_child(n, j, n->child(j - 1));
+        }
+
+        // 填补节点n位置i处的空位，[i + 1, count)的元素左移一位；内部节点的孩子[i + 2, count + 1)随之左移
+        void shift_left(node_type* n, int i)
+        {
+            for (int j = i; j + 1 < n->count; ++j)
+                move_value(n, j, n, j + 1);
+            if (!n->leaf)
+                for (int j = i + 1; j < n->count; ++j)
+                    set_child(n, j, n->child(j + 1));
+        }
+
+        void update_extremes()
+        {
+            if (root == nullptr) {
+                leftmost = rightmost = nullptr;
+                return;
+            }
+            leftmost = rightmost = root;
+            while (!leftmost->leaf)
+                leftmost = leftmost->child(0);
+            while (!rightmost->leaf)
+                rightmost = rightmost->child(rightmost->count);
+        }
+
+    private:
+        // 插入
+
+        /**
+         *  分裂已满的节点n：前一半留在n中，中间元素上移到父节点，后一半移入新的右兄弟
+         *  父节点已满时先分裂父节点，n为根时新建根节点
+         */
+        void split(node_type* n)
+        {
+            if (n->parent == nullptr) {
+                node_type* r = new_internal(nullptr);
+                set_child(r, 0, n);
+                root = r;
+            } else if (n->parent->count == node_values) {
+                split(n->parent);
+            }
+            node_type* p = n->parent;
+            const int pos = n->position;
+            node_type* sib = n->leaf ? new_leaf(p) : new_internal(p);
+
+            const int mid = node_values / 2;
+            for (int j = mid + 1; j < n->count; ++j)
+                move_value(sib, j - mid - 1, n, j);
+            if (!n->leaf)
+                for (int j = mid + 1; j <= n->count; ++j)
+                    set_child(sib, j - mid - 1, n->child(j));
+            sib->count = static_cast<unsigned short>(n->count - mid - 1);
+
+            shift_right(p, pos);
+            move_value(p, pos, n, mid);
+            set_child(p, pos + 1, sib);
+            ++p->count;
+            n->count = static_cast<unsigned short>(mid);
+        }
+
+        /**
+         *  在叶节点位置pos处以args构造新元素
+         *  @return  指向新元素的迭代器
+         */
+        template <class... Args>
+        iterator insert_at(iterator pos, Args&&... args)
+        {
+            if (root == nullptr) {
+                root = leftmost = rightmost = new_leaf(nullptr);
+                pos = iterator(root, 0);
+            }
+            node_type* n = pos.node;
+            int i = pos.position;
+            if (n->count == node_values) {
+                split(n);
+                const int mid = node_values / 2;
+                if (i > mid) {
+                    n = n->parent->child(n->position + 1);
+                    i -= mid + 1;
+                }
+                update_extremes();
+            }
+            shift_right(n, i);
+            try {
+                STL::construct(n->value(i), std::forward<Args>(args)...);
+            } catch(...) {
+                ++n->count;
+                shift_left(n, i);
+                --n->count;
+                if (node_count == 0) {
+                    free_node(root);
+                    root = nullptr;
+                    update_extremes();
+                }
+                throw;
+            }
+            ++n->count;
+            ++node_count;
+            return iterator(n, i);
+        }
+
+        // 节点n中第一个键值不小于k的元素下标
+        template <class K>
+        int lower_index(const node_type* n, const K& k) const
+        {
+            int lo = 0, hi = n->count;
+            while (lo < hi) {
+                const int mid = (lo + hi) / 2;
+                if (key_compare(get_key(*n->value(mid)), k))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        // 节点n中第一个键值大于k的元素下标
+        template <class K>
+        int upper_index(const node_type* n, const K& k) const
+        {
+            int lo = 0, hi = n->count;
+            while (lo < hi) {
+                const int mid = (lo + hi) / 2;
+                if (key_compare(k, get_key(*n->value(mid))))
+                    hi = mid;
+                else
+                    lo = mid + 1;
+            }
+            return lo;
+        }
+
+        /**
+         *  键值不允许重复时为k寻找插入位置
+         *  @return  (位置, true)表示可在该叶节点位置插入；(位置, false)表示该位置的元素键值与k相同
+         */
+        pair<iterator, bool> get_insert_unique_pos(const key_type& k)
+        {
+            node_type* n = root;
+            if (n == nullptr)
+                return pair<iterator, bool>(iterator(), true);
+            for ( ; ; ) {
+                const int i = lower_index(n, k);
+                if (i < n->count && !key_compare(k, get_key(*n->value(i))))
+                    return pair<iterator, bool>(iterator(n, i), false);
+                if (n->leaf)
+                    return pair<iterator, bool>(iterator(n, i), true);
+                n = n->child(i);
+            }
+        }
+
+        // 键值允许重复时为k寻找插入位置，插在键值相同的元素之后
+        iterator get_insert_equal_pos(const key_type& k)
+        {
+            node_type* n = root;
+            if (n == nullptr)
+                return iterator();
+            for ( ; ; ) {
+                const int i = upper_index(n, k);
+                if (n->leaf)
+                    return iterator(n, i);
+                n = n->child(i);
+            }
+        }
+
+        template <class... Args>
+        pair<iterator, bool> emplace_unique_key(const key_type& k, Args&&... args)
+        {
+            pair<iterator, bool> pos = get_insert_unique_pos(k);
+            if (!pos.second)
+                return pos;
+            return pair<iterator, bool>(insert_at(pos.first, std::forward<Args>(args)...), true);
+        }
+
+    private:
+        // 删除
+
+        // 从p的第i + 1个孩子借一个元素给第i个孩子，track随元素移动
+        void rotate_left(node_type* p, int i, iterator& track)
+        {
+            node_type* l = p->child(i);
+            node_type* r = p->child(i + 1);
+            const int lc = l->count;
+            move_value(l, lc, p, i);
+            move_value(p, i, r, 0);
+            if (!l->leaf) {
+                set_child(l, lc + 1, r->child(0));
+                set_child(r, 0, r->child(1));   // shift_left只移动第1个以后的孩子
+            }
+            shift_left(r, 0);
+            ++l->count;
+            --r->count;
+            if (track.node == p && track.position == i)
+                track = iterator(l, lc);
+            else if (track.node == r)
+                track = track.position == 0 ? iterator(p, i) : iterator(r, track.position - 1);
+        }
+
+        // 从p的第i个孩子借一个元素给第i + 1个孩子，track随元素移动
+        void rotate_right(node_type* p, int i, iterator& track)
+        {
+            node_type* l = p->child(i);
+            node_type* r = p->child(i + 1);
+            const int lc = l->count;
+            shift_right(r, 0);
+            move_value(r, 0, p, i);
+            move_value(p, i, l, lc - 1);
+            if (!l->leaf) {
+                set_child(r, 1, r->child(0));   // shift_right只移动第1个以后的孩子
+                set_child(r, 0, l->child(lc));
+            }
+            --l->count;
+            ++r->count;
+            if (track.node == r)
+                track.position += 1;
+            else if (track.node == p && track.position == i)
+                track = iterator(r, 0);
+            else if (track.node == l && track.position == lc - 1)
+                track = iterator(p, i);
+            else if (track.node == l && track.position == lc)
+                track = iterator(r, 0);
+        }
+
+        // 将p的第i + 1个孩子与第i个元素一起并入第i个孩子，track随元素移动
+        void merge(node_type* p, int i, iterator& track)
+        {
+            node_type* l = p->child(i);
+            node_type* r = p->child(i + 1);
+            const int lc = l->count, rc = r->count;
+            move_value(l, lc, p, i);
+            for (int j = 0; j < rc; ++j)
+                move_value(l, lc + 1 + j, r, j);
+            if (!l->leaf)
+                for (int j = 0; j <= rc; ++j)
+                    set_child(l, lc + 1 + j, r->child(j));
+            l->count = static_cast<unsigned short>(lc + 1 + rc);
+            shift_left(p, i);
+            --p->count;
+            free_node(r);
+            if (track.node == r)
+                track = iterator(l, lc + 1 + track.position);
+            else if (track.node == p && track.position == i)
+                track = iterator(l, lc);
+            else if (track.node == p && track.position > i)
+                track.position -= 1;
+        }
+
+        // 自节点n向上修复元素不足的节点
+        void rebalance(node_type* n, iterator& track)
+        {
+            while (n != root && n->count < min_values) {
+                node_type* p = n->parent;
+                const int pos = n->position;
+                if (pos < p->count && p->child(pos + 1)->count > min_values) {
+                    rotate_left(p, pos, track);
+                    return;
+                }
+                if (pos > 0 && p->child(pos - 1)->count > min_values) {
+                    rotate_right(p, pos - 1, track);
+                    return;
+                }
+                merge(p, pos < p->count ? pos : pos - 1, track);
+                n = p;
+            }
+            if (root->count == 0) {
+                node_type* old = root;
+                if (root->leaf) {
+                    root = nullptr;
+                } else {
+                    root = root->child(0);
+                    root->parent = nullptr;
+                    root->position = 0;
+                }
+                if (track.node == old)
+                    track = iterator();
+                free_node(old);
+            }
+        }
+
+        // track为（节点，元素个数）时，表示该节点之后的第一个元素
+        iterator normalize(iterator track)
+        {
+            if (track.node == nullptr)
+                return end();
+            while (track.position == track.node->count && track.node->parent) {
+                track.position = track.node->position;
+                track.node = track.node->parent;
+            }
+            return track.position == track.node->count ? end() : track;
+        }
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         */
+        explicit btree(const Compare& cmp = Compare())
+        : root(nullptr), leftmost(nullptr), rightmost(nullptr), node_count(0), key_compare(cmp) { }
+
+        /**
+         *  @brief  copy constructor
+         */
+        btree(const btree& x)
+        : root(nullptr), leftmost(nullptr), rightmost(nullptr), node_count(0), key_compare(x.key_compare)
+        {
+            if (x.root) {
+                root = clone_subtree(x.root, nullptr);
+                node_count = x.node_count;
+                update_extremes();
+            }
+        }
+
+        /**
+         *  @brief  move constructor
+         */
+        btree(btree&& x)
+        : root(x.root), leftmost(x.leftmost), rightmost(x.rightmost), node_count(x.node_count),
+          key_compare(x.key_compare)
+        {
+            x.root = x.leftmost = x.rightmost = nullptr;
+            x.node_count = 0;
+        }
+
+        /**
+         *  @brief  copy assignment
+         */
+        btree& operator=(const btree& x)
+        {
+            if (this != &x) {
+                btree tmp(x);
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        btree& operator=(btree&& x)
+        {
+            if (this != &x) {
+                clear();
+                swap(x);
+            }
+            return *this;
+        }
+
+        /**
+         *  @brief  destructor
+         */
+        ~btree() { clear(); }
+
+    public:
+        Compare key_comp() const { return key_compare; }
+
+        iterator begin() noexcept { return iterator(leftmost, 0); }
+        const_iterator begin() const noexcept { return const_iterator(leftmost, 0); }
+        iterator end() noexcept { return iterator(rightmost, rightmost ? rightmost->count : 0); }
+        const_iterator end() const noexcept { return const_iterator(rightmost, rightmost ? rightmost->count : 0); }
+
+        bool empty() const noexcept { return node_count == 0; }
+        size_type size() const noexcept { return node_count; }
+        size_type max_size() const noexcept { return size_type(-1); }
+
+        /**
+         *  @brief  树高，空树为0
+         */
+        size_type height() const noexcept
+        {
+            size_type h = 0;
+            for (const node_type* n = root; n; n = n->leaf ? nullptr : n->child(0))
+                ++h;
+            return h;
+        }
+
+    public:
+        // 修改器
+
+        void clear()
+        {
+            if (root) {
+                destroy_subtree(root);
+                root = leftmost = rightmost = nullptr;
+                node_count = 0;
+            }
+        }
+
+        pair<iterator, bool> insert_unique(const value_type& v)
+        { return emplace_unique_key(get_key(v), v); }
+
+        pair<iterator, bool> insert_unique(value_type&& v)
+        { return emplace_unique_key(get_key(v), std::move(v)); }
+
+        iterator insert_equal(const value_type& v)
+        { return insert_at(get_insert_equal_pos(get_key(v)), v); }
+
+        iterator insert_equal(value_type&& v)
+        {
+            iterator pos = get_insert_equal_pos(get_key(v));
+            return insert_at(pos, std::move(v));
+        }
+
+        template <class InputIterator>
+        void insert_unique(InputIterator first, InputIterator last)
+        {
+            for ( ; first != last; ++first)
+                insert_unique(*first);
+        }
+
+        template <class InputIterator>
+        void insert_equal(InputIterator first, InputIterator last)
+        {
+            for ( ; first != last; ++first)
+                insert_equal(*first);
+        }
+
+        /**
+         *  @brief  以args构造元素并插入，键值不允许重复
+         *
+         *  唯一实参即为元素值、或map形式的元素以键值为首个实参时先查找，键值已存在时不构造元素
+         */
+        template <class... Args>
+        pair<iterator, bool> emplace_unique(Args&&... args)
+        {
+            return emplace_unique_aux(STL::emplace_has_key<key_type, value_type, KeyOfValue, Args...>(),
+                                      std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        iterator emplace_equal(Args&&... args)
+        { return insert_equal(value_type(std::forward<Args>(args)...)); }
+
+        /**
+         *  @brief  若键值k不存在，则插入以k和args原地构造的元素，只用于map
+         */
+        template <class... Args>
+        pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        {
+            return emplace_unique_key(k, std::piecewise_construct, std::forward_as_tuple(k),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        template <class... Args>
+        pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+        {
+            pair<iterator, bool> pos = get_insert_unique_pos(k);
+            if (!pos.second)
+                return pos;
+            return pair<iterator, bool>(insert_at(pos.first, std::piecewise_construct,
+                                                  std::forward_as_tuple(std::move(k)),
+                                                  std::forward_as_tuple(std::forward<Args>(args)...)), true);
+        }
+
+        /**
+         *  @brief  若键值k不存在，则插入(k, obj)，否则将obj赋值给已有元素的实值，只用于map
+         */
+        template <class M>
+        pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        {
+            pair<iterator, bool> p = try_emplace(k, std::forward<M>(obj));
+            if (!p.second)
+                p.first->second = std::forward<M>(obj);
+            return p;
+        }
+
+    private:
+        template <class Arg, class... Args>
+        pair<iterator, bool> emplace_unique_aux(STL::true_type, Arg&& arg, Args&&... args)
+        {
+            using is_key = STL::integral_constant<bool, !STL::emplace_is_value<value_type, Arg, Args...>::value>;
+            const key_type& k = emplace_key(arg, is_key());
+            return emplace_unique_key(k, std::forward<Arg>(arg), std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        pair<iterator, bool> emplace_unique_aux(STL::false_type, Args&&... args)
+        { return insert_unique(value_type(std::forward<Args>(args)...)); }
+
+        const key_type& emplace_key(const key_type& k, STL::true_type) const { return k; }
+        const key_type& emplace_key(const value_type& v, STL::false_type) const { return get_key(v); }
+
+    public:
+        /**
+         *  @brief  移除pos所指元素
+         *  @return  下一个元素的迭代器
+         *
+         *  内部节点的元素以其后继（右子树的最小元素，位于叶节点）替换，再从叶节点删除
+         *  叶节点元素不足时向兄弟借元素或与兄弟合并，并沿路径向上修复
+         */
+        iterator erase(const_iterator pos)
+        {
+            node_type* n = pos.node;
+            const int i = pos.position;
+            node_type* leaf = n;
+            STL::destroy(n->value(i));
+            if (n->leaf) {
+                shift_left(n, i);
+                --n->count;
+            } else {
+                leaf = n->child(i + 1);
+                while (!leaf->leaf)
+                    leaf = leaf->child(0);
+                move_value(n, i, leaf, 0);
+                shift_left(leaf, 0);
+                --leaf->count;
+            }
+            --node_count;
+            iterator track(n, i);
+            if (leaf->count < min_values || root->count == 0) {
+                rebalance(leaf, track);
+                update_extremes();
+            }
+            return normalize(track);
+        }
+
+        iterator erase(iterator pos)
+        { return erase(const_iterator(pos)); }
+
+        /**
+         *  @brief  移除[first, last)中的元素
+         *
+         *  删除会移动元素，last随之失效，因此先数出个数
+         */
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            if (first == begin() && last == end()) {
+                clear();
+                return end();
+            }
+            size_type n = STL::distance(first, last);
+            iterator it = first.M_const_cast();
+            for ( ; n; --n)
+                it = erase(it);
+            return it;
+        }
+
+        /**
+         *  @brief  移除键值等于k的所有元素
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        {
+            pair<iterator, iterator> r = equal_range(k);
+            const size_type n = STL::distance(r.first, r.second);
+            iterator it = r.first;
+            for (size_type i = 0; i < n; ++i)
+                it = erase(it);
+            return n;
+        }
+
+        void swap(btree& x)
+        {
+            STL::swap(root, x.root);
+            STL::swap(leftmost, x.leftmost);
+            STL::swap(rightmost, x.rightmost);
+            STL::swap(node_count, x.node_count);
+            STL::swap(key_compare, x.key_compare);
+        }
+
+    private:
+        template <class K>
+        iterator M_lower_bound(const K& k) const
+        {
+            iterator res(rightmost, rightmost ? rightmost->count : 0);
+            for (node_type* n = root; n; ) {
+                const int i = lower_index(n, k);
+                if (i < n->count)
+                    res = iterator(n, i);
+                if (n->leaf)
+                    break;
+                n = n->child(i);
+            }
+            return res;
+        }
+
+        template <class K>
+        iterator M_upper_bound(const K& k) const
+        {
+            iterator res(rightmost, rightmost ? rightmost->count : 0);
+            for (node_type* n = root; n; ) {
+                const int i = upper_index(n, k);
+                if (i < n->count)
+                    res = iterator(n, i);
+                if (n->leaf)
+                    break;
+                n = n->child(i);
+            }
+            return res;
+        }
+
+        // 在某个节点中找到键值等于k的元素即可返回，不必下降到叶节点
+        template <class K>
+        iterator M_find(const K& k) const
+        {
+            for (node_type* n = root; n; ) {
+                const int i = lower_index(n, k);
+                if (i < n->count && !key_compare(k, get_key(*n->value(i))))
+                    return iterator(n, i);
+                if (n->leaf)
+                    break;
+                n = n->child(i);
+            }
+            return iterator(rightmost, rightmost ? rightmost->count : 0);
+        }
+
+    public:
+        // 查找，K为key_type或（Compare声明了is_transparent时）可与之比较的任意类型
+
+        /**
+         *  @brief  查找键值等于k的元素，键值允许重复时返回其中任意一个
+         */
+        template <class K>
+        iterator find(const K& k) { return M_find(k); }
+
+        template <class K>
+        const_iterator find(const K& k) const { return M_find(k); }
+
+        template <class K>
+        size_type count(const K& k) const
+        {
+            pair<const_iterator, const_iterator> r = equal_range(k);
+            return STL::distance(r.first, r.second);
+        }
+
+        template <class K>
+        iterator lower_bound(const K& k) { return M_lower_bound(k); }
+
+        template <class K>
+        const_iterator lower_bound(const K& k) const { return M_lower_bound(k); }
+
+        template <class K>
+        iterator upper_bound(const K& k) { return M_upper_bound(k); }
+
+        template <class K>
+        const_iterator upper_bound(const K& k) const { return M_upper_bound(k); }
+
+        template <class K>
+        pair<iterator, iterator> equal_range(const K& k)
+        { return pair<iterator, iterator>(M_lower_bound(k), M_upper_bound(k)); }
+
+        template <class K>
+        pair<const_iterator, const_iterator> equal_range(const K& k) const
+        { return pair<const_iterator, const_iterator>(M_lower_bound(k), M_upper_bound(k)); }
+
+    public:
+        /**
+         *  @brief  检查B树的性质：节点内有序、父子间有序、非根节点元素个数不少于min_values、
+         *          所有叶节点深度相同、parent/position正确、元素总数正确
+         */
+        bool btree_verify() const
+        {
+            if (root == nullptr)
+                return node_count == 0 && leftmost == nullptr && rightmost == nullptr;
+            if (root->parent != nullptr)
+                return false;
+            int leaf_depth = -1;
+            size_type total = 0;
+            if (!verify_aux(root, nullptr, nullptr, 0, leaf_depth, total))
+                return false;
+            const node_type* l = root;
+            const node_type* r = root;
+            while (!l->leaf)
+                l = l->child(0);
+            while (!r->leaf)
+                r = r->child(r->count);
+            return total == node_count && l == leftmost && r == rightmost;
+        }
+
+    private:
+        // lo、hi为子树元素的下界与上界（可为nullptr）
+        bool verify_aux(const node_type* n, const value_type* lo, const value_type* hi,
+                        int depth, int& leaf_depth, size_type& total) const
+        {
+            if (n->count == 0 || n->count > node_values || (n != root && n->count < min_values))
+                return false;
+            total += n->count;
+            for (int i = 0; i < n->count; ++i) {
+                const key_type& k = get_key(*n->value(i));
+                if (i > 0 && key_compare(k, get_key(*n->value(i - 1))))
+                    return false;
+                if ((lo && key_compare(k, get_key(*lo))) || (hi && key_compare(get_key(*hi), k)))
+                    return false;
+            }
+            if (n->leaf) {
+                if (leaf_depth == -1)
+                    leaf_depth = depth;
+                return leaf_depth == depth;
+            }
+            for (int i = 0; i <= n->count; ++i) {
+                const node_type* c = n->child(i);
+                if (c->parent != n || c->position != i)
+                    return false;
+                if (!verify_aux(c, i == 0 ? lo : n->value(i - 1), i == n->count ? hi : n->value(i),
+                                depth + 1, leaf_depth, total))
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+    inline bool operator==(const btree<Key, Value, KeyOfValue, Compare, Alloc>& x,
+                           const btree<Key, Value, KeyOfValue, Compare, Alloc>& y)
+    { return x.size() == y.size() && STL::equal(x.begin(), x.end(), y.begin()); }
+
+    template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+    inline bool operator!=(const btree<Key, Value, KeyOfValue, Compare, Alloc>& x,
+                           const btree<Key, Value, KeyOfValue, Compare, Alloc>& y)
+    { return !(x == y); }
+
+} /* namespace STL */
+
+#endif
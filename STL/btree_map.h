@@ -0,0 +1,240 @@
+#ifndef TINYSTL_BTREE_MAP_H_
+#define TINYSTL_BTREE_MAP_H_
+
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+
+#include "btree.h"
+
+namespace STL
+{
+
+    /**
+     *  以B树为底层容器的map，接口与map相同
+     *  任何插入或删除都使所有迭代器与元素的引用失效（erase返回的迭代器除外）
+     */
+    template <class Key, class T, class Compare = std::less<Key>,
+              class Alloc = STL::pool_alloc>
+    class btree_map
+    {
+    public:
+        using key_type      = Key;
+        using mapped_type   = T;
+        using value_type    = pair<const Key, T>;
+        using key_compare   = Compare;
+
+    private:
+        using Rep_type  = STL::btree<key_type, value_type, std::_Select1st<value_type>, key_compare, Alloc>;
+        Rep_type t;
+
+    public:
+        using pointer           = typename Rep_type::pointer;
+        using const_pointer     = typename Rep_type::const_pointer;
+        using reference         = typename Rep_type::reference;
+        using const_reference   = typename Rep_type::const_reference;
+        using iterator          = typename Rep_type::iterator;
+        using const_iterator    = typename Rep_type::const_iterator;
+        using size_type         = typename Rep_type::size_type;
+        using difference_type   = typename Rep_type::difference_type;
+
+    private:
+        // Compare声明了is_transparent时，查找接口接受任意可与key_type比较的类型K
+        template <class K>
+        using transparent_key = typename std::enable_if<STL::is_transparent<Compare>::value, K>::type;
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         */
+        btree_map() : t() { }
+
+        explicit btree_map(const Compare& cmp) : t(cmp) { }
+
+        btree_map(std::initializer_list<value_type> l, const Compare& cmp = Compare())
+        : t(cmp) { t.insert_unique(l.begin(), l.end()); }
+
+        template <class InputIterator>
+        btree_map(InputIterator first, InputIterator last, const Compare& cmp = Compare())
+        : t(cmp) { t.insert_unique(first, last); }
+
+        btree_map(const btree_map& x) : t(x.t) { }
+        btree_map(btree_map&& x) : t(std::move(x.t)) { }
+
+        btree_map& operator=(const btree_map& x)
+        {
+            t = x.t;
+            return *this;
+        }
+
+        btree_map& operator=(btree_map&&) = default;
+
+    public:
+        // 元素访问
+        mapped_type& operator[](const key_type& k)
+        { return t.try_emplace(k).first->second; }
+
+        mapped_type& operator[](key_type&& k)
+        { return t.try_emplace(std::move(k)).first->second; }
+
+        mapped_type& at(const key_type& k)
+        {
+            iterator it = t.find(k);
+            if (it == t.end())
+                throw std::out_of_range("btree_map::at");
+            return it->second;
+        }
+
+        const mapped_type& at(const key_type& k) const
+        {
+            const_iterator it = t.find(k);
+            if (it == t.end())
+                throw std::out_of_range("btree_map::at");
+            return it->second;
+        }
+
+    public:
+        // 访问器
+        key_compare key_comp() const { return t.key_comp(); }
+
+        iterator begin() noexcept { return t.begin(); }
+        const_iterator begin() const noexcept { return t.begin(); }
+        const_iterator cbegin() const noexcept { return t.begin(); }
+        iterator end() noexcept { return t.end(); }
+        const_iterator end() const noexcept { return t.end(); }
+        const_iterator cend() const noexcept { return t.end(); }
+
+        bool empty() const noexcept { return t.empty(); }
+        size_type size() const noexcept { return t.size(); }
+        size_type max_size() const noexcept { return t.max_size(); }
+
+    public:
+        // 修改器
+        void clear() noexcept { t.clear(); }
+
+        pair<iterator, bool> insert(const value_type& x)
+        { return t.insert_unique(x); }
+
+        pair<iterator, bool> insert(value_type&& x)
+        { return t.insert_unique(std::move(x)); }
+
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator last)
+        { t.insert_unique(first, last); }
+
+        void insert(std::initializer_list<value_type> l)
+        { t.insert_unique(l.begin(), l.end()); }
+
+        template <class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        { return t.emplace_unique(std::forward<Args>(args)...); }
+
+        template <class... Args>
+        pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        { return t.try_emplace(k, std::forward<Args>(args)...); }
+
+        template <class... Args>
+        pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+        { return t.try_emplace(std::move(k), std::forward<Args>(args)...); }
+
+        template <class M>
+        pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        { return t.insert_or_assign(k, std::forward<M>(obj)); }
+
+        /**
+         *  @brief  移除位于pos的元素
+         *  @return  下一个元素的迭代器
+         */
+        iterator erase(const_iterator pos)
+        { return t.erase(pos); }
+
+        iterator erase(iterator pos)
+        { return t.erase(pos); }
+
+        iterator erase(const_iterator first, const_iterator last)
+        { return t.erase(first, last); }
+
+        size_type erase(const key_type& x)
+        { return t.erase(x); }
+
+        void swap(btree_map& x) noexcept { t.swap(x.t); }
+
+    public:
+        // 查找
+        size_type count(const key_type& k) const
+        { return t.find(k) == t.end() ? 0 : 1; }
+
+        template <class K, class = transparent_key<K>>
+        size_type count(const K& k) const
+        { return t.find(k) == t.end() ? 0 : 1; }
+
+        iterator find(const key_type& k)
+        { return t.find(k); }
+
+        const_iterator find(const key_type& k) const
+        { return t.find(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator find(const K& k)
+        { return t.find(k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator find(const K& k) const
+        { return t.find(k); }
+
+        pair<iterator, iterator> equal_range(const key_type& k)
+        { return t.equal_range(k); }
+
+        pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+        { return t.equal_range(k); }
+
+        iterator lower_bound(const key_type& k)
+        { return t.lower_bound(k); }
+
+        const_iterator lower_bound(const key_type& k) const
+        { return t.lower_bound(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator lower_bound(const K& k)
+        { return t.lower_bound(k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator lower_bound(const K& k) const
+        { return t.lower_bound(k); }
+
+        iterator upper_bound(const key_type& k)
+        { return t.upper_bound(k); }
+
+        const_iterator upper_bound(const key_type& k) const
+        { return t.upper_bound(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator upper_bound(const K& k)
+        { return t.upper_bound(k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator upper_bound(const K& k) const
+        { return t.upper_bound(k); }
+
+    public:
+        template <class _Key, class _T, class _Compare, class _Alloc>
+        friend bool operator==(const btree_map<_Key, _T, _Compare, _Alloc>& x,
+                               const btree_map<_Key, _T, _Compare, _Alloc>& y);
+    };
+
+    template <class Key, class T, class Compare, class Alloc>
+    inline bool operator==(const btree_map<Key, T, Compare, Alloc>& x,
+                           const btree_map<Key, T, Compare, Alloc>& y)
+    { return x.t == y.t; }
+
+    template <class Key, class T, class Compare, class Alloc>
+    inline bool operator!=(const btree_map<Key, T, Compare, Alloc>& x,
+                           const btree_map<Key, T, Compare, Alloc>& y)
+    { return !(x == y); }
+
+} /* namespace STL */
+
+#endif
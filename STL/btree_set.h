@@ -0,0 +1,189 @@
+#ifndef TINYSTL_BTREE_SET_H_
+#define TINYSTL_BTREE_SET_H_
+
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+
+#include "btree.h"
+
+namespace STL
+{
+
+    /**
+     *  以B树为底层容器的set，接口与set相同
+     *  任何插入或删除都使所有迭代器失效（erase返回的迭代器除外）
+     */
+    template <class Key, class Compare = std::less<Key>,
+              class Alloc = STL::pool_alloc>
+    class btree_set
+    {
+    public:
+        using key_type      = Key;
+        using value_type    = Key;
+        using key_compare   = Compare;
+        using value_compare = Compare;
+
+    private:
+        using Rep_type  = STL::btree<key_type, value_type, std::_Identity<value_type>, key_compare, Alloc>;
+        Rep_type t;
+
+    public:
+        using pointer           = typename Rep_type::pointer;
+        using const_pointer     = typename Rep_type::const_pointer;
+        using reference         = typename Rep_type::reference;
+        using const_reference   = typename Rep_type::const_reference;
+        // set的迭代器无法执行写入操作
+        using iterator          = typename Rep_type::const_iterator;
+        using const_iterator    = typename Rep_type::const_iterator;
+        using size_type         = typename Rep_type::size_type;
+        using difference_type   = typename Rep_type::difference_type;
+
+    private:
+        // Compare声明了is_transparent时，查找接口接受任意可与key_type比较的类型K
+        template <class K>
+        using transparent_key = typename std::enable_if<STL::is_transparent<Compare>::value, K>::type;
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         */
+        btree_set() : t() { }
+
+        explicit btree_set(const Compare& cmp) : t(cmp) { }
+
+        btree_set(std::initializer_list<value_type> l, const Compare& cmp = Compare())
+        : t(cmp) { t.insert_unique(l.begin(), l.end()); }
+
+        template <class InputIterator>
+        btree_set(InputIterator first, InputIterator last, const Compare& cmp = Compare())
+        : t(cmp) { t.insert_unique(first, last); }
+
+        btree_set(const btree_set& x) : t(x.t) { }
+        btree_set(btree_set&& x) : t(std::move(x.t)) { }
+
+        btree_set& operator=(const btree_set& x)
+        {
+            t = x.t;
+            return *this;
+        }
+
+        btree_set& operator=(btree_set&&) = default;
+
+    public:
+        // 访问器
+        key_compare key_comp() const { return t.key_comp(); }
+        value_compare value_comp() const { return t.key_comp(); }
+
+        iterator begin() const noexcept { return t.begin(); }
+        const_iterator cbegin() const noexcept { return t.begin(); }
+        iterator end() const noexcept { return t.end(); }
+        const_iterator cend() const noexcept { return t.end(); }
+
+        bool empty() const noexcept { return t.empty(); }
+        size_type size() const noexcept { return t.size(); }
+        size_type max_size() const noexcept { return t.max_size(); }
+
+    public:
+        // 修改器
+        void clear() noexcept { t.clear(); }
+
+        pair<iterator, bool> insert(const value_type& x)
+        {
+            pair<typename Rep_type::iterator, bool> p = t.insert_unique(x);
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
+        pair<iterator, bool> insert(value_type&& x)
+        {
+            pair<typename Rep_type::iterator, bool> p = t.insert_unique(std::move(x));
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator last)
+        { t.insert_unique(first, last); }
+
+        void insert(std::initializer_list<value_type> l)
+        { t.insert_unique(l.begin(), l.end()); }
+
+        template <class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        {
+            pair<typename Rep_type::iterator, bool> p = t.emplace_unique(std::forward<Args>(args)...);
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
+        /**
+         *  @brief  移除位于pos的元素
+         *  @return  下一个元素的迭代器
+         */
+        iterator erase(const_iterator pos)
+        { return t.erase(pos); }
+
+        iterator erase(const_iterator first, const_iterator last)
+        { return t.erase(first, last); }
+
+        size_type erase(const key_type& x)
+        { return t.erase(x); }
+
+        void swap(btree_set& x) noexcept { t.swap(x.t); }
+
+    public:
+        // 查找
+        size_type count(const key_type& k) const
+        { return t.find(k) == t.end() ? 0 : 1; }
+
+        template <class K, class = transparent_key<K>>
+        size_type count(const K& k) const
+        { return t.find(k) == t.end() ? 0 : 1; }
+
+        iterator find(const key_type& k) const
+        { return t.find(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator find(const K& k) const
+        { return t.find(k); }
+
+        pair<iterator, iterator> equal_range(const key_type& k) const
+        { return t.equal_range(k); }
+
+        template <class K, class = transparent_key<K>>
+        pair<iterator, iterator> equal_range(const K& k) const
+        { return t.equal_range(k); }
+
+        iterator lower_bound(const key_type& k) const
+        { return t.lower_bound(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator lower_bound(const K& k) const
+        { return t.lower_bound(k); }
+
+        iterator upper_bound(const key_type& k) const
+        { return t.upper_bound(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator upper_bound(const K& k) const
+        { return t.upper_bound(k); }
+
+    public:
+        template <class _Key, class _Compare, class _Alloc>
+        friend bool operator==(const btree_set<_Key, _Compare, _Alloc>& x,
+                               const btree_set<_Key, _Compare, _Alloc>& y);
+    };
+
+    template <class Key, class Compare, class Alloc>
+    inline bool operator==(const btree_set<Key, Compare, Alloc>& x,
+                           const btree_set<Key, Compare, Alloc>& y)
+    { return x.t == y.t; }
+
+    template <class Key, class Compare, class Alloc>
+    inline bool operator!=(const btree_set<Key, Compare, Alloc>& x,
+                           const btree_set<Key, Compare, Alloc>& y)
+    { return !(x == y); }
+
+} /* namespace STL */
+
+#endif
@@ -0,0 +1,608 @@
+#ifndef TINYSTL_COMPACT_HASHTABLE_H_
+#define TINYSTL_COMPACT_HASHTABLE_H_
+
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+#include "hashtable.h"  // for prefetch()
+#include "iterator.h"
+#include "type_traits.h"
+
+namespace STL
+{
+
+    // 槽位状态，compact_sentinel位于状态数组末尾，使迭代器无需记录表尾
+    enum { compact_empty = 0, compact_deleted = 1, compact_full = 2, compact_sentinel = 3 };
+
+    template <class T, class Ref, class Ptr>
+    struct compact_hashtable_iterator
+    {
+        using iterator          = compact_hashtable_iterator<T, T&, T*>;
+        using const_iterator    = compact_hashtable_iterator<T, const T&, const T*>;
+        using Self              = compact_hashtable_iterator;
+
+        using iterator_category = STL::forward_iterator_tag;
+        using value_type        = T;
+        using pointer           = Ptr;
+        using reference         = Ref;
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+
+        const unsigned char*    ctrl;   // 当前槽位的状态
+        T*                      slot;   // 当前槽位
+
+        compact_hashtable_iterator() noexcept : ctrl(nullptr), slot(nullptr) { }
+        compact_hashtable_iterator(const unsigned char* c, T* s) noexcept : ctrl(c), slot(s) { }
+        compact_hashtable_iterator(const iterator& x) noexcept : ctrl(x.ctrl), slot(x.slot) { }
+
+        iterator M_const_cast() const noexcept { return iterator(ctrl, slot); }
+
+        reference operator*() const noexcept { return *slot; }
+        pointer operator->() const noexcept { return slot; }
+
+        // 跳过空槽位与已删除的槽位，停在下一个元素或表尾哨兵上
+        void skip() noexcept
+        {
+            while (*ctrl < compact_full) {
+                ++ctrl;
+                ++slot;
+            }
+        }
+
+        Self& operator++() noexcept
+        {
+            ++ctrl;
+            ++slot;
+            skip();
+            return *this;
+        }
+
+        Self operator++(int) noexcept
+        {
+            Self tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const Self& x) const noexcept { return ctrl == x.ctrl; }
+        bool operator!=(const Self& x) const noexcept { return ctrl != x.ctrl; }
+    };
+
+
+    /**
+     *  开放定址的紧凑hashtable，键值唯一
+     *
+     *  @tparam  Value      元素类型
+     *  @tparam  Key        键值类型，须可平凡复制且不超过8字节
+     *  @tparam  HashFcn    hash函数类型
+     *  @tparam  ExtractKey 从元素中取出Key的函数对象
+     *  @tparam  Equal      判断键值是否相同的函数对象
+     *  @tparam  Alloc      空间分配器
+     *
+     *  元素直接存放在槽位数组中，不分配节点，另以一个字节记录每个槽位的状态
+     *  槽位数为2的幂，以线性探测解决冲突，删除元素时留下墓碑（compact_deleted）
+     *  每个元素只占 sizeof(Value) + 1 字节再除以负载系数，适合存放大量小键值
+     *  插入导致重建table时，所有迭代器失效
+     */
+    template <class Value, class Key, class HashFcn,
+              class ExtractKey, class Equal, class Alloc = STL::pool_alloc>
+    class compact_hashtable
+    {
+        static_assert(std::is_trivially_copyable<Key>::value && sizeof(Key) <= 8,
+                      "compact_hashtable requires a trivially copyable key of at most 8 bytes");
+
+    public:
+        using value_type        = Value;
+        using key_type          = Key;
+        using key_equal         = Equal;
+        using hasher            = HashFcn;
+
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+        using pointer           = value_type*;
+        using const_pointer     = const value_type*;
+        using reference         = value_type&;
+        using const_reference   = const value_type&;
+
+        using iterator          = compact_hashtable_iterator<Value, Value&, Value*>;
+        using const_iterator    = compact_hashtable_iterator<Value, const Value&, const Value*>;
+
+    private:
+        using slot_allocator    = STL::allocator<Value, Alloc>;
+        using ctrl_allocator    = STL::allocator<unsigned char, Alloc>;
+
+        enum { min_capacity = 8 };
+
+        hasher          hash;
+        key_equal       equal;
+        ExtractKey      get_key;
+        Value*          slots;
+        unsigned char*  ctrl;           // capacity + 1个字节，最后一个为哨兵
+        size_type       capacity;       // 槽位数，为2的幂
+        size_type       num_elements;
+        size_type       num_deleted;    // 墓碑个数
+        float           max_load;       // 元素与墓碑个数之和超过 槽位数 * max_load 时重建table
+
+    private:
+        // 打散hash值，使低位也依赖于hash值的全部位，避免恒等hash函数在线性探测下聚集
+        static size_type mix(size_t h)
+        {
+            unsigned long long x = h;
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdull;
+            x ^= x >> 33;
+            return static_cast<size_type>(x);
+        }
+
+        template <class K>
+        size_type probe_start(const K& k) const
+        { return mix(hash(k)) & (capacity - 1); }
+
+        // 容纳n个元素所需的最少槽位数
+        size_type capacity_for(size_type n) const
+        {
+            size_type cap = min_capacity;
+            while (n > cap * max_load)
+                cap <<= 1;
+            return cap;
+        }
+
+        void allocate_table(size_type cap)
+        {
+            ctrl = ctrl_allocator::allocate(cap + 1);
+            try {
+                slots = slot_allocator::allocate(cap);
+            } catch(...) {
+                ctrl_allocator::deallocate(ctrl, cap + 1);
+                throw;
+            }
+            std::memset(ctrl, compact_empty, cap);
+            ctrl[cap] = compact_sentinel;
+            capacity = cap;
+            num_elements = 0;
+            num_deleted = 0;
+        }
+
+        void deallocate_table()
+        {
+            slot_allocator::deallocate(slots, capacity);
+            ctrl_allocator::deallocate(ctrl, capacity + 1);
+        }
+
+        void destroy_elements()
+        {
+            for (size_type i = 0; i < capacity; ++i)
+                if (ctrl[i] == compact_full)
+                    STL::destroy(slots + i);
+        }
+
+        // 查找键值为k的槽位，不存在时返回capacity
+        template <class K>
+        size_type find_slot(const K& k) const
+        {
+            const size_type mask = capacity - 1;
+            for (size_type i = probe_start(k); ; i = (i + 1) & mask) {
+                if (ctrl[i] == compact_empty)
+                    return capacity;
+                if (ctrl[i] == compact_full && equal(get_key(slots[i]), k))
+                    return i;
+            }
+        }
+
+        // 为键值k寻找槽位：若k已存在，返回(所在槽位, false)；否则返回(可插入的槽位, true)
+        // 可插入的槽位优先取探测路径上的第一个墓碑
+        template <class K>
+        pair<size_type, bool> find_insert_slot(const K& k) const
+        {
+            const size_type mask = capacity - 1;
+            size_type tombstone = capacity;
+            for (size_type i = probe_start(k); ; i = (i + 1) & mask) {
+                if (ctrl[i] == compact_empty)
+                    return pair<size_type, bool>(tombstone != capacity ? tombstone : i, true);
+                if (ctrl[i] == compact_deleted) {
+                    if (tombstone == capacity)
+                        tombstone = i;
+                } else if (equal(get_key(slots[i]), k))
+                    return pair<size_type, bool>(i, false);
+            }
+        }
+
+        // 重建table，将所有元素移入cap个槽位的新数组，同时清除墓碑
+        void rehash_aux(size_type cap)
+        {
+            Value* old_slots = slots;
+            unsigned char* old_ctrl = ctrl;
+            const size_type old_cap = capacity;
+            const size_type n = num_elements;
+            allocate_table(cap);
+            const size_type mask = cap - 1;
+            size_type i = 0;
+            try {
+                for ( ; i < old_cap; ++i) {
+                    if (old_ctrl[i] != compact_full)
+                        continue;
+                    size_type j = probe_start(get_key(old_slots[i]));
+                    while (ctrl[j] != compact_empty)
+                        j = (j + 1) & mask;
+                    STL::construct(slots + j, std::move(old_slots[i]));
+                    ctrl[j] = compact_full;
+                }
+            } catch(...) {
+                // 放弃新数组，恢复原数组
+                destroy_elements();
+                deallocate_table();
+                slots = old_slots;
+                ctrl = old_ctrl;
+                capacity = old_cap;
+                num_elements = n;
+                num_deleted = 0;
+                for (size_type k = 0; k < old_cap; ++k)
+                    if (old_ctrl[k] == compact_deleted)
+                        ++num_deleted;
+                throw;
+            }
+            num_elements = n;
+            for (i = 0; i < old_cap; ++i)
+                if (old_ctrl[i] == compact_full)
+                    STL::destroy(old_slots + i);
+            slot_allocator::deallocate(old_slots, old_cap);
+            ctrl_allocator::deallocate(old_ctrl, old_cap + 1);
+        }
+
+        // 插入一个新元素之前调用，元素与墓碑过多时重建table
+        // 墓碑占多数时只原地清理，否则槽位数加倍
+        void grow_for_insert()
+        {
+            if (num_elements + num_deleted + 1 <= capacity * max_load)
+                return;
+            if (num_elements + 1 <= capacity * max_load / 2)
+                rehash_aux(capacity);
+            else
+                rehash_aux(capacity << 1);
+        }
+
+        // 在槽位i上以args构造新元素
+        template <class... Args>
+        iterator construct_at(size_type i, Args&&... args)
+        {
+            STL::construct(slots + i, std::forward<Args>(args)...);
+            if (ctrl[i] == compact_deleted)
+                --num_deleted;
+            ctrl[i] = compact_full;
+            ++num_elements;
+            return iterator(ctrl + i, slots + i);
+        }
+
+        // 键值k不存在时以args构造新元素
+        template <class... Args>
+        pair<iterator, bool> emplace_key(const key_type& k, Args&&... args)
+        {
+            pair<size_type, bool> pos = find_insert_slot(k);
+            if (!pos.second)
+                return pair<iterator, bool>(iterator(ctrl + pos.first, slots + pos.first), false);
+            if (num_elements + num_deleted + 1 > capacity * max_load) {
+                grow_for_insert();
+                pos = find_insert_slot(k);
+            }
+            return pair<iterator, bool>(construct_at(pos.first, std::forward<Args>(args)...), true);
+        }
+
+        void copy_from(const compact_hashtable& ht)
+        {
+            allocate_table(ht.capacity);
+            size_type i = 0;
+            try {
+                for ( ; i < capacity; ++i) {
+                    if (ht.ctrl[i] == compact_full)
+                        STL::construct(slots + i, ht.slots[i]);
+                    ctrl[i] = ht.ctrl[i];
+                }
+            } catch(...) {
+                std::memset(ctrl + i, compact_empty, capacity - i);
+                destroy_elements();
+                deallocate_table();
+                throw;
+            }
+            num_elements = ht.num_elements;
+            num_deleted = ht.num_deleted;
+        }
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         *  @param  n  预计的元素个数
+         */
+        explicit compact_hashtable(size_type n = 0, const HashFcn& hf = HashFcn(), const Equal& eql = Equal())
+        : hash(hf), equal(eql), get_key(ExtractKey()), slots(nullptr), ctrl(nullptr),
+          capacity(0), num_elements(0), num_deleted(0), max_load(0.875f)
+        { allocate_table(capacity_for(n)); }
+
+        /**
+         *  @brief  copy constructor
+         */
+        compact_hashtable(const compact_hashtable& ht)
+        : hash(ht.hash), equal(ht.equal), get_key(ht.get_key), slots(nullptr), ctrl(nullptr),
+          capacity(0), num_elements(0), num_deleted(0), max_load(ht.max_load)
+        { copy_from(ht); }
+
+        /**
+         *  @brief  copy assignment
+         */
+        compact_hashtable& operator=(const compact_hashtable& ht)
+        {
+            if (this != &ht) {
+                compact_hashtable tmp(ht);
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        /**
+         *  @brief  destructor
+         */
+        ~compact_hashtable()
+        {
+            destroy_elements();
+            deallocate_table();
+        }
+
+    public:
+        // 迭代器
+        iterator begin()
+        {
+            iterator it(ctrl, slots);
+            it.skip();
+            return it;
+        }
+
+        const_iterator begin() const
+        {
+            const_iterator it(ctrl, slots);
+            it.skip();
+            return it;
+        }
+
+        const_iterator cbegin() const { return begin(); }
+
+        iterator end() { return iterator(ctrl + capacity, slots + capacity); }
+        const_iterator end() const { return const_iterator(ctrl + capacity, slots + capacity); }
+        const_iterator cend() const { return end(); }
+
+    public:
+        // 容量
+        size_type size() const noexcept { return num_elements; }
+        size_type max_size() const noexcept { return slot_allocator::max_size(); }
+        bool empty() const noexcept { return num_elements == 0; }
+
+    public:
+        // 修改器
+
+        /**
+         *  @brief  插入元素x，键值不允许重复
+         */
+        pair<iterator, bool> insert_unique(const value_type& x)
+        { return emplace_key(get_key(x), x); }
+
+        pair<iterator, bool> insert_unique(value_type&& x)
+        {
+            const key_type k = get_key(x);
+            return emplace_key(k, std::move(x));
+        }
+
+        template <class InputIterator>
+        void insert_unique(InputIterator first, InputIterator last)
+        {
+            for ( ; first != last; ++first)
+                insert_unique(*first);
+        }
+
+        /**
+         *  @brief  以args构造元素并插入，键值不允许重复
+         *
+         *  键值只能从构造好的元素中取得，因此先在栈上构造元素
+         */
+        template <class... Args>
+        pair<iterator, bool> emplace_unique(Args&&... args)
+        { return insert_unique(value_type(std::forward<Args>(args)...)); }
+
+        /**
+         *  @brief  若键值k不存在，则插入以(k, args)原地构造的元素，只用于map
+         */
+        template <class... Args>
+        pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        {
+            return emplace_key(k, std::piecewise_construct, std::forward_as_tuple(k),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        /**
+         *  @brief  若键值k不存在，则插入(k, obj)，否则将obj赋值给已有元素的实值，只用于map
+         */
+        template <class M>
+        pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        {
+            pair<iterator, bool> p = try_emplace(k, std::forward<M>(obj));
+            if (!p.second)
+                p.first->second = std::forward<M>(obj);
+            return p;
+        }
+
+        /**
+         *  @brief  移除pos所指元素
+         *  @return  下一个元素的迭代器
+         *
+         *  若下一个槽位为空，则任何探测路径都不会越过本槽位，可以直接置空而不留墓碑
+         */
+        iterator erase(const_iterator pos)
+        {
+            const size_type i = pos.slot - slots;
+            STL::destroy(slots + i);
+            if (ctrl[(i + 1) & (capacity - 1)] == compact_empty)
+                ctrl[i] = compact_empty;
+            else {
+                ctrl[i] = compact_deleted;
+                ++num_deleted;
+            }
+            --num_elements;
+            iterator next(ctrl + i, slots + i);
+            next.skip();
+            return next;
+        }
+
+        /**
+         *  @brief  移除键值等于k的元素
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        {
+            const size_type i = find_slot(k);
+            if (i == capacity)
+                return 0;
+            erase(const_iterator(ctrl + i, slots + i));
+            return 1;
+        }
+
+        /**
+         *  @brief  清除所有元素，保留槽位
+         */
+        void clear()
+        {
+            destroy_elements();
+            std::memset(ctrl, compact_empty, capacity);
+            num_elements = 0;
+            num_deleted = 0;
+        }
+
+        void swap(compact_hashtable& ht)
+        {
+            STL::swap(hash, ht.hash);
+            STL::swap(equal, ht.equal);
+            STL::swap(get_key, ht.get_key);
+            STL::swap(slots, ht.slots);
+            STL::swap(ctrl, ht.ctrl);
+            STL::swap(capacity, ht.capacity);
+            STL::swap(num_elements, ht.num_elements);
+            STL::swap(num_deleted, ht.num_deleted);
+            STL::swap(max_load, ht.max_load);
+        }
+
+    public:
+        // 查找
+
+        iterator find(const key_type& k)
+        {
+            const size_type i = find_slot(k);
+            return iterator(ctrl + i, slots + i);
+        }
+
+        const_iterator find(const key_type& k) const
+        {
+            const size_type i = find_slot(k);
+            return const_iterator(ctrl + i, slots + i);
+        }
+
+        size_type count(const key_type& k) const
+        { return find_slot(k) == capacity ? 0 : 1; }
+
+        /**
+         *  @brief  批量查找keys[0, n)，out[i]为keys[i]的查找结果，未找到时为end()
+         *
+         *  每次取batch_size个键值，先计算起始槽位并预取状态与槽位，再逐个探测
+         */
+        void find_batch(const key_type* keys, size_type n, iterator* out)
+        { find_batch_aux(keys, n, out); }
+
+        void find_batch(const key_type* keys, size_type n, const_iterator* out) const
+        { find_batch_aux(keys, n, out); }
+
+    private:
+        enum { batch_size = 16 };
+
+        template <class Iterator>
+        void find_batch_aux(const key_type* keys, size_type n, Iterator* out) const
+        {
+            size_type start[batch_size];
+            for (size_type base = 0; base < n; base += batch_size) {
+                const size_type m = n - base < size_type(batch_size) ? n - base : size_type(batch_size);
+                for (size_type i = 0; i < m; ++i) {
+                    start[i] = probe_start(keys[base + i]);
+                    prefetch(ctrl + start[i]);
+                    prefetch(slots + start[i]);
+                }
+                for (size_type i = 0; i < m; ++i) {
+                    const size_type mask = capacity - 1;
+                    size_type j = start[i];
+                    for ( ; ; j = (j + 1) & mask) {
+                        if (ctrl[j] == compact_empty) {
+                            j = capacity;
+                            break;
+                        }
+                        if (ctrl[j] == compact_full && equal(get_key(slots[j]), keys[base + i]))
+                            break;
+                    }
+                    out[base + i] = Iterator(ctrl + j, slots + j);
+                }
+            }
+        }
+
+    public:
+        // 桶接口与哈希策略，每个槽位视作一个桶
+
+        size_type bucket_count() const noexcept { return capacity; }
+
+        float load_factor() const noexcept
+        { return static_cast<float>(num_elements) / static_cast<float>(capacity); }
+
+        float max_load_factor() const noexcept { return max_load; }
+
+        /**
+         *  @brief  设置最大负载系数，z被限制在[1/8, 15/16]内
+         *
+         *  开放定址的探测依赖至少一个空槽位才能终止，因此z须小于1；z过小时所需的槽位数会溢出
+         */
+        void max_load_factor(float z)
+        {
+            if (!(z >= 0.125f))             // 同时处理NaN
+                z = 0.125f;
+            else if (z > 0.9375f)
+                z = 0.9375f;
+            max_load = z;
+            if (num_elements + num_deleted > capacity * max_load)
+                rehash_aux(capacity_for(num_elements));
+        }
+
+        /**
+         *  @brief  将槽位数重设为不小于n、且能容纳现有元素的2的幂，可以缩小
+         */
+        void rehash(size_type n)
+        {
+            size_type cap = capacity_for(num_elements);
+            while (cap < n)
+                cap <<= 1;
+            if (cap != capacity || num_deleted)
+                rehash_aux(cap);
+        }
+
+        /**
+         *  @brief  预留容纳n个元素的槽位
+         */
+        void reserve(size_type n)
+        {
+            if (capacity_for(n) > capacity)
+                rehash_aux(capacity_for(n));
+        }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return hash; }
+        key_equal key_eq() const { return equal; }
+    };
+
+} /* namespace STL */
+
+#endif
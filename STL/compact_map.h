@@ -0,0 +1,204 @@
+#ifndef TINYSTL_COMPACT_MAP_H_
+#define TINYSTL_COMPACT_MAP_H_
+
+#include "compact_hashtable.h"
+
+namespace STL
+{
+    /**
+     *  键值可平凡复制且不超过8字节时使用的紧凑unordered_map
+     *  元素直接存放在槽位数组中，不分配节点，插入导致重建table时所有迭代器与引用失效
+     */
+    template <class Key,
+              class T,
+              class HashFcn = std::hash<Key>,
+              class EqualKey = std::equal_to<Key>,
+              class Alloc = STL::pool_alloc>
+    class compact_map
+    {
+    private:
+        using Hashtable = STL::compact_hashtable<pair<const Key, T>, Key, HashFcn, std::_Select1st<pair<const Key, T>>, EqualKey, Alloc>;
+        Hashtable rep;
+
+    public:
+        using key_type          = typename Hashtable::key_type;
+        using data_type         = T;
+        using mapped_type       = T;
+        using value_type        = typename Hashtable::value_type;
+        using hasher            = typename Hashtable::hasher;
+        using key_equal         = typename Hashtable::key_equal;
+
+        using size_type         = typename Hashtable::size_type;
+        using difference_type   = typename Hashtable::difference_type;
+        using pointer           = typename Hashtable::pointer;
+        using const_pointer     = typename Hashtable::const_pointer;
+        using reference         = typename Hashtable::reference;
+        using const_reference   = typename Hashtable::const_reference;
+
+        using iterator          = typename Hashtable::iterator;
+        using const_iterator    = typename Hashtable::const_iterator;
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         *  @param  n  预计的元素个数
+         */
+        compact_map() : rep(0) { }
+        explicit compact_map(size_type n) : rep(n) { }
+        compact_map(size_type n, const hasher& hf) : rep(n, hf, key_equal()) { }
+        compact_map(size_type n, const hasher& hf, const key_equal& eql) : rep(n, hf, eql) { }
+
+        template <class InputIterator>
+        compact_map(InputIterator first, InputIterator last) : rep(0)
+        { rep.insert_unique(first, last); }
+
+        compact_map(std::initializer_list<value_type> l) : rep(l.size())
+        { rep.insert_unique(l.begin(), l.end()); }
+
+        /**
+         *  @brief  copy constructor
+         */
+        compact_map(const compact_map& x) : rep(x.rep) { }
+
+        /**
+         *  @brief  copy assignment
+         */
+        compact_map& operator=(const compact_map& x)
+        {
+            if (this != &x) {
+                rep = x.rep;
+            }
+            return *this;
+        }
+
+    public:
+        // 迭代器
+        iterator begin() noexcept { return rep.begin(); }
+        const_iterator begin() const noexcept { return rep.begin(); }
+        const_iterator cbegin() const noexcept { return rep.cbegin(); }
+        iterator end() noexcept { return rep.end(); }
+        const_iterator end() const noexcept { return rep.end(); }
+        const_iterator cend() const noexcept { return rep.cend(); }
+
+    public:
+        // 容量
+        size_type size() const noexcept { return rep.size(); }
+        size_type max_size() const noexcept { return rep.max_size(); }
+        bool empty() const noexcept { return rep.empty(); }
+
+    public:
+        // 元素访问
+
+        /**
+         *  @brief  访问键值为k的元素的实值，不存在时插入值初始化的实值
+         */
+        T& operator[](const key_type& k)
+        { return rep.try_emplace(k).first->second; }
+
+    public:
+        // 修改器
+
+        /**
+         *  @brief  清除所有元素，保留槽位
+         */
+        void clear() { rep.clear(); }
+
+        /**
+         *  @brief  插入元素x
+         */
+        pair<iterator, bool> insert(const value_type& x)
+        { return rep.insert_unique(x); }
+
+        pair<iterator, bool> insert(value_type&& x)
+        { return rep.insert_unique(std::move(x)); }
+
+        /**
+         *  @brief  插入来自范围[first, last)的元素
+         */
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator last)
+        { rep.insert_unique(first, last); }
+
+        void insert(std::initializer_list<value_type> l)
+        { rep.insert_unique(l.begin(), l.end()); }
+
+        template <class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        { return rep.emplace_unique(std::forward<Args>(args)...); }
+
+        /**
+         *  @brief  键值k不存在时插入以(k, args)构造的元素，否则什么也不做
+         */
+        template <class... Args>
+        pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        { return rep.try_emplace(k, std::forward<Args>(args)...); }
+
+        /**
+         *  @brief  键值k不存在时插入(k, obj)，否则将obj赋值给已有元素的实值
+         */
+        template <class M>
+        pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        { return rep.insert_or_assign(k, std::forward<M>(obj)); }
+
+        /**
+         *  @brief  移除位于pos的元素
+         *  @return  下一个元素的迭代器
+         */
+        iterator erase(const_iterator pos)
+        { return rep.erase(pos); }
+
+        /**
+         *  @brief  移除键值等于k的元素
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        { return rep.erase(k); }
+
+        void swap(compact_map& x)
+        { rep.swap(x.rep); }
+
+    public:
+        // 查找
+        size_type count(const key_type& k) const
+        { return rep.count(k); }
+
+        iterator find(const key_type& k)
+        { return rep.find(k); }
+
+        const_iterator find(const key_type& k) const
+        { return rep.find(k); }
+
+        /**
+         *  @brief  批量查找keys[0, n)，out[i]为keys[i]的查找结果，交错预取以隐藏访存延迟
+         */
+        void find_batch(const key_type* keys, size_type n, iterator* out)
+        { rep.find_batch(keys, n, out); }
+
+        void find_batch(const key_type* keys, size_type n, const_iterator* out) const
+        { rep.find_batch(keys, n, out); }
+
+    public:
+        // 桶接口与哈希策略
+        size_type bucket_count() const noexcept { return rep.bucket_count(); }
+        float load_factor() const noexcept { return rep.load_factor(); }
+        float max_load_factor() const noexcept { return rep.max_load_factor(); }
+        void max_load_factor(float z) { rep.max_load_factor(z); }
+        void rehash(size_type n) { rep.rehash(n); }
+        void reserve(size_type n) { rep.reserve(n); }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return rep.hash_function(); }
+        key_equal key_eq() const { return rep.key_eq(); }
+    };
+
+    template <class Key, class T, class HashFcn, class EqualKey, class Alloc>
+    inline void swap(compact_map<Key, T, HashFcn, EqualKey, Alloc>& x,
+                     compact_map<Key, T, HashFcn, EqualKey, Alloc>& y)
+    { x.swap(y); }
+
+} /* namespace STL */
+
+#endif
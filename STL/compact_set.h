@@ -0,0 +1,173 @@
+#ifndef TINYSTL_COMPACT_SET_H_
+#define TINYSTL_COMPACT_SET_H_
+
+#include "compact_hashtable.h"
+
+namespace STL
+{
+    /**
+     *  键值可平凡复制且不超过8字节时使用的紧凑unordered_set
+     *  元素直接存放在槽位数组中，不分配节点，插入导致重建table时所有迭代器失效
+     */
+    template <class Value,
+              class HashFcn = std::hash<Value>,
+              class EqualKey = std::equal_to<Value>,
+              class Alloc = STL::pool_alloc>
+    class compact_set
+    {
+    private:
+        using Hashtable = STL::compact_hashtable<Value, Value, HashFcn, std::_Identity<Value>, EqualKey, Alloc>;
+        Hashtable rep;
+
+    public:
+        using key_type          = typename Hashtable::key_type;
+        using value_type        = typename Hashtable::value_type;
+        using hasher            = typename Hashtable::hasher;
+        using key_equal         = typename Hashtable::key_equal;
+
+        using size_type         = typename Hashtable::size_type;
+        using difference_type   = typename Hashtable::difference_type;
+        using pointer           = typename Hashtable::pointer;
+        using const_pointer     = typename Hashtable::const_pointer;
+        using reference         = typename Hashtable::reference;
+        using const_reference   = typename Hashtable::const_reference;
+
+        using iterator          = typename Hashtable::const_iterator;
+        using const_iterator    = typename Hashtable::const_iterator;
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         *  @param  n  预计的元素个数
+         */
+        compact_set() : rep(0) { }
+        explicit compact_set(size_type n) : rep(n) { }
+        compact_set(size_type n, const hasher& hf) : rep(n, hf, key_equal()) { }
+        compact_set(size_type n, const hasher& hf, const key_equal& eql) : rep(n, hf, eql) { }
+
+        template <class InputIterator>
+        compact_set(InputIterator first, InputIterator last) : rep(0)
+        { rep.insert_unique(first, last); }
+
+        compact_set(std::initializer_list<value_type> l) : rep(l.size())
+        { rep.insert_unique(l.begin(), l.end()); }
+
+        /**
+         *  @brief  copy constructor
+         */
+        compact_set(const compact_set& x) : rep(x.rep) { }
+
+        /**
+         *  @brief  copy assignment
+         */
+        compact_set& operator=(const compact_set& x)
+        {
+            if (this != &x) {
+                rep = x.rep;
+            }
+            return *this;
+        }
+
+    public:
+        // 迭代器
+        iterator begin() const noexcept { return rep.begin(); }
+        const_iterator cbegin() const noexcept { return rep.cbegin(); }
+        iterator end() const noexcept { return rep.end(); }
+        const_iterator cend() const noexcept { return rep.cend(); }
+
+    public:
+        // 容量
+        size_type size() const noexcept { return rep.size(); }
+        size_type max_size() const noexcept { return rep.max_size(); }
+        bool empty() const noexcept { return rep.empty(); }
+
+    public:
+        // 修改器
+
+        /**
+         *  @brief  清除所有元素，保留槽位
+         */
+        void clear() { rep.clear(); }
+
+        /**
+         *  @brief  插入元素x
+         */
+        pair<iterator, bool> insert(const value_type& x)
+        {
+            pair<typename Hashtable::iterator, bool> p = rep.insert_unique(x);
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
+        /**
+         *  @brief  插入来自范围[first, last)的元素
+         */
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator last)
+        { rep.insert_unique(first, last); }
+
+        void insert(std::initializer_list<value_type> l)
+        { rep.insert_unique(l.begin(), l.end()); }
+
+        template <class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        {
+            pair<typename Hashtable::iterator, bool> p = rep.emplace_unique(std::forward<Args>(args)...);
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
+        /**
+         *  @brief  移除位于pos的元素
+         *  @return  下一个元素的迭代器
+         */
+        iterator erase(const_iterator pos)
+        { return rep.erase(pos); }
+
+        /**
+         *  @brief  移除键值等于k的元素
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        { return rep.erase(k); }
+
+        void swap(compact_set& x)
+        { rep.swap(x.rep); }
+
+    public:
+        // 查找
+        size_type count(const key_type& k) const
+        { return rep.count(k); }
+
+        iterator find(const key_type& k) const
+        { return rep.find(k); }
+
+        /**
+         *  @brief  批量查找keys[0, n)，out[i]为keys[i]的查找结果，交错预取以隐藏访存延迟
+         */
+        void find_batch(const key_type* keys, size_type n, iterator* out) const
+        { rep.find_batch(keys, n, out); }
+
+    public:
+        // 桶接口与哈希策略
+        size_type bucket_count() const noexcept { return rep.bucket_count(); }
+        float load_factor() const noexcept { return rep.load_factor(); }
+        float max_load_factor() const noexcept { return rep.max_load_factor(); }
+        void max_load_factor(float z) { rep.max_load_factor(z); }
+        void rehash(size_type n) { rep.rehash(n); }
+        void reserve(size_type n) { rep.reserve(n); }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return rep.hash_function(); }
+        key_equal key_eq() const { return rep.key_eq(); }
+    };
+
+    template <class Value, class HashFcn, class EqualKey, class Alloc>
+    inline void swap(compact_set<Value, HashFcn, EqualKey, Alloc>& x,
+                     compact_set<Value, HashFcn, EqualKey, Alloc>& y)
+    { x.swap(y); }
+
+} /* namespace STL */
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef TINYSTL_CONCURRENT_MAP_H_
+#define TINYSTL_CONCURRENT_MAP_H_
+
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+#include "concurrent_skiplist.h"
+
+using std::pair;
+
+namespace STL
+{
+
+    /**
+     *  以并发跳表为底层容器的有序map
+     *
+     *  查找、遍历不加锁，插入、删除只锁住受影响的节点，可由多个线程同时调用
+     *  元素插入后实值不可修改；迭代器只读，且只能在epoch_guard作用域内使用
+     *  并发语义与Alloc的缺省选择见concurrent_skiplist
+     */
+    template <class Key, class T, class Compare = std::less<Key>,
+              class Alloc = STL::malloc_alloc>
+    class concurrent_map
+    {
+    public:
+        using key_type      = Key;
+        using mapped_type   = T;
+        using value_type    = pair<const Key, T>;
+        using key_compare   = Compare;
+
+    private:
+        using Rep_type  = STL::concurrent_skiplist<key_type, value_type, std::_Select1st<value_type>, key_compare, Alloc>;
+        Rep_type t;
+
+    public:
+        using pointer           = typename Rep_type::pointer;
+        using const_pointer     = typename Rep_type::const_pointer;
+        using reference         = typename Rep_type::reference;
+        using const_reference   = typename Rep_type::const_reference;
+        using iterator          = typename Rep_type::const_iterator;
+        using const_iterator    = typename Rep_type::const_iterator;
+        using size_type         = typename Rep_type::size_type;
+        using difference_type   = typename Rep_type::difference_type;
+
+    public:
+        // The big five
+
+        concurrent_map() : t() { }
+
+        explicit concurrent_map(const Compare& cmp) : t(cmp) { }
+
+        concurrent_map(std::initializer_list<value_type> l, const Compare& cmp = Compare())
+        : t(cmp) { insert(l.begin(), l.end()); }
+
+        template <class InputIterator>
+        concurrent_map(InputIterator first, InputIterator last, const Compare& cmp = Compare())
+        : t(cmp) { insert(first, last); }
+
+        concurrent_map(const concurrent_map&) = delete;
+        concurrent_map& operator=(const concurrent_map&) = delete;
+
+    public:
+        // 访问器
+        key_compare key_comp() const { return t.key_comp(); }
+
+        // 迭代器，须在epoch_guard作用域内使用
+        const_iterator begin() const { return t.begin(); }
+        const_iterator cbegin() const { return t.begin(); }
+        const_iterator end() const noexcept { return t.end(); }
+        const_iterator cend() const noexcept { return t.end(); }
+
+        bool empty() const noexcept { return t.empty(); }
+        size_type size() const noexcept { return t.size(); }
+        size_type max_size() const noexcept { return t.max_size(); }
+
+    public:
+        // 修改器，返回是否插入了新元素
+        void clear() { t.clear(); }
+
+        bool insert(const value_type& x) { return t.insert(x); }
+        bool insert(value_type&& x) { return t.insert(std::move(x)); }
+
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator last)
+        {
+            for ( ; first != last; ++first)
+                t.insert(*first);
+        }
+
+        void insert(std::initializer_list<value_type> l)
+        { insert(l.begin(), l.end()); }
+
+        template <class... Args>
+        bool emplace(Args&&... args)
+        { return t.emplace(std::forward<Args>(args)...); }
+
+        template <class... Args>
+        bool try_emplace(const key_type& k, Args&&... args)
+        { return t.try_emplace(k, std::forward<Args>(args)...); }
+
+        size_type erase(const key_type& k) { return t.erase(k); }
+
+    public:
+        // 查找，不加锁
+
+        size_type count(const key_type& k) const { return t.count(k); }
+
+        /**
+         *  @brief  查找键值为k的元素，若存在则将其实值复制到result
+         *  @return  是否找到
+         */
+        bool find(const key_type& k, mapped_type& result) const
+        { return t.visit(k, [&result](const value_type& x) { result = x.second; }); }
+
+        // 以下返回迭代器，须在epoch_guard作用域内使用
+        const_iterator find(const key_type& k) const { return t.find(k); }
+        const_iterator lower_bound(const key_type& k) const { return t.lower_bound(k); }
+        const_iterator upper_bound(const key_type& k) const { return t.upper_bound(k); }
+
+        /**
+         *  @brief  对键值为k的元素调用f(const value_type&)
+         *  @return  是否找到
+         */
+        template <class F>
+        bool visit(const key_type& k, F f) const { return t.visit(k, f); }
+
+        /**
+         *  @brief  按键值递增，对键值在[first, last)内的元素调用f(const value_type&)
+         *  @return  访问的元素个数
+         */
+        template <class F>
+        size_type visit_range(const key_type& first, const key_type& last, F f) const
+        { return t.visit_range(first, last, f); }
+
+        template <class F>
+        void visit_all(F f) const { t.visit_all(f); }
+
+        bool verify() const { return t.verify(); }
+    };
+
+} /* namespace STL */
+
+#endif
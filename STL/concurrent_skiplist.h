@@ -0,0 +1,638 @@
+#ifndef TINYSTL_CONCURRENT_SKIPLIST_H_
+#define TINYSTL_CONCURRENT_SKIPLIST_H_
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "alloc.h"
+#include "construct.h"
+#include "epoch.h"
+#include "iterator.h"
+
+namespace STL
+{
+
+    /**
+     *  并发跳表（键值唯一，lazy skip list）
+     *
+     *  模板参数与rb_tree相同，由KeyOfValue从Value中取出键值，以Compare排序
+     *
+     *  读者不加锁：查找与遍历只沿原子指针前进，以acquire语义读取
+     *  写者只锁住受影响的节点：
+     *    插入时锁住各层的前驱，确认前驱未被删除且后继未变后，自底层向上链入新节点，最后置fully_linked
+     *    删除时先锁住节点并置marked（逻辑删除），再锁住各层前驱，自顶层向下摘下节点
+     *    不同位置上的插入、删除互不阻塞；加锁总是先键值大的节点后键值小的节点，不会死锁
+     *  元素只有在fully_linked且未marked时才可见；元素插入后不再修改，因此读者不会看到写了一半的元素
+     *
+     *  被摘下的节点以epoch回收：查找与修改都在epoch_guard内进行，节点要等到没有读者可能持有时才释放
+     *  迭代器不持有epoch，只能在调用者的epoch_guard作用域内使用；遍历是弱一致的，
+     *  按键值递增访问元素，不会重复，但可能看不到遍历开始后插入的元素，也可能看到已被删除的元素
+     *
+     *  pool_alloc的free-list不是线程安全的，因此Alloc缺省为malloc_alloc
+     */
+    template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = STL::malloc_alloc>
+    class concurrent_skiplist
+    {
+    public:
+        using key_type          = Key;
+        using value_type        = Value;
+        using pointer           = value_type*;
+        using const_pointer     = const value_type*;
+        using reference         = value_type&;
+        using const_reference   = const value_type&;
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+
+    private:
+        // 层高以1/4的概率递增，max_height层足以容纳4^max_height个元素
+        enum { max_height = 24 };
+
+        // 节点锁，只在修改时短暂持有，等待时让出处理器
+        class node_lock
+        {
+        private:
+            std::atomic<bool> locked;
+
+        public:
+            node_lock() : locked(false) { }
+
+            void lock()
+            {
+                while (locked.exchange(true, std::memory_order_acquire))
+                    std::this_thread::yield();
+            }
+
+            void unlock() { locked.store(false, std::memory_order_release); }
+        };
+
+        // 节点按层高分配，next数组延伸到节点末尾之后；头节点不构造元素
+        struct node
+        {
+            typename std::aligned_storage<sizeof(Value), alignof(Value)>::type storage;
+            node*               retired_next;       // 摘下后在待回收链表中的后继
+            unsigned long long  retired_epoch;      // 摘下时的回收标记
+            node_lock           lock;
+            std::atomic<bool>   marked;             // 已被逻辑删除
+            std::atomic<bool>   fully_linked;       // 已链入所有层
+            int                 height;
+            std::atomic<node*>  next[1];
+
+            explicit node(int h) : retired_next(nullptr), retired_epoch(0), lock(),
+                                   marked(false), fully_linked(false), height(h)
+            {
+                for (int i = 0; i < h; ++i)
+                    ::new (static_cast<void*>(next + i)) std::atomic<node*>(nullptr);
+            }
+
+            Value* valptr() { return reinterpret_cast<Value*>(&storage); }
+            const Value* valptr() const { return reinterpret_cast<const Value*>(&storage); }
+        };
+
+        static size_type node_size(int h)
+        { return sizeof(node) + (h - 1) * sizeof(std::atomic<node*>); }
+
+        // 节点是否可见
+        static bool is_live(const node* p)
+        { return p->fully_linked.load(std::memory_order_acquire) && !p->marked.load(std::memory_order_acquire); }
+
+        // 自p起沿第0层找到第一个可见的节点
+        static node* skip_dead(node* p)
+        {
+            while (p && !is_live(p))
+                p = p->next[0].load(std::memory_order_acquire);
+            return p;
+        }
+
+    public:
+        /**
+         *  跳表的迭代器，只读、单向
+         *  只能在epoch_guard作用域内使用
+         */
+        class const_iterator
+        {
+        public:
+            using iterator_category = STL::forward_iterator_tag;
+            using value_type        = Value;
+            using difference_type   = ptrdiff_t;
+            using pointer           = const Value*;
+            using reference         = const Value&;
+
+        private:
+            friend class concurrent_skiplist;
+            node* p;
+
+            explicit const_iterator(node* x) : p(x) { }
+
+        public:
+            const_iterator() : p(nullptr) { }
+
+            reference operator*() const { return *p->valptr(); }
+            pointer operator->() const { return p->valptr(); }
+
+            const_iterator& operator++()
+            {
+                p = skip_dead(p->next[0].load(std::memory_order_acquire));
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            bool operator==(const const_iterator& x) const { return p == x.p; }
+            bool operator!=(const const_iterator& x) const { return p != x.p; }
+        };
+
+        using iterator = const_iterator;
+
+    private:
+        Compare                     key_compare;
+        KeyOfValue                  get_key;
+        node*                       head;
+        std::atomic<size_type>      node_count;
+        std::mutex                  reclaimer;      // 保护待回收链表
+        node*                       retired_head;   // 待回收链表，按回收标记递减排列
+
+    private:
+        const key_type& key(const node* p) const { return get_key(*p->valptr()); }
+
+        static node* allocate_node(int h)
+        {
+            node* p = static_cast<node*>(Alloc::allocate(node_size(h)));
+            ::new (static_cast<void*>(p)) node(h);
+            return p;
+        }
+
+        static void deallocate_node(node* p)
+        { Alloc::deallocate(p, node_size(p->height)); }
+
+        template <class... Args>
+        static node* create_node(Args&&... args)
+        {
+            node* p = allocate_node(random_height());
+            try {
+                STL::construct(p->valptr(), std::forward<Args>(args)...);
+            } catch(...) {
+                deallocate_node(p);
+                throw;
+            }
+            return p;
+        }
+
+        static void destroy_node(node* p)
+        {
+            STL::destroy(p->valptr());
+            deallocate_node(p);
+        }
+
+        // 每个线程各有一个xorshift随机数发生器，两位一组，全为0的组数即为层高减1
+        static int random_height()
+        {
+            static thread_local unsigned long long state =
+                reinterpret_cast<unsigned long long>(&state) * 0x9e3779b97f4a7c15ull | 1;
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            unsigned long long r = state;
+            int h = 1;
+            while (h < max_height && (r & 3) == 0) {
+                ++h;
+                r >>= 2;
+            }
+            return h;
+        }
+
+        // 自顶层向下查找k，preds[l]为第l层最后一个键值小于k的节点，succs[l]为其后继
+        // 返回键值等于k的节点所在的最高层，不存在时返回-1；须处于epoch_guard内
+        int find_aux(const key_type& k, node** preds, node** succs) const
+        {
+            int found = -1;
+            node* pred = head;
+            for (int l = max_height - 1; l >= 0; --l) {
+                node* cur = pred->next[l].load(std::memory_order_acquire);
+                while (cur && key_compare(key(cur), k)) {
+                    pred = cur;
+                    cur = cur->next[l].load(std::memory_order_acquire);
+                }
+                if (found == -1 && cur && !key_compare(k, key(cur)))
+                    found = l;
+                preds[l] = pred;
+                succs[l] = cur;
+            }
+            return found;
+        }
+
+        // 第0层上第一个键值不小于k（upper为true时大于k）的节点，不论是否可见；须处于epoch_guard内
+        node* bound_node(const key_type& k, bool upper) const
+        {
+            node* pred = head;
+            node* cur = nullptr;
+            for (int l = max_height - 1; l >= 0; --l) {
+                cur = pred->next[l].load(std::memory_order_acquire);
+                while (cur && (upper ? !key_compare(k, key(cur)) : key_compare(key(cur), k))) {
+                    pred = cur;
+                    cur = cur->next[l].load(std::memory_order_acquire);
+                }
+                // 键值唯一，在较高层上遇到等于k的节点时它就是第0层上的结果
+                if (!upper && cur && !key_compare(k, key(cur)))
+                    return cur;
+            }
+            return cur;
+        }
+
+        // 查找键值为k的可见节点，不存在时返回nullptr；须处于epoch_guard内
+        node* find_node(const key_type& k) const
+        {
+            node* p = bound_node(k, false);
+            return p && !key_compare(k, key(p)) && is_live(p) ? p : nullptr;
+        }
+
+        // 解开preds[0..highest]上的锁，相同的前驱只在相邻的层上出现，只解一次
+        static void unlock_preds(node** preds, int highest)
+        {
+            node* prev = nullptr;
+            for (int l = 0; l <= highest; ++l) {
+                if (preds[l] != prev) {
+                    preds[l]->lock.unlock();
+                    prev = preds[l];
+                }
+            }
+        }
+
+        // 插入键值为k的元素，键值已存在时返回false；须处于epoch_guard内
+        // tmp为已构造好的节点时k须为其键值；tmp为nullptr时，确认k不存在后才以make()构造节点
+        // make()可能移走k，此后改以节点中的键值重试；失败时销毁tmp
+        template <class Make>
+        bool insert_node(const key_type& k, node* tmp, Make make)
+        {
+            node* preds[max_height];
+            node* succs[max_height];
+            const key_type* pk = &k;
+            for (;;) {
+                int found = find_aux(*pk, preds, succs);
+                if (found != -1) {
+                    node* x = succs[found];
+                    if (!x->marked.load(std::memory_order_acquire)) {
+                        // 等待正在插入的同键值节点完成，使返回false之后该元素一定可见
+                        while (!x->fully_linked.load(std::memory_order_acquire))
+                            std::this_thread::yield();
+                        if (tmp)
+                            destroy_node(tmp);
+                        return false;
+                    }
+                    // 同键值节点正在被删除，重试
+                    continue;
+                }
+                if (!tmp) {
+                    tmp = make();
+                    pk = &key(tmp);
+                }
+                const int h = tmp->height;
+                int highest = -1;
+                bool valid = true;
+                node* prev = nullptr;
+                for (int l = 0; valid && l < h; ++l) {
+                    node* pred = preds[l];
+                    node* succ = succs[l];
+                    if (pred != prev) {
+                        pred->lock.lock();
+                        prev = pred;
+                    }
+                    highest = l;
+                    valid = !pred->marked.load(std::memory_order_acquire)
+                            && (!succ || !succ->marked.load(std::memory_order_acquire))
+                            && pred->next[l].load(std::memory_order_acquire) == succ;
+                }
+                if (!valid) {
+                    unlock_preds(preds, highest);
+                    continue;
+                }
+
+                for (int l = 0; l < h; ++l)
+                    tmp->next[l].store(succs[l], std::memory_order_relaxed);
+                for (int l = 0; l < h; ++l)
+                    preds[l]->next[l].store(tmp, std::memory_order_release);
+                tmp->fully_linked.store(true, std::memory_order_release);
+                unlock_preds(preds, highest);
+                node_count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // 删除键值为k的节点，返回被摘下的节点，不存在时返回nullptr；须处于epoch_guard内
+        node* erase_node(const key_type& k)
+        {
+            node* preds[max_height];
+            node* succs[max_height];
+            node* victim = nullptr;
+            bool is_marked = false;
+            int h = -1;
+            for (;;) {
+                int found = find_aux(k, preds, succs);
+                if (!is_marked) {
+                    if (found == -1)
+                        return nullptr;
+                    victim = succs[found];
+                    // 只删除已完全链入、且在其最高层上找到的节点，这样各层的前驱都已求出
+                    if (!victim->fully_linked.load(std::memory_order_acquire)
+                        || victim->height - 1 != found
+                        || victim->marked.load(std::memory_order_acquire))
+                        return nullptr;
+                    h = victim->height;
+                    victim->lock.lock();
+                    if (victim->marked.load(std::memory_order_relaxed)) {
+                        victim->lock.unlock();
+                        return nullptr;
+                    }
+                    victim->marked.store(true, std::memory_order_release);
+                    is_marked = true;
+                }
+
+                int highest = -1;
+                bool valid = true;
+                node* prev = nullptr;
+                for (int l = 0; valid && l < h; ++l) {
+                    node* pred = preds[l];
+                    if (pred != prev) {
+                        pred->lock.lock();
+                        prev = pred;
+                    }
+                    highest = l;
+                    valid = !pred->marked.load(std::memory_order_acquire)
+                            && pred->next[l].load(std::memory_order_acquire) == victim;
+                }
+                if (!valid) {
+                    unlock_preds(preds, highest);
+                    continue;
+                }
+
+                for (int l = h - 1; l >= 0; --l)
+                    preds[l]->next[l].store(victim->next[l].load(std::memory_order_relaxed), std::memory_order_release);
+                victim->lock.unlock();
+                unlock_preds(preds, highest);
+                node_count.fetch_sub(1, std::memory_order_relaxed);
+                return victim;
+            }
+        }
+
+        // 登记已摘下的节点，并释放所有已不可能被读者持有的节点
+        // 在同一把锁内推进epoch并挂到链表头，因此链表按回收标记递减排列
+        void retire(node* p)
+        {
+            std::lock_guard<std::mutex> lock(reclaimer);
+            p->retired_epoch = epoch_domain::instance().advance();
+            p->retired_next = retired_head;
+            retired_head = p;
+
+            const unsigned long long m = epoch_domain::instance().min_active();
+            node** link = &retired_head;
+            while (*link && (*link)->retired_epoch >= m)
+                link = &(*link)->retired_next;
+            node* cur = *link;
+            *link = nullptr;
+            while (cur) {
+                node* next = cur->retired_next;
+                destroy_node(cur);
+                cur = next;
+            }
+        }
+
+    public:
+        // The big five
+
+        explicit concurrent_skiplist(const Compare& comp = Compare())
+        : key_compare(comp), get_key(), head(allocate_node(max_height)), node_count(0),
+          reclaimer(), retired_head(nullptr)
+        { head->fully_linked.store(true, std::memory_order_relaxed); }
+
+        concurrent_skiplist(const concurrent_skiplist&) = delete;
+        concurrent_skiplist& operator=(const concurrent_skiplist&) = delete;
+
+        /**
+         *  @brief  destructor
+         *
+         *  析构时不得有其他线程仍在访问
+         */
+        ~concurrent_skiplist()
+        {
+            node* cur = head->next[0].load(std::memory_order_relaxed);
+            while (cur) {
+                node* next = cur->next[0].load(std::memory_order_relaxed);
+                destroy_node(cur);
+                cur = next;
+            }
+            deallocate_node(head);
+            while (retired_head) {
+                node* next = retired_head->retired_next;
+                destroy_node(retired_head);
+                retired_head = next;
+            }
+        }
+
+    public:
+        // 访问器
+
+        Compare key_comp() const { return key_compare; }
+
+        /**
+         *  @brief  元素个数，并发修改时只是一个近似值
+         */
+        size_type size() const noexcept { return node_count.load(std::memory_order_relaxed); }
+        bool empty() const noexcept { return size() == 0; }
+        size_type max_size() const noexcept { return size_type(-1); }
+
+    public:
+        // 迭代器，须在epoch_guard作用域内使用
+
+        const_iterator begin() const
+        { return const_iterator(skip_dead(head->next[0].load(std::memory_order_acquire))); }
+
+        const_iterator end() const noexcept { return const_iterator(nullptr); }
+
+        const_iterator find(const key_type& k) const
+        { return const_iterator(find_node(k)); }
+
+        const_iterator lower_bound(const key_type& k) const
+        { return const_iterator(skip_dead(bound_node(k, false))); }
+
+        const_iterator upper_bound(const key_type& k) const
+        { return const_iterator(skip_dead(bound_node(k, true))); }
+
+    public:
+        // 查找，不加锁
+
+        /**
+         *  @brief  返回键值为k的元素个数
+         */
+        size_type count(const key_type& k) const
+        {
+            epoch_guard guard;
+            return find_node(k) ? 1 : 0;
+        }
+
+        /**
+         *  @brief  对键值为k的元素调用f(const value_type&)
+         *  @return  是否找到
+         *
+         *  f在读临界区内执行，期间元素不会被释放；f返回后不得再持有该元素的引用
+         */
+        template <class F>
+        bool visit(const key_type& k, F f) const
+        {
+            epoch_guard guard;
+            node* p = find_node(k);
+            if (!p)
+                return false;
+            f(*p->valptr());
+            return true;
+        }
+
+        /**
+         *  @brief  按键值递增，对键值在[first, last)内的元素调用f(const value_type&)
+         *  @return  访问的元素个数
+         */
+        template <class F>
+        size_type visit_range(const key_type& first, const key_type& last, F f) const
+        {
+            epoch_guard guard;
+            size_type n = 0;
+            for (const_iterator it = lower_bound(first); it != end() && key_compare(get_key(*it), last); ++it, ++n)
+                f(*it);
+            return n;
+        }
+
+        /**
+         *  @brief  按键值递增，对所有元素调用f(const value_type&)
+         */
+        template <class F>
+        void visit_all(F f) const
+        {
+            epoch_guard guard;
+            for (const_iterator it = begin(); it != end(); ++it)
+                f(*it);
+        }
+
+    public:
+        // 修改器，只锁住受影响的节点
+
+        /**
+         *  @brief  插入元素x
+         *  @return  是否插入成功，键值已存在时返回false
+         */
+        bool insert(const value_type& x)
+        {
+            epoch_guard guard;
+            return insert_node(get_key(x), nullptr, [&x]() { return create_node(x); });
+        }
+
+        bool insert(value_type&& x)
+        {
+            epoch_guard guard;
+            return insert_node(get_key(x), nullptr, [&x]() { return create_node(std::move(x)); });
+        }
+
+        /**
+         *  @brief  以args原地构造元素并插入
+         *  @return  是否插入成功
+         */
+        template <class... Args>
+        bool emplace(Args&&... args)
+        {
+            epoch_guard guard;
+            node* tmp = create_node(std::forward<Args>(args)...);
+            return insert_node(key(tmp), tmp, []() -> node* { return nullptr; });
+        }
+
+        /**
+         *  @brief  若键值k不存在，则以k和args原地构造元素pair(k, T(args...))
+         *  @return  是否插入成功
+         *
+         *  仅适用于value_type为pair<const Key, T>的情形，键值已存在时不构造节点
+         */
+        template <class... Args>
+        bool try_emplace(const key_type& k, Args&&... args)
+        {
+            epoch_guard guard;
+            return insert_node(k, nullptr, [&]() {
+                return create_node(std::piecewise_construct, std::forward_as_tuple(k),
+                                   std::forward_as_tuple(std::forward<Args>(args)...));
+            });
+        }
+
+        /**
+         *  @brief  移除键值等于k的元素
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        {
+            node* victim;
+            {
+                epoch_guard guard;
+                victim = erase_node(k);
+            }
+            if (!victim)
+                return 0;
+            retire(victim);
+            return 1;
+        }
+
+        /**
+         *  @brief  逐个移除所有元素，可与其他操作并发执行
+         */
+        void clear()
+        {
+            for (;;) {
+                node* victim;
+                {
+                    epoch_guard guard;
+                    node* first = skip_dead(head->next[0].load(std::memory_order_acquire));
+                    if (!first)
+                        return;
+                    victim = erase_node(key(first));
+                }
+                if (victim)
+                    retire(victim);
+            }
+        }
+
+    public:
+        /**
+         *  @brief  检查各层是否按键值严格递增，且每个节点都链入了其所有层，不得与修改并发调用
+         */
+        bool verify() const
+        {
+            size_type n = 0;
+            for (node* p = head->next[0].load(); p; p = p->next[0].load(), ++n) {
+                if (!p->fully_linked.load() || p->marked.load())
+                    return false;
+            }
+            if (n != size())
+                return false;
+            for (int l = 0; l < max_height; ++l) {
+                node* prev = nullptr;
+                node* low = head->next[0].load();
+                for (node* p = head->next[l].load(); p; prev = p, p = p->next[l].load()) {
+                    if (p->height <= l || (prev && !key_compare(key(prev), key(p))))
+                        return false;
+                    // 第l层的每个节点都必须出现在第0层
+                    while (low && low != p)
+                        low = low->next[0].load();
+                    if (!low)
+                        return false;
+                }
+            }
+            return true;
+        }
+    };
+
+} /* namespace STL */
+
+#endif
@@ -0,0 +1,314 @@
+#ifndef TINYSTL_CONCURRENT_UNORDERED_MAP_H_
+#define TINYSTL_CONCURRENT_UNORDERED_MAP_H_
+
+#include <functional>
+#include <utility>
+
+#include "hashtable.h"
+#include "rwlock.h"
+#include "vector.h"
+
+namespace STL
+{
+    /**
+     *  分片的并发unordered_map
+     *
+     *  键值按hash值分配到若干个互相独立的hashtable（分片）中，每个分片各有一把读写锁
+     *  不同分片上的操作互不阻塞，同一分片上的读操作可以并发进行
+     *  不提供迭代器，元素只能在持锁期间经由visit()系列接口访问，或通过find()复制出来
+     *
+     *  不同分片上的写者同时分配、释放节点，分配器须线程安全，因此Alloc缺省为malloc_alloc
+     */
+    template <class Key,
+              class T,
+              class HashFcn = std::hash<Key>,
+              class EqualKey = std::equal_to<Key>,
+              class Alloc = STL::malloc_alloc>
+    class concurrent_unordered_map
+    {
+    private:
+        using Hashtable = STL::hashtable<pair<const Key, T>, Key, HashFcn, std::_Select1st<pair<const Key, T>>, EqualKey, Alloc>;
+
+    public:
+        using key_type          = typename Hashtable::key_type;
+        using mapped_type       = T;
+        using value_type        = typename Hashtable::value_type;
+        using hasher            = typename Hashtable::hasher;
+        using key_equal         = typename Hashtable::key_equal;
+        using size_type         = typename Hashtable::size_type;
+
+    private:
+        // 分片 = 读写锁 + hashtable
+        // 每个分片单独分配，末尾填充一个缓存行，避免相邻分片的锁落在同一缓存行而伪共享
+        struct shard
+        {
+            rw_lock     lock;
+            Hashtable   table;
+            char        padding[64];
+
+            shard(size_type n, const hasher& hf, const key_equal& eql) : lock(), table(n, hf, eql) { }
+        };
+
+        using shard_allocator   = STL::allocator<shard, Alloc>;
+
+        STL::vector<shard*, Alloc>  shards;
+        size_type                   mask;   // 分片数为2的幂，mask = 分片数 - 1
+        hasher                      hash;
+
+        // 选择键值k所在的分片
+        // hashtable以hash(k)对质数取模选桶，这里先将hash值打散再取低位，使分片与桶的选择相互独立
+        shard& shard_of(const key_type& k) const
+        {
+            unsigned long long h = hash(k);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            return *shards[static_cast<size_type>(h) & mask];
+        }
+
+        void destroy_shards()
+        {
+            for (size_type i = 0; i < shards.size(); ++i) {
+                STL::destroy(shards[i]);
+                shard_allocator::deallocate(shards[i]);
+            }
+            shards.clear();
+        }
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         *  @param  shard_count  分片数，向上取整为2的幂，一般取为线程数的数倍
+         *  @param  n            预计的元素个数，平均分给各个分片作为初始桶数
+         */
+        explicit concurrent_unordered_map(size_type shard_count = 16, size_type n = 100,
+                                          const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : shards(), mask(0), hash(hf)
+        {
+            size_type count = 1;
+            while (count < shard_count)
+                count <<= 1;
+            mask = count - 1;
+            shards.reserve(count);
+            for (size_type i = 0; i < count; ++i) {
+                shard* p = shard_allocator::allocate();
+                try {
+                    STL::construct(p, n / count + 1, hf, eql);
+                } catch(...) {
+                    shard_allocator::deallocate(p);
+                    destroy_shards();
+                    throw;
+                }
+                shards.push_back(p);
+            }
+        }
+
+        concurrent_unordered_map(const concurrent_unordered_map&) = delete;
+        concurrent_unordered_map& operator=(const concurrent_unordered_map&) = delete;
+
+        /**
+         *  @brief  destructor
+         *
+         *  析构时不得有其他线程仍在访问
+         */
+        ~concurrent_unordered_map() { destroy_shards(); }
+
+    public:
+        // 容量
+
+        /**
+         *  @brief  元素个数
+         *
+         *  逐个分片加读锁统计，并发修改时只是一个近似值
+         */
+        size_type size() const
+        {
+            size_type result = 0;
+            for (size_type i = 0; i < shards.size(); ++i) {
+                read_guard guard(shards[i]->lock);
+                result += shards[i]->table.size();
+            }
+            return result;
+        }
+
+        bool empty() const { return size() == 0; }
+
+        size_type shard_count() const noexcept { return shards.size(); }
+
+    public:
+        // 修改器
+
+        /**
+         *  @brief  清除所有元素
+         */
+        void clear()
+        {
+            for (size_type i = 0; i < shards.size(); ++i) {
+                write_guard guard(shards[i]->lock);
+                shards[i]->table.clear();
+            }
+        }
+
+        /**
+         *  @brief  插入元素x
+         *  @return  是否插入成功，键值已存在时返回false
+         */
+        bool insert(const value_type& x)
+        {
+            shard& s = shard_of(x.first);
+            write_guard guard(s.lock);
+            return s.table.insert_unique(x).second;
+        }
+
+        bool insert(value_type&& x)
+        {
+            shard& s = shard_of(x.first);
+            write_guard guard(s.lock);
+            return s.table.insert_unique(std::move(x)).second;
+        }
+
+        /**
+         *  @brief  若键值k不存在，则插入以k和args原地构造的元素
+         *  @return  是否插入成功
+         */
+        template <class... Args>
+        bool try_emplace(const key_type& k, Args&&... args)
+        {
+            shard& s = shard_of(k);
+            write_guard guard(s.lock);
+            return s.table.try_emplace(k, std::forward<Args>(args)...).second;
+        }
+
+        /**
+         *  @brief  若键值k不存在，则插入(k, obj)，否则将obj赋值给已有元素
+         *  @return  是否插入了新元素
+         */
+        template <class M>
+        bool insert_or_assign(const key_type& k, M&& obj)
+        {
+            shard& s = shard_of(k);
+            write_guard guard(s.lock);
+            return s.table.insert_or_assign(k, std::forward<M>(obj)).second;
+        }
+
+        /**
+         *  @brief  移除键值等于k的元素
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        {
+            shard& s = shard_of(k);
+            write_guard guard(s.lock);
+            return s.table.erase(k);
+        }
+
+    public:
+        // 查找
+
+        /**
+         *  @brief  返回键值为k的元素个数
+         */
+        size_type count(const key_type& k) const
+        {
+            shard& s = shard_of(k);
+            read_guard guard(s.lock);
+            return s.table.count(k);
+        }
+
+        /**
+         *  @brief  查找键值为k的元素，若存在则将其实值复制到result
+         *  @return  是否找到
+         */
+        bool find(const key_type& k, mapped_type& result) const
+        {
+            shard& s = shard_of(k);
+            read_guard guard(s.lock);
+            typename Hashtable::const_iterator it = s.table.find(k);
+            if (it == s.table.end())
+                return false;
+            result = it->second;
+            return true;
+        }
+
+        /**
+         *  @brief  持读锁对键值为k的元素调用f(const value_type&)
+         *  @return  是否找到
+         *
+         *  f在锁内执行，应尽量简短，且不得再访问本容器
+         */
+        template <class F>
+        bool cvisit(const key_type& k, F f) const
+        {
+            shard& s = shard_of(k);
+            read_guard guard(s.lock);
+            typename Hashtable::const_iterator it = s.table.find(k);
+            if (it == s.table.end())
+                return false;
+            f(*it);
+            return true;
+        }
+
+        template <class F>
+        bool visit(const key_type& k, F f) const
+        { return cvisit(k, f); }
+
+        /**
+         *  @brief  持写锁对键值为k的元素调用f(value_type&)，f可修改元素的实值
+         *  @return  是否找到
+         */
+        template <class F>
+        bool visit(const key_type& k, F f)
+        {
+            shard& s = shard_of(k);
+            write_guard guard(s.lock);
+            typename Hashtable::iterator it = s.table.find(k);
+            if (it == s.table.end())
+                return false;
+            f(*it);
+            return true;
+        }
+
+        /**
+         *  @brief  逐个分片持读锁，对所有元素调用f(const value_type&)
+         *
+         *  不同分片的访问不是同一时刻的快照
+         */
+        template <class F>
+        void cvisit_all(F f) const
+        {
+            for (size_type i = 0; i < shards.size(); ++i) {
+                read_guard guard(shards[i]->lock);
+                const Hashtable& table = shards[i]->table;
+                for (typename Hashtable::const_iterator it = table.begin(); it != table.end(); ++it)
+                    f(*it);
+            }
+        }
+
+        template <class F>
+        void visit_all(F f) const
+        { cvisit_all(f); }
+
+        /**
+         *  @brief  逐个分片持写锁，对所有元素调用f(value_type&)
+         */
+        template <class F>
+        void visit_all(F f)
+        {
+            for (size_type i = 0; i < shards.size(); ++i) {
+                write_guard guard(shards[i]->lock);
+                Hashtable& table = shards[i]->table;
+                for (typename Hashtable::iterator it = table.begin(); it != table.end(); ++it)
+                    f(*it);
+            }
+        }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return hash; }
+    };
+
+} /* namespace STL */
+
+#endif
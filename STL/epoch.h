@@ -0,0 +1,160 @@
+#ifndef TINYSTL_EPOCH_H_
+#define TINYSTL_EPOCH_H_
+
+#include <atomic>
+#include <climits>
+
+#include "allocator.h"
+
+namespace STL
+{
+
+    /**
+     *  基于epoch的内存回收（epoch-based reclamation）
+     *
+     *  读者进入临界区时把全局epoch记到自己线程的记录中，离开时清零
+     *  写者摘下节点后推进全局epoch，并以推进前的值e标记该节点
+     *  只有当所有处于临界区的读者记录的epoch都大于e时，才没有读者可能还持有该节点，此时方可释放
+     *
+     *  每个线程的记录独占一个缓存行，读者只写自己的记录，不写任何共享缓存行
+     *  全进程共用一个epoch_domain，记录在线程退出后被回收复用
+     */
+    class epoch_domain
+    {
+    private:
+        struct record
+        {
+            std::atomic<unsigned long long> epoch;      // 0表示不在临界区内
+            std::atomic<bool>               in_use;     // 是否已被某个线程占用
+            record*                         next;       // 加入链表后不再改变
+            unsigned                        nesting;    // 临界区嵌套层数，只由所属线程访问
+            char                            padding[64];
+
+            record() : epoch(0), in_use(true), next(nullptr), nesting(0) { }
+        };
+
+        using record_allocator = STL::allocator<record, STL::malloc_alloc>;
+
+        std::atomic<unsigned long long> global;
+        std::atomic<record*>            head;
+
+        epoch_domain() : global(1), head(nullptr) { }
+
+        ~epoch_domain()
+        {
+            record* r = head.load();
+            while (r) {
+                record* next = r->next;
+                STL::destroy(r);
+                record_allocator::deallocate(r);
+                r = next;
+            }
+        }
+
+        // 优先复用已退出线程留下的记录，否则新建记录并以CAS插入链表头
+        record* acquire_record()
+        {
+            for (record* r = head.load(std::memory_order_acquire); r; r = r->next) {
+                bool expected = false;
+                if (!r->in_use.load(std::memory_order_relaxed) && r->in_use.compare_exchange_strong(expected, true))
+                    return r;
+            }
+            record* r = record_allocator::allocate();
+            STL::construct(r);
+            record* old = head.load(std::memory_order_relaxed);
+            do {
+                r->next = old;
+            } while (!head.compare_exchange_weak(old, r, std::memory_order_release, std::memory_order_relaxed));
+            return r;
+        }
+
+        // 线程退出时归还记录
+        struct thread_handle
+        {
+            record* r = nullptr;
+            ~thread_handle() { if (r) r->in_use.store(false, std::memory_order_release); }
+        };
+
+        record* local()
+        {
+            static thread_local thread_handle h;
+            if (!h.r)
+                h.r = acquire_record();
+            return h.r;
+        }
+
+    public:
+        epoch_domain(const epoch_domain&) = delete;
+        epoch_domain& operator=(const epoch_domain&) = delete;
+
+        static epoch_domain& instance()
+        {
+            static epoch_domain d;
+            return d;
+        }
+
+        /**
+         *  @brief  进入读临界区，可嵌套
+         */
+        void enter()
+        {
+            record* r = local();
+            if (r->nesting++ == 0) {
+                r->epoch.store(global.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                // 保证之后对共享指针的读取不会被重排到发布epoch之前
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        /**
+         *  @brief  离开读临界区
+         */
+        void leave()
+        {
+            record* r = local();
+            if (--r->nesting == 0)
+                r->epoch.store(0, std::memory_order_release);
+        }
+
+        /**
+         *  @brief  推进全局epoch，须在摘下待回收对象之后调用
+         *  @return  推进前的epoch，作为这些对象的回收标记
+         */
+        unsigned long long advance()
+        {
+            unsigned long long e = global.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return e;
+        }
+
+        /**
+         *  @brief  当前处于临界区的读者记录的最小epoch，没有读者时返回ULLONG_MAX
+         *
+         *  标记小于该值的对象可以安全释放
+         */
+        unsigned long long min_active() const
+        {
+            unsigned long long result = ULLONG_MAX;
+            for (record* r = head.load(std::memory_order_acquire); r; r = r->next) {
+                unsigned long long e = r->epoch.load(std::memory_order_acquire);
+                if (e != 0 && e < result)
+                    result = e;
+            }
+            return result;
+        }
+    };
+
+    // 作用域内处于读临界区
+    class epoch_guard
+    {
+    public:
+        epoch_guard() { epoch_domain::instance().enter(); }
+        ~epoch_guard() { epoch_domain::instance().leave(); }
+
+        epoch_guard(const epoch_guard&) = delete;
+        epoch_guard& operator=(const epoch_guard&) = delete;
+    };
+
+} /* namespace STL */
+
+#endif
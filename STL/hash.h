@@ -0,0 +1,235 @@
+#ifndef TINYSTL_HASH_H_
+#define TINYSTL_HASH_H_
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace STL
+{
+
+    // hash_bytes与hash_mix所用的常数，取自wyhash
+    static const uint64_t hash_secret[4] = {
+        0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+    };
+
+    // 64位乘法的128位结果，*a取低64位、*b取高64位
+    inline void hash_mum(uint64_t* a, uint64_t* b)
+    {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t r = static_cast<__uint128_t>(*a) * *b;
+        *a = static_cast<uint64_t>(r);
+        *b = static_cast<uint64_t>(r >> 64);
+#else
+        const uint64_t ha = *a >> 32, hb = *b >> 32, la = static_cast<uint32_t>(*a), lb = static_cast<uint32_t>(*b);
+        const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        const uint64_t t = rl + (rm0 << 32);
+        uint64_t c = t < rl;
+        const uint64_t lo = t + (rm1 << 32);
+        c += lo < t;
+        *a = lo;
+        *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+    }
+
+    // 128位乘积的高低两半异或，一次乘法即可让每个输出位依赖于全部输入位
+    inline uint64_t hash_mix(uint64_t a, uint64_t b)
+    {
+        hash_mum(&a, &b);
+        return a ^ b;
+    }
+
+    namespace hash_detail
+    {
+        inline uint64_t read8(const unsigned char* p)
+        {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            return v;
+        }
+
+        inline uint64_t read4(const unsigned char* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        // 读取1~3个字节
+        inline uint64_t read3(const unsigned char* p, size_t k)
+        { return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[k >> 1]) << 8) | p[k - 1]; }
+    }
+
+    /**
+     *  @brief  计算[p, p + len)中字节的hash值，wyhash算法
+     *
+     *  长度超过48字节时以三路互不依赖的乘法并行处理，每轮消耗48字节
+     *  16字节以内不循环，以两次可能重叠的读取覆盖全部字节
+     */
+    inline uint64_t hash_bytes(const void* key, size_t len, uint64_t seed = 0)
+    {
+        using namespace hash_detail;
+        const unsigned char* p = static_cast<const unsigned char*>(key);
+        const uint64_t* s = hash_secret;
+        seed ^= hash_mix(seed ^ s[0], s[1]);
+        uint64_t a, b;
+        if (len <= 16) {
+            if (len >= 4) {
+                a = (read4(p) << 32) | read4(p + ((len >> 3) << 2));
+                b = (read4(p + len - 4) << 32) | read4(p + len - 4 - ((len >> 3) << 2));
+            } else if (len > 0) {
+                a = read3(p, len);
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+        } else {
+            size_t i = len;
+            if (i > 48) {
+                uint64_t see1 = seed, see2 = seed;
+                do {
+                    seed = hash_mix(read8(p) ^ s[1], read8(p + 8) ^ seed);
+                    see1 = hash_mix(read8(p + 16) ^ s[2], read8(p + 24) ^ see1);
+                    see2 = hash_mix(read8(p + 32) ^ s[3], read8(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16) {
+                seed = hash_mix(read8(p) ^ s[1], read8(p + 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            // 最后16字节，可能与已处理的字节重叠
+            a = read8(p + i - 16);
+            b = read8(p + i - 8);
+        }
+        a ^= s[1];
+        b ^= seed;
+        hash_mum(&a, &b);
+        return hash_mix(a ^ s[0] ^ len, b ^ s[1]);
+    }
+
+    /**
+     *  TinySTL的hash函数对象，可用作各容器的HashFcn
+     *
+     *  与std::hash不同，整数不是恒等映射，而是经过一次128位乘法打散，
+     *  因此有规律的键值（如步长为2的幂）在任何桶数下都能均匀分布
+     *  未特化的类型先取std::hash的结果再打散
+     */
+    template <class T, class = void>
+    struct hash
+    {
+        size_t operator()(const T& x) const
+        { return static_cast<size_t>(hash_mix(std::hash<T>()(x) ^ hash_secret[0], hash_secret[1])); }
+    };
+
+    // 整数与枚举
+    template <class T>
+    struct hash<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+    {
+        size_t operator()(T x) const
+        { return static_cast<size_t>(hash_mix(static_cast<uint64_t>(x) ^ hash_secret[0], hash_secret[1])); }
+    };
+
+    // 指针，低位因对齐恒为0，同样需要打散
+    template <class T>
+    struct hash<T*>
+    {
+        size_t operator()(T* p) const
+        { return static_cast<size_t>(hash_mix(reinterpret_cast<uintptr_t>(p) ^ hash_secret[0], hash_secret[1])); }
+    };
+
+    /**
+     *  字符串的hash函数，std::string与C字符串的hash值相同
+     *  声明了is_transparent，与string_equal搭配时可以直接以const char*查找，不构造临时string
+     */
+    template <>
+    struct hash<std::string>
+    {
+        using is_transparent = void;
+
+        size_t operator()(const std::string& s) const
+        { return static_cast<size_t>(hash_bytes(s.data(), s.size())); }
+
+        size_t operator()(const char* s) const
+        { return static_cast<size_t>(hash_bytes(s, std::strlen(s))); }
+    };
+
+    template <>
+    struct hash<const char*>
+    {
+        size_t operator()(const char* s) const
+        { return static_cast<size_t>(hash_bytes(s, std::strlen(s))); }
+    };
+
+    // 与hash<std::string>搭配的异构相等性函数
+    struct string_equal
+    {
+        using is_transparent = void;
+
+        bool operator()(const std::string& x, const std::string& y) const { return x == y; }
+        bool operator()(const std::string& x, const char* y) const { return x == y; }
+        bool operator()(const char* x, const std::string& y) const { return y == x; }
+    };
+
+    /**
+     *  @brief  将v的hash值合并进seed，用于由多个成员组成的键值
+     *
+     *  合并结果与顺序有关：(a, b)与(b, a)一般得到不同的hash值
+     */
+    template <class T>
+    inline void hash_combine(size_t& seed, const T& v)
+    { seed = static_cast<size_t>(hash_mix(seed ^ hash_secret[2], hash<T>()(v) ^ hash_secret[3])); }
+
+    template <class T1, class T2>
+    struct hash<std::pair<T1, T2>>
+    {
+        size_t operator()(const std::pair<T1, T2>& x) const
+        {
+            size_t seed = 0;
+            hash_combine(seed, x.first);
+            hash_combine(seed, x.second);
+            return seed;
+        }
+    };
+
+    namespace hash_detail
+    {
+        // 依次合并tuple中第I个及以后的元素
+        template <size_t I, class Tuple, bool = (I < std::tuple_size<Tuple>::value)>
+        struct tuple_hash_aux
+        {
+            static void combine(size_t& seed, const Tuple& t)
+            {
+                hash_combine(seed, std::get<I>(t));
+                tuple_hash_aux<I + 1, Tuple>::combine(seed, t);
+            }
+        };
+
+        template <size_t I, class Tuple>
+        struct tuple_hash_aux<I, Tuple, false>
+        {
+            static void combine(size_t&, const Tuple&) { }
+        };
+    }
+
+    template <class... Types>
+    struct hash<std::tuple<Types...>>
+    {
+        size_t operator()(const std::tuple<Types...>& t) const
+        {
+            size_t seed = 0;
+            hash_detail::tuple_hash_aux<0, std::tuple<Types...>>::combine(seed, t);
+            return seed;
+        }
+    };
+
+} /* namespace STL */
+
+#endif
@@ -1,8 +1,17 @@
 #ifndef TINYSTL_HASHTABLE_H_
 #define TINYSTL_HASHTABLE_H_ 
 
+#include <algorithm>    // for std::max
+#include <cmath>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+
 #include "allocator.h"
 #include "iterator.h"
+#include "node_handle.h"
+#include "parallel.h"
+#include "type_traits.h"
 #include "vector.h"
 
 using std::pair;
@@ -10,11 +19,22 @@ using std::pair;
 namespace STL
 {
 
+    // 节点基类，只含指向下一节点的指针
+    // 所有节点串接成一条单向链表，hashtable内的before_begin作为链表的头哨兵
+    struct hashtable_node_base
+    {
+        hashtable_node_base* next;
+    };
+
     template <class Value>
-    struct hashtable_node
+    struct hashtable_node : public hashtable_node_base
     {
-        hashtable_node* next;
         Value val;
+
+        hashtable_node* M_next() const { return static_cast<hashtable_node*>(next); }
+
+        Value* valptr() { return std::addressof(val); }
+        const Value* valptr() const { return std::addressof(val); }
     };
 
     template <class Value, class Key, class HashFcn, class ExtractKey, class Equal, class Alloc = STL::pool_alloc>
@@ -24,7 +44,6 @@ namespace STL
     struct hashtable_iterator
     {
         using Node              = hashtable_node<Value>;
-        using Hashtable         = hashtable<Value, Key, HashFcn, ExtractKey, Equal, Alloc>;
         using iterator          = hashtable_iterator<Value, Key, HashFcn, ExtractKey, Equal, Alloc>;
 
         using iterator_category = STL::forward_iterator_tag;
@@ -35,24 +54,17 @@ namespace STL
         using reference         = value_type&;
         
         Node* cur;      // 迭代器目前指向的节点
-        Hashtable* ht;  // 保持对容器的连接
 
-        hashtable_iterator() : cur(nullptr), ht(nullptr) { }
-        hashtable_iterator(Node* n, Hashtable* tab) : cur(n), ht(tab) { }
+        hashtable_iterator() : cur(nullptr) { }
+        explicit hashtable_iterator(Node* n) : cur(n) { }
 
         reference operator*() const { return cur->val; }
         pointer operator->() const { return &(operator*()); }
         
+        // 所有节点位于同一条链表上，无需再逐个扫描空桶
         iterator& operator++() 
         {
-            const Node* old = cur;
-            cur = cur->next;
-            if (cur == nullptr) {
-                // 根据元素值，定位出下一个bucket
-                size_type bucket = ht->bkt_num(old->val);
-                while (cur == nullptr && ++bucket < ht->buckets.size())
-                    cur = ht->buckets[bucket];
-            }
+            cur = cur->M_next();
             return *this;
         }  
 
@@ -71,7 +83,6 @@ namespace STL
     struct hashtable_const_iterator 
     {
         using Node              = hashtable_node<Value>;
-        using Hashtable         = hashtable<Value, Key, HashFcn, ExtractKey, Equal, Alloc>;
         using iterator          = hashtable_iterator<Value, Key, HashFcn, ExtractKey, Equal, Alloc>;
         using const_iterator    = hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, Equal, Alloc>;
 
@@ -83,34 +94,26 @@ namespace STL
         using reference         = const value_type&;
         
         const Node* cur;      // 迭代器目前指向的节点
-        const Hashtable* ht;  // 保持对容器的连接
 
-        hashtable_const_iterator() : cur(nullptr), ht(nullptr) { }
-        hashtable_const_iterator(const Node* n, const Hashtable* tab) : cur(n), ht(tab) { }
-        hashtable_const_iterator(const iterator& it) : cur(it.cur), ht(it.ht) { }
+        hashtable_const_iterator() : cur(nullptr) { }
+        explicit hashtable_const_iterator(const Node* n) : cur(n) { }
+        hashtable_const_iterator(const iterator& it) : cur(it.cur) { }
 
         reference operator*() const { return cur->val; }
         pointer operator->() const { return &(operator*()); }
 
         iterator M_const_cast() const 
-        { return iterator(const_cast<Node*>(cur), const_cast<Hashtable*>(ht)); }
+        { return iterator(const_cast<Node*>(cur)); }
 
         const_iterator& operator++()
         {
-            const Node* old = cur;
-            cur = cur->next;
-            if (cur == nullptr) {
-                // 根据元素值，定位出下一个bucket
-                size_type bucket = ht->bkt_num(old->val);
-                while (cur == nullptr && ++bucket < ht->buckets.size())
-                    cur = ht->buckets[bucket];
-            }
+            cur = cur->M_next();
             return *this;
         }  
 
         const_iterator operator++(int)
         {
-            iterator tmp = *this;
+            const_iterator tmp = *this;
             ++*this;
             return tmp;
         }
@@ -136,7 +139,37 @@ namespace STL
         return pos == last ? *(last - 1) : *pos;
     }
 
-    
+    // 预取地址p所在的缓存行，不支持的编译器上什么也不做
+    inline void prefetch(const void* p)
+    {
+#if defined(__GNUC__)
+        __builtin_prefetch(p);
+#else
+        (void)p;
+#endif
+    }
+
+    /**
+     *  hashtable的桶分布统计，由hashtable::stats()生成，用于发现分布不均的hash函数
+     *
+     *  探测代价以比较的节点个数计：
+     *  probes_hit为查找已有键值的平均代价，各键值等概率被查找，长为L的链共贡献L(L+1)/2
+     *  probes_miss为查找不存在的键值的平均代价，假设待查键值与已有键值落入各桶的分布相同
+     *  hash函数均匀时二者分别约为1 + α/2与1 + α（α为负载系数），明显偏大说明元素聚集在少数桶中
+     */
+    struct hashtable_stats
+    {
+        size_t          element_count;
+        size_t          bucket_count;
+        size_t          empty_buckets;
+        size_t          max_chain;          // 最长的桶内节点个数
+        float           empty_bucket_ratio;
+        double          probes_hit;
+        double          probes_miss;
+        vector<size_t>  chain_histogram;    // chain_histogram[L]为含L个节点的桶的个数，大小为max_chain + 1
+    };
+
+
     /**
      *  Hashtable模板类
      *
@@ -147,13 +180,17 @@ namespace STL
      *  @tparam  Equal      判断键值是否相同的函数对象
      *  @tparam  Alloc      空间分配器
      *
+     *  所有节点串接在以before_begin为头的单向链表上，同一个桶内的节点在链表中连续
+     *  buckets[n]不直接指向桶n的首节点，而是指向其前一个节点（桶为空时为nullptr）
+     *  因此begin()为O(1)，遍历整个hashtable的代价只与节点个数有关，与桶数无关
      */ 
     template <class Value, class Key, class HashFcn,
               class ExtractKey, class Equal, class Alloc>
     class hashtable
     {
+        using Node_base         = hashtable_node_base;
         using Node              = hashtable_node<Value>;
-        using Bucket_type       = STL::vector<Node*, Alloc>;
+        using Bucket_type       = STL::vector<Node_base*, Alloc>;
 
     public:
         using value_type        = Value;
@@ -180,14 +217,27 @@ namespace STL
         key_equal   equal;
         ExtractKey  get_key;
         Bucket_type buckets;
+        Node_base   before_begin;   // 链表头哨兵，before_begin.next为首节点
         size_type   num_elements;
+        float       max_load;       // 最大负载系数，元素个数超过 桶数 * max_load 时重建table
 
     public:
         using iterator          = hashtable_iterator<value_type, key_type, hasher, ExtractKey, key_equal, Alloc>;
         using const_iterator    = hashtable_const_iterator<value_type, key_type, hasher, ExtractKey, key_equal, Alloc>;
-        // 使迭代器能访问hashtable的私有数据成员
-        friend struct hashtable_iterator<value_type, key_type, hasher, ExtractKey, key_equal, Alloc>;
-        friend struct hashtable_const_iterator<value_type, key_type, hasher, ExtractKey, key_equal, Alloc>;
+        using node_type         = node_handle<value_type, Node, Alloc>;
+        using insert_return_type = node_insert_return<iterator, node_type>;
+
+    private:
+        // hash函数与键值相等性函数都声明了is_transparent时，查找接口接受任意类型K，避免构造临时key_type
+        template <class K>
+        using transparent_key = typename std::enable_if<STL::is_transparent<HashFcn>::value &&
+                                                        STL::is_transparent<Equal>::value, K>::type;
+
+        // erase的异构版本还须排除能转换为迭代器的K，以免与erase(const_iterator)冲突
+        template <class K>
+        using transparent_erase_key = typename std::enable_if<!std::is_convertible<K, iterator>::value &&
+                                                              !std::is_convertible<K, const_iterator>::value,
+                                                              transparent_key<K>>::type;
 
     protected:
         // 创建节点 = 分配内存 + 构造节点
@@ -201,6 +251,7 @@ namespace STL
                 return n;
             } catch(...) {
                 put_node(n);
+                throw;
             }
         }
 
@@ -216,27 +267,27 @@ namespace STL
         {
             const size_type n_buckets = next_prime(n);
             buckets.reserve(n_buckets);
-            buckets.insert(buckets.end(), n_buckets, static_cast<Node*>(nullptr));
+            buckets.insert(buckets.end(), n_buckets, static_cast<Node_base*>(nullptr));
+            before_begin.next = nullptr;
             num_elements = 0;
         }
 
-        // 复制
+        // 复制，按链表顺序逐个复制节点，并记录每个桶首节点的前驱
         void copy_from(const hashtable& ht)
         {
             buckets.clear();    // 请空buckets vector 
             buckets.reserve(ht.buckets.size());
-            buckets.insert(buckets.end(), ht.buckets.size(), static_cast<Node*>(nullptr));
+            buckets.insert(buckets.end(), ht.buckets.size(), static_cast<Node_base*>(nullptr));
+            before_begin.next = nullptr;
             try {
-                for (size_type i = 0; i < ht.buckets.size(); ++i) {
-                    if (const Node* cur = ht.buckets[i]) {  // 当前桶的链表不为空（有节点）
-                        Node* copy = create_node(cur->val);
-                        buckets[i] = copy;
-                        // 复制整个链表
-                        for (Node* next = cur->next; next; cur = next, next = cur->next) {
-                            copy->next = create_node(next->val);
-                            copy = copy->next;
-                        }
-                    }
+                Node_base* prev = &before_begin;
+                for (const Node* cur = ht.M_begin(); cur; cur = cur->M_next()) {
+                    Node* copy = create_node(cur->val);
+                    prev->next = copy;
+                    size_type n = bkt_num(copy->val);
+                    if (buckets[n] == nullptr)
+                        buckets[n] = prev;
+                    prev = copy;
                 }
                 num_elements = ht.num_elements;
             } catch(...) {
@@ -245,6 +296,9 @@ namespace STL
             }
         }
 
+        // 首节点
+        Node* M_begin() const { return static_cast<Node*>(before_begin.next); }
+
         // 判断元素的落脚处
         // 版本一 接受实值x和桶数n
         size_type bkt_num(const value_type& x, size_type n) const 
@@ -253,12 +307,185 @@ namespace STL
         size_type bkt_num(const value_type& x) const 
         { return bkt_num_key(get_key(x)); }
         // 版本三 接受键值k
-        size_type bkt_num_key(const key_type& k) const 
+        template <class K>
+        size_type bkt_num_key(const K& k) const 
         { return bkt_num_key(k, buckets.size()); }
         // 版本四 接受实值和桶数
-        size_type bkt_num_key(const key_type& k, size_type n) const 
+        template <class K>
+        size_type bkt_num_key(const K& k, size_type n) const 
         { return hash(k) % n; }
-        
+
+        // 在#n bucket内查找键值为k的首个节点，返回其前驱；若不存在则返回nullptr
+        template <class K>
+        Node_base* find_before_node(size_type n, const K& k) const 
+        {
+            Node_base* prev = buckets[n];
+            if (prev == nullptr)
+                return nullptr;
+            for (Node* cur = static_cast<Node*>(prev->next); ; cur = cur->M_next()) {
+                if (equal(get_key(cur->val), k))
+                    return prev;
+                // 到达链表尾或下一个节点已属于其他桶
+                if (cur->next == nullptr || bkt_num(cur->M_next()->val) != n)
+                    return nullptr;
+                prev = cur;
+            }
+        }
+
+        // 返回#n bucket内节点p的前驱，p必须位于#n bucket
+        Node_base* get_previous_node(size_type n, const Node* p) const 
+        {
+            Node_base* prev = buckets[n];
+            while (prev->next != p)
+                prev = prev->next;
+            return prev;
+        }
+
+        // 将节点node插入#n bucket的头部
+        void insert_bucket_begin(size_type n, Node* node)
+        {
+            if (buckets[n]) {
+                // 桶非空，插在桶首节点的前驱之后
+                node->next = buckets[n]->next;
+                buckets[n]->next = node;
+            } else {
+                // 桶为空，插在整条链表的头部，原首节点所在桶的前驱改为node
+                node->next = before_begin.next;
+                before_begin.next = node;
+                if (node->next)
+                    buckets[bkt_num(node->M_next()->val)] = node;
+                buckets[n] = &before_begin;
+            }
+        }
+
+        // #n bucket的首节点被移除后，next为其后继，next_n为next所在的桶
+        // 若#n bucket因此变空，则将其前驱交给next所在的桶
+        void remove_bucket_begin(size_type n, Node* next, size_type next_n)
+        {
+            if (next == nullptr || next_n != n) {
+                if (next)
+                    buckets[next_n] = buckets[n];
+                buckets[n] = nullptr;
+            }
+        }
+
+        // 将#n bucket内的节点cur从链表上摘下，prev为cur的前驱，不析构也不释放cur
+        Node* extract_node(size_type n, Node_base* prev, Node* cur)
+        {
+            Node* next = cur->M_next();
+            if (prev == buckets[n])
+                remove_bucket_begin(n, next, next ? bkt_num(next->val) : 0);
+            else if (next) {
+                const size_type next_n = bkt_num(next->val);
+                if (next_n != n)
+                    buckets[next_n] = prev;
+            }
+            prev->next = next;
+            cur->next = nullptr;
+            --num_elements;
+            return cur;
+        }
+
+        // 移除#n bucket内[first, last)范围的节点，prev为first的前驱
+        // 范围可以跨越多个桶，last为nullptr表示直到链表尾
+        Node* erase_nodes(size_type n, Node_base* prev, Node* first, Node* last)
+        {
+            bool is_bucket_begin = (prev == buckets[n]);
+            size_type next_n = n;
+            Node* cur = first;
+            for (;;) {
+                // 移除当前桶内属于范围的节点
+                do {
+                    Node* tmp = cur;
+                    cur = cur->M_next();
+                    drop_node(tmp);
+                    --num_elements;
+                    if (cur == nullptr)
+                        break;
+                    next_n = bkt_num(cur->val);
+                } while (cur != last && next_n == n);
+                if (is_bucket_begin)
+                    remove_bucket_begin(n, cur, next_n);
+                if (cur == last)
+                    break;
+                // 进入下一个桶，此后的桶都从首节点开始删除
+                is_bucket_begin = true;
+                n = next_n;
+            }
+            // 剩余节点所在的桶若与prev不同，或其首节点已被删除，则前驱改为prev
+            if (cur && (next_n != n || is_bucket_begin))
+                buckets[next_n] = prev;
+            prev->next = cur;
+            return cur;
+        }
+
+        // 摘下一个键值等于k的节点
+        template <class K>
+        node_type extract_key(const K& k)
+        {
+            const size_type n = bkt_num_key(k);
+            Node_base* prev = find_before_node(n, k);
+            if (prev == nullptr)
+                return node_type();
+            return node_type(extract_node(n, prev, static_cast<Node*>(prev->next)));
+        }
+
+        // 移除键值等于k的所有节点
+        template <class K>
+        size_type erase_key(const K& k)
+        {
+            const size_type n = bkt_num_key(k);
+            Node_base* prev = find_before_node(n, k);
+            if (prev == nullptr)
+                return 0;
+            // 键值相同的节点相邻，先确定范围再删除，避免k引用被删除的节点
+            Node* first = static_cast<Node*>(prev->next);
+            Node* last = first->M_next();
+            size_type erased = 1;
+            for ( ; last && equal(get_key(last->val), get_key(first->val)); last = last->M_next())
+                ++erased;
+            erase_nodes(n, prev, first, last);
+            return erased;
+        }
+
+        // 重建table，将所有节点按新的桶数n重新串接
+        void rehash_aux(size_type n)
+        {
+            Bucket_type tmp(n, static_cast<Node_base*>(nullptr));
+            Node* p = M_begin();
+            before_begin.next = nullptr;
+            size_type begin_bkt = 0;    // 当前链表首节点所在的新桶
+            try {
+                while (p) {
+                    Node* next = p->M_next();
+                    size_type new_bucket = bkt_num(p->val, n);  // 找出节点落在哪个新bucket内
+                    if (tmp[new_bucket] == nullptr) {
+                        // 新桶为空，将p插在链表头部
+                        p->next = before_begin.next;
+                        before_begin.next = p;
+                        tmp[new_bucket] = &before_begin;
+                        if (p->next)
+                            tmp[begin_bkt] = p;
+                        begin_bkt = new_bucket;
+                    } else {
+                        // 新桶非空，插在桶首节点之前，键值相同的节点依然保持相邻
+                        p->next = tmp[new_bucket]->next;
+                        tmp[new_bucket]->next = p;
+                    }
+                    p = next;
+                }
+                buckets.swap(tmp);
+            } catch(...) {
+                // 若操作失败，则删除所有节点
+                while (p) {
+                    Node* next = p->M_next();
+                    drop_node(p);
+                    p = next;
+                }
+                clear();
+                throw;
+            }
+        }
 
     public:
         // The big five
@@ -267,22 +494,22 @@ namespace STL
          *  @brief  constructor
          */
         hashtable(size_type n)
-        : hash(HashFcn()), equal(Equal()), get_key(ExtractKey()), num_elements(0) 
+        : hash(HashFcn()), equal(Equal()), get_key(ExtractKey()), num_elements(0), max_load(1.0f)
         { initialize_buckets(n); }
 
         hashtable(size_type n, const HashFcn& hf, const Equal& eql)
-        : hash(hf), equal(eql), get_key(ExtractKey()), num_elements(0) 
+        : hash(hf), equal(eql), get_key(ExtractKey()), num_elements(0), max_load(1.0f)
         { initialize_buckets(n); }
 
         hashtable(size_type n, const HashFcn& hf, const Equal& eql, const ExtractKey& ext)
-        : hash(hf), equal(eql), get_key(ext), num_elements(0) 
+        : hash(hf), equal(eql), get_key(ext), num_elements(0), max_load(1.0f)
         { initialize_buckets(n); }
 
         /**
          *  @brief  copy constructor
          */ 
         hashtable(const hashtable& ht)
-        : hash(ht.hash), equal(ht.equal), get_key(ht.get_key), num_elements(0)
+        : hash(ht.hash), equal(ht.equal), get_key(ht.get_key), num_elements(0), max_load(ht.max_load)
         { copy_from(ht); }
 
         /**
@@ -295,6 +522,7 @@ namespace STL
                 hash = ht.hash;
                 equal = ht.equal;
                 get_key = ht.get_key;
+                max_load = ht.max_load;
                 copy_from(ht);
             }
             return *this;
@@ -306,73 +534,35 @@ namespace STL
         ~hashtable() { clear(); }
 
     protected:
+        // 容纳n个元素而不超过最大负载系数所需的最少桶数
+        size_type bkt_for_elements(size_type n) const
+        { return static_cast<size_type>(std::ceil(static_cast<float>(n) / max_load)); }
+
         // 判断是否需要重建table，避免桶太少以至于冲突过多
-        // 将节点个数（计入新增节点）与bucket vector的大小对比，若前者大于后者，则重建table
-        // 因此每个bucket（链表）的最大容量与bucket vector的大小相同
+        // 将节点个数（计入新增节点）与 桶数 * 最大负载系数 对比，若前者大于后者，则重建table
         void resize(size_type num_elements_hint)
         {
             const size_type old_n = buckets.size();
-            if (num_elements_hint > old_n) {    // 需要重新配置table
-                const size_type n = next_prime(num_elements_hint);
-                if (n > old_n) {
-                    Bucket_type tmp(n, static_cast<Node*>(nullptr));
-                    try {
-                        for (size_type bid = 0; bid < old_n; ++bid) {
-                            Node* first = buckets[bid];
-                            // 处理每个旧bucket所含的每个节点
-                            while (first) {
-                                size_type new_bucket = bkt_num(first->val, n);  // 找出节点落在哪个新bucket内
-                                // (1) 令旧bucket指向下一个节点
-                                buckets[bid] = first->next;
-                                // (2)(3) 将当前节点first前插进新bucket中
-                                first->next = tmp[new_bucket];
-                                tmp[new_bucket] = first;
-                                // (4) 回到旧bucket的下一个待处理节点处
-                                first = buckets[bid];
-                            }
-                        }
-                        buckets.swap(tmp);
-                    } catch(...) {
-                        // 若操作失败，则删除新hashtable内的所有节点
-                        for (size_type bid = 0; bid < tmp.size(); ++bid) {
-                            while (tmp[bid]) {
-                                Node* next = tmp[bid]->next;
-                                drop_node(tmp[bid]);
-                                tmp[bid] = next;
-                            }
-                        }
-                        throw;
-                    }
-                }
+            if (num_elements_hint > old_n * max_load) {     // 需要重新配置table
+                const size_type n = next_prime(bkt_for_elements(num_elements_hint));
+                if (n > old_n)
+                    rehash_aux(n);
             }
         }
     
     public:
         // 迭代器
-        iterator begin()
-        {
-            // 找到第一个非空的桶，获取第一个节点
-            for (size_type i = 0; i < buckets.size(); ++i)
-                if (buckets[i])
-                    return iterator(buckets[i], this);
-            return end();
-        } 
+        iterator begin() { return iterator(M_begin()); } 
         
-        const_iterator begin() const
-        {
-            for (size_type i = 0; i < buckets.size(); ++i)
-                if (buckets[i])
-                    return const_iterator(buckets[i], this);
-            return cend();
-        }
+        const_iterator begin() const { return const_iterator(M_begin()); }
 
-        const_iterator cbegin() const { return const_iterator(begin()); }
+        const_iterator cbegin() const { return const_iterator(M_begin()); }
 
-        iterator end() { return iterator(nullptr, this); }
+        iterator end() { return iterator(nullptr); }
 
-        const_iterator end() const { return const_iterator(nullptr, this); }
+        const_iterator end() const { return const_iterator(nullptr); }
 
-        const_iterator cend() const { return const_iterator(nullptr, this); }
+        const_iterator cend() const { return const_iterator(nullptr); }
 
     public:
         // 容量
@@ -383,45 +573,74 @@ namespace STL
     public:
         // 不需要重建table的情况下插入新节点，键值不允许重复
         pair<iterator, bool> insert_unique_noresize(const value_type& x)
+        { return emplace_unique_key_noresize(get_key(x), x); }
+
+        // 不需要重建table的情况下插入新节点，键值允许重复
+        iterator insert_equal_noresize(const value_type& x)
+        { return insert_equal_node(create_node(x)); }
+
+    protected:
+        // 不需要重建table的情况下，先以键值k查找，仅当k不存在时才以args构造新节点
+        template <class K, class... Args>
+        pair<iterator, bool> emplace_unique_key_noresize(const K& k, Args&&... args)
         {
-            const size_type n = bkt_num(x);     // x应位于#n bucket 
-            Node* first = buckets[n];
-            // buckets[n]被占用
-            for (Node* cur = first; cur; cur = cur->next) {
-                if (equal(get_key(cur->val), get_key(x)))   // 若与链表中某键值相同，则立即返回
-                    return pair<iterator, bool>(iterator(cur, this), false);
-            }
-            // 未进入循环（buckets[n]未被占用）离开循环（无重复键值）
-            Node* tmp = create_node(x);
-            tmp->next = first;
-            buckets[n] = tmp;   // 创建新节点前插进buckets[n]的链表头
+            const size_type n = bkt_num_key(k);     // 新节点应位于#n bucket 
+            // 若与桶中某键值相同，则立即返回，不构造节点
+            if (Node_base* prev = find_before_node(n, k))
+                return pair<iterator, bool>(iterator(static_cast<Node*>(prev->next)), false);
+            // 无重复键值，创建新节点插进#n bucket的头部
+            Node* tmp = create_node(std::forward<Args>(args)...);
+            insert_bucket_begin(n, tmp);
             ++num_elements;
-            return pair<iterator, bool>(iterator(tmp, this), true);
+            return pair<iterator, bool>(iterator(tmp), true);
         }
 
-        // 不需要重建table的情况下插入新节点，键值允许重复
-        iterator insert_equal_noresize(const value_type& x)
+        // 插入已构造好的节点node，键值不允许重复，若重复则删除node
+        pair<iterator, bool> insert_unique_node(Node* node)
         {
-            const size_type n = bkt_num(x);     // x应位于#n bucket 
-            Node* first = buckets[n];
-            // buckets[n]被占用
-            for (Node* cur = first; cur; cur = cur->next) {
-                if (equal(get_key(cur->val), get_key(x))) {     // 若与链表中某键值相同，则立即插入
-                    Node* tmp = create_node(x);
-                    tmp->next = cur->next;
-                    cur->next = tmp;    // 将新节点插入重复节点之后
-                    ++num_elements;
-                    return iterator(tmp, this);
-                }
+            const size_type n = bkt_num(node->val);
+            if (Node_base* prev = find_before_node(n, get_key(node->val))) {
+                drop_node(node);
+                return pair<iterator, bool>(iterator(static_cast<Node*>(prev->next)), false);
             }
-            // 未发现重复的键值
-            Node* tmp = create_node(x);
-            tmp->next = first;
-            buckets[n] = tmp;   // 创建新节点前插进buckets[n]的链表头
+            insert_bucket_begin(n, node);
+            ++num_elements;
+            return pair<iterator, bool>(iterator(node), true);
+        }
+
+        // 插入已构造好的节点node，键值允许重复
+        iterator insert_equal_node(Node* node)
+        {
+            const size_type n = bkt_num(node->val);
+            if (Node_base* prev = find_before_node(n, get_key(node->val))) {
+                // 若与桶中某键值相同，则插入在重复节点之前，使键值相同的节点相邻
+                node->next = prev->next;
+                prev->next = node;
+            } else 
+                insert_bucket_begin(n, node);
             ++num_elements;
-            return iterator(tmp, this);
+            return iterator(node);
+        }
+
+        // 从emplace的首个实参中取得键值
+        const key_type& emplace_key(const key_type& k, STL::true_type) const { return k; }
+        const key_type& emplace_key(const value_type& x, STL::false_type) const { return get_key(x); }
+
+        // 实参能直接给出键值，先查找再构造节点
+        template <class Arg, class... Args>
+        pair<iterator, bool> emplace_unique_aux(STL::true_type, Arg&& arg, Args&&... args)
+        {
+            using is_key = STL::integral_constant<bool, !STL::emplace_is_value<value_type, Arg, Args...>::value>;
+            return emplace_unique_key_noresize(emplace_key(arg, is_key()),
+                                               std::forward<Arg>(arg), std::forward<Args>(args)...);
         }
 
+        // 否则只能先构造节点，才能取得键值
+        template <class... Args>
+        pair<iterator, bool> emplace_unique_aux(STL::false_type, Args&&... args)
+        { return insert_unique_node(create_node(std::forward<Args>(args)...)); }
+
+    public:
         // 插入来自范围[first, last)的元素，键值不允许重复
         // input_iterator版本
         template <class InputIterator>
@@ -458,36 +677,189 @@ namespace STL
                 insert_equal_noresize(*first);
         }
 
-        // 移除 #n bucket 内[first, last)范围的节点
-        void erase_bucket(const size_type n, Node* first, Node* last) 
-        {
-            Node* cur = buckets[n];
-            // 头节点特殊处理
-            if (cur == first)
-                erase_bucket(n, last);
-            else {
-                Node* next;
-                for (next = cur->next; next != first; cur = next, next = cur->next);
-                while (next != last) {
-                    cur->next = next->next;
-                    drop_node(next);
-                    next = cur->next;
-                    --num_elements;
-                }
-            }
+        /**
+         *  @brief  并行插入来自范围[first, last)的元素，键值不允许重复
+         *  @param  threads  线程数，0表示使用硬件线程数
+         *
+         *  与逐个插入的结果相同：已存在的元素及范围内先出现的元素优先
+         *  元素太少或只有一个线程时退化为insert_unique(first, last)
+         */
+        template <class RandomAccessIterator>
+        void insert_unique_parallel(RandomAccessIterator first, RandomAccessIterator last, unsigned threads = 0)
+        {
+            const unsigned t = parallel_degree(num_elements + (last - first), threads, parallel_grain);
+            if (t <= 1)
+                insert_unique(first, last, STL::random_access_iterator_tag());
+            else
+                insert_parallel_aux(first, last, t, true);
         }
 
-        // 移除 #n bucket 内[头节点, last)范围的节点
-        void erase_bucket(const size_type n, Node* last)
+        /**
+         *  @brief  并行插入来自范围[first, last)的元素，键值允许重复
+         */
+        template <class RandomAccessIterator>
+        void insert_equal_parallel(RandomAccessIterator first, RandomAccessIterator last, unsigned threads = 0)
         {
-            Node* cur = buckets[n];
-            while (cur != last) {
-                Node* next = cur->next;
-                drop_node(cur);
-                cur = next;
-                buckets[n] = cur;   // 调整 #n bucket 的指向
-                --num_elements;
+            const unsigned t = parallel_degree(num_elements + (last - first), threads, parallel_grain);
+            if (t <= 1)
+                insert_equal(first, last, STL::random_access_iterator_tag());
+            else
+                insert_parallel_aux(first, last, t, false);
+        }
+
+    protected:
+        enum { parallel_grain = 1 << 14 };  // 每个线程至少处理的元素个数
+
+        /**
+         *  并行批量插入，t个线程
+         *  1. 串行：预留足够的桶，为新元素分配节点并构造元素，摘下现有节点
+         *     分配器不一定线程安全，元素的复制也可能经由分配器（如value_type含有vector），因此只在本线程进行
+         *  2. 并行：每个线程负责all中的一段，计算每个节点的桶号，统计落入各分区的节点个数
+         *     桶被均分为t个分区，每个分区是一段连续的桶
+         *  3. 并行：按计数的前缀和，把节点下标稳定地分散到各分区
+         *  4. 并行：每个线程独占一个分区，把分区内的节点挂入各自的桶，再把这些桶串成一段链表
+         *     分区之间没有共享的桶，无需加锁；被拒绝的重复节点以桶号n_buckets标记
+         *  5. 串行：依次连接各分区的链表，设置每个分区首个桶的前驱，释放被拒绝的节点
+         *  与rehash_aux相同，若操作失败则删除所有节点
+         */
+        template <class RandomAccessIterator>
+        void insert_parallel_aux(RandomAccessIterator first, RandomAccessIterator last, unsigned t, bool unique)
+        {
+            const size_type n = static_cast<size_type>(last - first);
+            resize(num_elements + n);
+            const size_type old_n = num_elements;
+            const size_type total = old_n + n;
+            const size_type n_buckets = buckets.size();
+
+            // all中[0, old_n)为现有节点，[old_n, total)为新节点
+            STL::vector<Node*> all(total);
+            STL::vector<size_type> bkt(total);      // 每个节点的桶号
+            STL::vector<size_type> sorted(total);   // 按分区排好的节点下标
+            STL::vector<size_type> counts(size_type(t) * t);
+            STL::vector<Node*> heads(t), tails(t);
+            STL::vector<size_type> first_bkt(t), accepted(t);
+
+            size_type i = 0;
+            for (Node* cur = M_begin(); cur; cur = cur->M_next())
+                all[i++] = cur;
+            try {
+                for ( ; i < total; ++i) {
+                    all[i] = get_node();
+                    try {
+                        STL::construct(&all[i]->val, first[i - old_n]);
+                    } catch(...) {
+                        put_node(all[i]);
+                        throw;
+                    }
+                    all[i]->next = nullptr;
+                }
+            } catch(...) {
+                while (i > old_n)
+                    drop_node(all[--i]);
+                throw;
+            }
+            before_begin.next = nullptr;
+            num_elements = 0;
+            STL::fill(buckets.begin(), buckets.end(), static_cast<Node_base*>(nullptr));
+
+            // 分区p负责桶[lo(p), lo(p + 1))，桶b属于分区b * t / n_buckets
+            auto slice = [total, t](unsigned k) { return total * k / t; };
+            auto lo = [n_buckets, t](unsigned p) { return (n_buckets * p + t - 1) / t; };
+            auto part = [n_buckets, t](size_type b) { return static_cast<unsigned>(b * t / n_buckets); };
+
+            try {
+                parallel_run(t, [&](unsigned k) {
+                    size_type* cnt = &counts[size_type(k) * t];
+                    for (size_type j = slice(k); j < slice(k + 1); ++j) {
+                        bkt[j] = bkt_num(all[j]->val, n_buckets);
+                        ++cnt[part(bkt[j])];
+                    }
+                });
+
+                // counts[k * t + p]变为线程k在分区p中的起始位置
+                size_type offset = 0;
+                for (unsigned p = 0; p < t; ++p) {
+                    for (unsigned k = 0; k < t; ++k) {
+                        size_type c = counts[size_type(k) * t + p];
+                        counts[size_type(k) * t + p] = offset;
+                        offset += c;
+                    }
+                }
+                STL::vector<size_type> part_begin(t + 1);
+                for (unsigned p = 0; p < t; ++p)
+                    part_begin[p] = counts[p];
+                part_begin[t] = total;
+
+                parallel_run(t, [&](unsigned k) {
+                    size_type* pos = &counts[size_type(k) * t];
+                    for (size_type j = slice(k); j < slice(k + 1); ++j)
+                        sorted[pos[part(bkt[j])]++] = j;
+                });
+
+                parallel_run(t, [&](unsigned p) {
+                    // buckets[b]暂时指向桶b的首节点
+                    size_type count = 0;
+                    for (size_type j = part_begin[p]; j < part_begin[p + 1]; ++j) {
+                        const size_type idx = sorted[j];
+                        Node* x = all[idx];
+                        Node_base*& head = buckets[bkt[idx]];
+                        Node* same = static_cast<Node*>(head);
+                        for ( ; same && !equal(get_key(same->val), get_key(x->val)); same = same->M_next())
+                            ;
+                        if (same && unique) {
+                            bkt[idx] = n_buckets;
+                        } else if (same) {
+                            // 挂在第一个键值相同的节点之后，键值相同的节点保持相邻
+                            x->next = same->next;
+                            same->next = x;
+                            ++count;
+                        } else {
+                            x->next = head;
+                            head = x;
+                            ++count;
+                        }
+                    }
+                    // 将分区内的各个桶串成一段链表，buckets[b]改为指向桶首节点的前驱
+                    Node_base* tail = nullptr;
+                    heads[p] = nullptr;
+                    for (size_type b = lo(p); b < lo(p + 1); ++b) {
+                        Node_base* cur = buckets[b];
+                        if (!cur)
+                            continue;
+                        if (tail) {
+                            tail->next = cur;
+                            buckets[b] = tail;
+                        } else {
+                            heads[p] = static_cast<Node*>(cur);
+                            first_bkt[p] = b;
+                        }
+                        while (cur->next)
+                            cur = cur->next;
+                        tail = cur;
+                    }
+                    tails[p] = static_cast<Node*>(tail);
+                    accepted[p] = count;
+                });
+            } catch(...) {
+                for (size_type j = 0; j < total; ++j)
+                    drop_node(all[j]);
+                STL::fill(buckets.begin(), buckets.end(), static_cast<Node_base*>(nullptr));
+                throw;
+            }
+
+            Node_base* prev = &before_begin;
+            for (unsigned p = 0; p < t; ++p) {
+                if (heads[p]) {
+                    prev->next = heads[p];
+                    buckets[first_bkt[p]] = prev;
+                    prev = tails[p];
+                    num_elements += accepted[p];
+                }
             }
+            prev->next = nullptr;
+            for (size_type j = 0; j < total; ++j)
+                if (bkt[j] == n_buckets)
+                    drop_node(all[j]);
         }
 
     public:
@@ -498,15 +870,15 @@ namespace STL
          */ 
         void clear() 
         {
-            for (size_type i = 0; i < buckets.size(); ++i) {
-                Node* cur = buckets[i];
-                while (cur) {
-                    Node* next = cur->next;
-                    drop_node(cur);
-                    cur = next;
-                }
-                buckets[i] = nullptr;
+            Node* cur = M_begin();
+            while (cur) {
+                Node* next = cur->M_next();
+                drop_node(cur);
+                cur = next;
             }
+            for (size_type i = 0; i < buckets.size(); ++i)
+                buckets[i] = nullptr;
+            before_begin.next = nullptr;
             num_elements = 0;
             // buckets vector并未释放空间
         }
@@ -523,6 +895,12 @@ namespace STL
             return insert_unique_noresize(x);
         }
 
+        pair<iterator, bool> insert_unique(value_type&& x) 
+        {
+            resize(num_elements + 1);
+            return emplace_unique_key_noresize(get_key(x), std::move(x));
+        }
+
         /**
          *  @brief   插入来自范围[first, last)的元素，键值不允许重复
          */ 
@@ -540,6 +918,12 @@ namespace STL
             return insert_equal_noresize(x);
         }
 
+        iterator insert_equal(value_type&& x) 
+        {
+            resize(num_elements + 1);
+            return insert_equal_node(create_node(std::move(x)));
+        }
+
         /**
          *  @brief   插入来自范围[first, last)的元素，键值允许重复
          */ 
@@ -547,30 +931,178 @@ namespace STL
         void insert_equal(InputIterator first, InputIterator last)
         { insert_equal(first, last, STL::iterator_category(first)); }
 
+        /**
+         *  @brief  以args原地构造元素，不允许重复
+         *  @return  pair<iterator, bool>，含义同insert_unique
+         *
+         *  若唯一实参即为元素值，或map形式的元素以键值为首个实参，则先查找，键值已存在时不构造节点
+         */
+        template <class... Args>
+        pair<iterator, bool> emplace_unique(Args&&... args)
+        {
+            resize(num_elements + 1);
+            return emplace_unique_aux(STL::emplace_has_key<key_type, value_type, ExtractKey, Args...>(),
+                                      std::forward<Args>(args)...);
+        }
+
+        /**
+         *  @brief  以args原地构造元素，允许重复
+         */
+        template <class... Args>
+        iterator emplace_equal(Args&&... args)
+        {
+            resize(num_elements + 1);
+            return insert_equal_node(create_node(std::forward<Args>(args)...));
+        }
+
+        /**
+         *  @brief  若键值k不存在，则以k和args原地构造元素pair(k, T(args...))
+         *  @return  pair<iterator, bool>，含义同insert_unique
+         *
+         *  仅适用于value_type为pair<const Key, T>的情形，键值已存在时不构造节点，也不移动k和args
+         */
+        template <class... Args>
+        pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        {
+            resize(num_elements + 1);
+            return emplace_unique_key_noresize(k, std::piecewise_construct,
+                                               std::forward_as_tuple(k),
+                                               std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        template <class... Args>
+        pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+        {
+            resize(num_elements + 1);
+            return emplace_unique_key_noresize(k, std::piecewise_construct,
+                                               std::forward_as_tuple(std::move(k)),
+                                               std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        /**
+         *  @brief  若键值k不存在，则插入pair(k, obj)；否则将obj赋值给已有元素的实值
+         *  @return  pair<iterator, bool>，bool表示是否插入了新元素
+         *
+         *  仅适用于value_type为pair<const Key, T>的情形
+         */
+        template <class M>
+        pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        {
+            pair<iterator, bool> p = try_emplace(k, std::forward<M>(obj));
+            if (!p.second)
+                p.first->second = std::forward<M>(obj);
+            return p;
+        }
+
+        template <class M>
+        pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj)
+        {
+            pair<iterator, bool> p = try_emplace(std::move(k), std::forward<M>(obj));
+            if (!p.second)
+                p.first->second = std::forward<M>(obj);
+            return p;
+        }
+
         /**
          *  @brief  移除位于pos的节点
          *  @return  被移除节点的下一个节点的迭代器
          */ 
         iterator erase(const_iterator pos) 
         {
-            iterator position = pos.M_const_cast();
-            Node* p = position.cur;
-            if (p) {
-                ++position;
-                const size_type n = bkt_num(p->val);
-                Node** first = &buckets[n];     // 找到pos对应的桶
-                while (*first) {
-                    Node* cur = *first;
-                    if (cur == p) {
-                        *first = cur->next;
-                        drop_node(cur);
-                        --num_elements;
-                        break;
-                    } else 
-                        first = &(cur->next);
+            Node* p = pos.M_const_cast().cur;
+            if (p == nullptr)
+                return end();
+            const size_type n = bkt_num(p->val);
+            Node_base* prev = get_previous_node(n, p);     // 在pos对应的桶内找到其前驱
+            return iterator(erase_nodes(n, prev, p, p->M_next()));
+        }
+
+        /**
+         *  @brief  将pos所指节点从hashtable中摘下，交给节点句柄
+         */
+        node_type extract(const_iterator pos)
+        {
+            Node* p = pos.M_const_cast().cur;
+            const size_type n = bkt_num(p->val);
+            return node_type(extract_node(n, get_previous_node(n, p), p));
+        }
+
+        /**
+         *  @brief  摘下一个键值等于k的节点，不存在时返回空句柄
+         */
+        node_type extract(const key_type& k)
+        { return extract_key(k); }
+
+        template <class K, class = transparent_erase_key<K>>
+        node_type extract(const K& k)
+        { return extract_key(k); }
+
+        /**
+         *  @brief  插入节点句柄所持的节点，键值不允许重复
+         *
+         *  插入成功时句柄变空；键值已存在时节点留在返回值的node中，position指向已有元素
+         */
+        insert_return_type insert_unique(node_type&& nh)
+        {
+            if (nh.empty())
+                return insert_return_type{end(), false, node_type()};
+            resize(num_elements + 1);
+            const size_type n = bkt_num(nh.value());
+            if (Node_base* prev = find_before_node(n, get_key(nh.value())))
+                return insert_return_type{iterator(static_cast<Node*>(prev->next)), false, std::move(nh)};
+            Node* node = nh.release();
+            insert_bucket_begin(n, node);
+            ++num_elements;
+            return insert_return_type{iterator(node), true, node_type()};
+        }
+
+        /**
+         *  @brief  插入节点句柄所持的节点，键值允许重复
+         */
+        iterator insert_equal(node_type&& nh)
+        {
+            if (nh.empty())
+                return end();
+            resize(num_elements + 1);
+            return insert_equal_node(nh.release());
+        }
+
+        /**
+         *  @brief  将src中键值在*this中不存在的节点逐个摘下并挂入*this，键值不允许重复
+         *
+         *  不分配内存也不复制实值，键值重复的节点留在src中
+         */
+        template <class HashFcn2, class Equal2>
+        void merge_unique(hashtable<Value, Key, HashFcn2, ExtractKey, Equal2, Alloc>& src)
+        {
+            if (static_cast<void*>(&src) == static_cast<void*>(this))
+                return;
+            resize(num_elements + src.size());
+            for (auto it = src.begin(); it != src.end(); ) {
+                const size_type n = bkt_num(*it);
+                if (find_before_node(n, get_key(*it))) {
+                    ++it;
+                    continue;
                 }
+                auto next = it;
+                ++next;
+                insert_bucket_begin(n, src.extract(it).release());
+                ++num_elements;
+                it = next;
             }
-            return position;
+        }
+
+        /**
+         *  @brief  将src中的所有节点摘下并挂入*this，键值允许重复
+         */
+        template <class HashFcn2, class Equal2>
+        void merge_equal(hashtable<Value, Key, HashFcn2, ExtractKey, Equal2, Alloc>& src)
+        {
+            if (static_cast<void*>(&src) == static_cast<void*>(this))
+                return;
+            resize(num_elements + src.size());
+            while (!src.empty())
+                insert_equal_node(src.extract(src.begin()).release());
         }
 
         /**
@@ -581,22 +1113,12 @@ namespace STL
          */
         iterator erase(const_iterator first, const_iterator last) 
         {
-            iterator f = first.M_const_cast(), l = last.M_const_cast();
-            size_type f_bucket = f.cur ? bkt_num(f.cur->val) : buckets.size();
-            size_type l_bucket = l.cur ? bkt_num(l.cur->val) : buckets.size();
-            if (f.cur == l.cur)
-                return l;
-            else if (f_bucket == l_bucket)  // 删除区间位于同一个桶内
-                erase_bucket(f_bucket, f.cur, l.cur);
-            else {
-                // 区间内的每个桶作合适的删除
-                erase_bucket(f_bucket, f.cur, nullptr);
-                for (size_type n = f_bucket + 1; n < l_bucket; ++n)
-                    erase_bucket(n, nullptr);
-                if (l_bucket != buckets.size())
-                    erase_bucket(l_bucket, l.cur);
-            }
-            return l;
+            Node* f = first.M_const_cast().cur;
+            Node* l = last.M_const_cast().cur;
+            if (f == l)
+                return iterator(l);
+            const size_type n = bkt_num(f->val);
+            return iterator(erase_nodes(n, get_previous_node(n, f), f, l));
         }
 
         /**
@@ -604,22 +1126,11 @@ namespace STL
          *  @return  移除的节点个数
          */
         size_type erase(const key_type& k) 
-        {
-            const size_type n = bkt_num_key(k);
-            Node** first = &buckets[n]; // 使用二级指针避免对头结点的另行处理
-            size_type erased = 0;
-            while (*first) {
-                Node* cur = *first;
-                if (equal(get_key(cur->val), k)) {
-                    *first = cur->next;
-                    drop_node(cur);
-                    ++erased;
-                    --num_elements;
-                } else 
-                    first = &(cur->next);
-            }
-            return erased;
-        }
+        { return erase_key(k); }
+
+        template <class K, class = transparent_erase_key<K>>
+        size_type erase(const K& k)
+        { return erase_key(k); }
 
         /**
          *  @brief  与另一个hashtable交换数据
@@ -630,7 +1141,79 @@ namespace STL
             STL::swap(equal, ht.equal);
             STL::swap(get_key, ht.get_key);
             buckets.swap(ht.buckets);
+            STL::swap(before_begin.next, ht.before_begin.next);
             STL::swap(num_elements, ht.num_elements);
+            STL::swap(max_load, ht.max_load);
+            // 首节点所在的桶指向各自的before_begin
+            if (M_begin())
+                buckets[bkt_num(M_begin()->val)] = &before_begin;
+            if (ht.M_begin())
+                ht.buckets[ht.bkt_num(ht.M_begin()->val)] = &ht.before_begin;
+        }
+
+    protected:
+        enum { batch_size = 16 };   // find_batch每组交错处理的键值个数
+
+        template <class K, class Iterator>
+        void find_batch_aux(const K* keys, size_type n, Iterator* out) const
+        {
+            size_type bkt[batch_size];
+            const Node_base* prev[batch_size];
+            for (size_type base = 0; base < n; base += batch_size) {
+                const size_type m = n - base < size_type(batch_size) ? n - base : size_type(batch_size);
+                const K* k = keys + base;
+                for (size_type i = 0; i < m; ++i) {
+                    bkt[i] = bkt_num_key(k[i]);
+                    prefetch(&buckets[bkt[i]]);
+                }
+                for (size_type i = 0; i < m; ++i) {
+                    prev[i] = buckets[bkt[i]];
+                    if (prev[i])
+                        prefetch(prev[i]);
+                }
+                for (size_type i = 0; i < m; ++i)
+                    if (prev[i])
+                        prefetch(prev[i]->next);
+                for (size_type i = 0; i < m; ++i) {
+                    const Node_base* p = prev[i] ? find_before_node(bkt[i], k[i]) : nullptr;
+                    out[base + i] = Iterator(p ? static_cast<Node*>(p->next) : nullptr);
+                }
+            }
+        }
+
+        template <class K>
+        size_type count_key(const K& k) const 
+        {
+            const size_type n = bkt_num_key(k);
+            Node_base* prev = find_before_node(n, k);
+            if (prev == nullptr)
+                return 0;
+            size_type result = 1;
+            for (const Node* cur = static_cast<Node*>(prev->next)->M_next();
+                 cur && equal(get_key(cur->val), k);
+                 cur = cur->M_next())
+                ++result;
+            return result;
+        }
+
+        template <class K>
+        Node* find_node(const K& k) const 
+        {
+            Node_base* prev = find_before_node(bkt_num_key(k), k);
+            return prev ? static_cast<Node*>(prev->next) : nullptr;
+        }
+
+        // 键值相同的节点在链表中相邻，找到首个节点后向后遍历即可
+        template <class K>
+        pair<Node*, Node*> equal_range_node(const K& k) const 
+        {
+            Node* first = find_node(k);
+            if (first == nullptr)
+                return pair<Node*, Node*>(nullptr, nullptr);
+            Node* last = first->M_next();
+            while (last && equal(get_key(last->val), k))
+                last = last->M_next();
+            return pair<Node*, Node*>(first, last);
         }
 
     public:
@@ -640,48 +1223,57 @@ namespace STL
          *  @brief  返回键值为k的节点个数
          */
         size_type count(const key_type& k) const 
-        {
-            const size_type n = bkt_num_key(k);
-            size_type result = 0;
-            for (const Node* cur = buckets[n]; cur; cur = cur->next)
-                if (equal(get_key(cur->val), k))
-                    ++result;
-            return result;
-        }
+        { return count_key(k); }
+
+        template <class K, class = transparent_key<K>>
+        size_type count(const K& k) const 
+        { return count_key(k); }
 
         /**
          *  @brief  查找实值为x的节点，若没有则插入
          *  @return  返回其引用
          */ 
         reference find_or_insert(const value_type& x)
-        {
-            resize(num_elements + 1);
-            
-            size_type n = bkt_num(x);
-            Node* first = buckets[n];
-            for (Node* cur = first; cur; cur = cur->next)
-                if (equal(get_key(cur->val), get_key(x)))
-                    return cur->val;
-
-            Node* tmp = create_node(x);
-            tmp->next = first;
-            buckets[n] = tmp;
-            ++num_elements;
-            return tmp->val;
-        }
+        { return *insert_unique(x).first; }
 
         /**
          *  @brief  返回指向键值为k的节点的迭代器
+         *
+         *  hash函数与键值相等性函数均为transparent时，k可以是任意可与key_type比较的类型
          */ 
         iterator find(const key_type& k) 
-        {
-            const size_type n = bkt_num_key(k);
-            Node* first;
-            for (first = buckets[n];
-                 first && !equal(get_key(first->val), k);
-                 first = first->next) { }
-            return iterator(first, this);
-        }
+        { return iterator(find_node(k)); }
+
+        const_iterator find(const key_type& k) const 
+        { return const_iterator(find_node(k)); }
+
+        template <class K, class = transparent_key<K>>
+        iterator find(const K& k)
+        { return iterator(find_node(k)); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator find(const K& k) const 
+        { return const_iterator(find_node(k)); }
+
+        /**
+         *  @brief  批量查找keys[0, n)，out[i]为keys[i]的查找结果，未找到时为end()
+         *
+         *  每次取batch_size个键值，先全部计算桶号并预取桶，再预取各桶首节点的前驱与首节点，
+         *  最后逐个比较，使多个键值的访存延迟相互重叠
+         */
+        void find_batch(const key_type* keys, size_type n, iterator* out)
+        { find_batch_aux(keys, n, out); }
+
+        void find_batch(const key_type* keys, size_type n, const_iterator* out) const
+        { find_batch_aux(keys, n, out); }
+
+        template <class K, class = transparent_key<K>>
+        void find_batch(const K* keys, size_type n, iterator* out)
+        { find_batch_aux(keys, n, out); }
+
+        template <class K, class = transparent_key<K>>
+        void find_batch(const K* keys, size_type n, const_iterator* out) const
+        { find_batch_aux(keys, n, out); }
 
         /**
          *  @brief  查找hashtable中键值为k的节点范围
@@ -691,45 +1283,28 @@ namespace STL
          */ 
         pair<iterator, iterator> equal_range(const key_type& k)
         {
-            const size_type n = bkt_num_key(k);
-            for (Node* first = buckets[n]; first; first = first->next) {
-                // 找到键与k相同的第一个节点
-                if (equal(get_key(first->val), k)) {
-                    // 遍历该桶，若遇到键与k不同的节点立即返回
-                    for (Node* cur = first->next; cur; cur = cur->next)
-                        if (!equal(get_key(cur->val), k))
-                            return pair<iterator, iterator>(iterator(first, this),
-                                                            iterator(cur, this));
-                    // 该桶从first到链尾的键都等于k
-                    for (size_type m = n + 1; m < buckets.size(); ++m)
-                        if (buckets[m])
-                            return pair<iterator, iterator>(iterator(first, this),
-                                                            iterator(buckets[m], this));
-                    return pair<iterator, iterator>(iterator(first, this),
-                                                    end());
-                }
-            }
-            return pair<iterator, iterator>(end(), end());
+            pair<Node*, Node*> p = equal_range_node(k);
+            return pair<iterator, iterator>(iterator(p.first), iterator(p.second));
         }
 
         pair<const_iterator, const_iterator> equal_range(const key_type& k) const
         {
-            const size_type n = bkt_num_key(k);
-            for (const Node* first = buckets[n]; first; first = first->next) {
-                if (equal(get_key(first->val), k)) {
-                    for (const Node* cur = first->next; cur; cur = cur->next)
-                        if (!equal(get_key(cur->val), k))
-                            return pair<const_iterator, const_iterator>(const_iterator(first, this),
-                                                                        const_iterator(cur, this));
-                    for (size_type m = n + 1; m < buckets.size(); ++m)
-                        if (buckets[m])
-                            return pair<const_iterator, const_iterator>(const_iterator(first, this),
-                                                                        const_iterator(buckets[m], this));
-                    return pair<const_iterator, const_iterator>(const_iterator(first, this),
-                                                                end());
-                }
-            }
-            return pair<const_iterator, const_iterator>(end(), end());
+            pair<Node*, Node*> p = equal_range_node(k);
+            return pair<const_iterator, const_iterator>(const_iterator(p.first), const_iterator(p.second));
+        }
+
+        template <class K, class = transparent_key<K>>
+        pair<iterator, iterator> equal_range(const K& k)
+        {
+            pair<Node*, Node*> p = equal_range_node(k);
+            return pair<iterator, iterator>(iterator(p.first), iterator(p.second));
+        }
+
+        template <class K, class = transparent_key<K>>
+        pair<const_iterator, const_iterator> equal_range(const K& k) const
+        {
+            pair<Node*, Node*> p = equal_range_node(k);
+            return pair<const_iterator, const_iterator>(const_iterator(p.first), const_iterator(p.second));
         }
 
     public:
@@ -742,12 +1317,50 @@ namespace STL
          */ 
         size_type bucket_size(size_type n) const 
         {
+            if (buckets[n] == nullptr)
+                return 0;
             size_type result = 0;
-            for (Node* cur = buckets[n]; cur; cur = cur->next)
+            for (const Node* cur = static_cast<Node*>(buckets[n]->next);
+                 cur && bkt_num(cur->val) == n;
+                 cur = cur->M_next())
                 ++result;
             return result;
         }
 
+        /**
+         *  @brief  统计各桶的节点个数，O(元素个数 + 桶数)
+         *
+         *  同一个桶内的节点在链表中连续，沿链表走一遍即可得到每条链的长度
+         */
+        hashtable_stats stats() const
+        {
+            hashtable_stats st;
+            st.element_count = num_elements;
+            st.bucket_count = buckets.size();
+            st.max_chain = 0;
+            st.chain_histogram.push_back(st.bucket_count);
+            size_type sum_hit = 0, sum_miss = 0;
+            for (const Node* cur = static_cast<const Node*>(before_begin.next); cur; ) {
+                const size_type n = bkt_num(cur->val);
+                size_type len = 0;
+                for ( ; cur && bkt_num(cur->val) == n; cur = cur->M_next())
+                    ++len;
+                if (len > st.max_chain) {
+                    st.max_chain = len;
+                    st.chain_histogram.resize(len + 1, 0);
+                }
+                --st.chain_histogram[0];
+                ++st.chain_histogram[len];
+                sum_hit += len * (len + 1) / 2;
+                sum_miss += len * len;
+            }
+            st.empty_buckets = st.chain_histogram[0];
+            st.empty_bucket_ratio = static_cast<float>(st.empty_buckets) / static_cast<float>(st.bucket_count);
+            st.probes_hit = num_elements ? static_cast<double>(sum_hit) / num_elements : 0.0;
+            st.probes_miss = num_elements ? static_cast<double>(sum_miss) / num_elements : 0.0;
+            return st;
+        }
+
     public:
         // 哈希策略
         
@@ -757,6 +1370,41 @@ namespace STL
         float load_factor() const noexcept
         { return static_cast<float>(size()) / static_cast<float>(bucket_count()); }
 
+        /**
+         *  @brief  最大负载系数，缺省为1.0
+         */
+        float max_load_factor() const noexcept { return max_load; }
+
+        /**
+         *  @brief  设置最大负载系数，若当前负载系数超过z则立即重建table
+         *
+         *  z不得小于1/8，更小的值（包括非正数与NaN）按1/8处理，以免所需的桶数溢出
+         */
+        void max_load_factor(float z)
+        {
+            if (!(z >= 0.125f))             // 同时处理NaN
+                z = 0.125f;
+            max_load = z;
+            resize(num_elements);
+        }
+
+        /**
+         *  @brief  将桶数重设为不小于n，且不小于容纳现有元素所需的桶数
+         *
+         *  可以减少桶数，桶数不变时什么也不做
+         */
+        void rehash(size_type n)
+        {
+            const size_type n_buckets = next_prime(std::max(n, bkt_for_elements(num_elements)));
+            if (n_buckets != buckets.size())
+                rehash_aux(n_buckets);
+        }
+
+        /**
+         *  @brief  预留容纳n个元素的桶，之后插入至多n个元素都不会重建table
+         */
+        void reserve(size_type n) { rehash(bkt_for_elements(n)); }
+
     public:
         // 观察器
         
@@ -769,32 +1417,42 @@ namespace STL
          *  @brief  返回键值相等性函数
          */
         key_equal key_eq() const { return equal; }
-
-    private:
-        // 友元比较符
-        template <class _Value, class _Key, class _HashFcn, class _ExtractKey, class _Equal, class _Alloc>
-        friend bool operator==(const hashtable<_Value, _Key, _HashFcn, _ExtractKey, _Equal, _Alloc>& x,
-                               const hashtable<_Value, _Key, _HashFcn, _ExtractKey, _Equal, _Alloc>& y);
-        template <class _Value, class _Key, class _HashFcn, class _ExtractKey, class _Equal, class _Alloc>
-        friend bool operator!=(const hashtable<_Value, _Key, _HashFcn, _ExtractKey, _Equal, _Alloc>& x,
-                               const hashtable<_Value, _Key, _HashFcn, _ExtractKey, _Equal, _Alloc>& y);
     };
 
+    /**
+     *  @brief  两个hashtable含有相同的元素（与节点顺序无关）时相等
+     *
+     *  键值相同的节点在链表中相邻，逐组比较x中每组元素与y中对应范围的元素
+     */
     template <class Value, class Key, class HashFcn, class ExtractKey, class Equal, class Alloc>
     bool operator==(const hashtable<Value, Key, HashFcn, ExtractKey, Equal, Alloc>& x,
                     const hashtable<Value, Key, HashFcn, ExtractKey, Equal, Alloc>& y)
     {
-        using Node = typename hashtable<Value, Key, HashFcn, ExtractKey, Equal, Alloc>::Node; 
-        if (x.buckets.size() != y.buckets.size())
+        using const_iterator = typename hashtable<Value, Key, HashFcn, ExtractKey, Equal, Alloc>::const_iterator;
+        if (x.size() != y.size())
             return false;
-        for (size_t n = 0; n < x.buckets.size(); ++n) {
-            Node* cur1 = x.buckets[n];
-            Node* cur2 = y.buckets[n];
-            for ( ; cur1 && cur2 && cur1->val == cur2->val;
-                    cur1 = cur1->next, cur2 = cur2->next)
-            { }
-            if (cur1 || cur2)
+        const ExtractKey get_key = ExtractKey();
+        const Equal equal = x.key_eq();
+        for (const_iterator it = x.begin(); it != x.end(); ) {
+            // x中键值相同的一组元素[it, group_end)
+            const_iterator group_end = it;
+            size_t x_count = 0;
+            for ( ; group_end != x.end() && equal(get_key(*group_end), get_key(*it)); ++group_end)
+                ++x_count;
+            pair<const_iterator, const_iterator> r = y.equal_range(get_key(*it));
+            if (static_cast<size_t>(STL::distance(r.first, r.second)) != x_count)
                 return false;
+            // 组内每个值在两边出现的次数必须相同
+            for (const_iterator i = it; i != group_end; ++i) {
+                size_t n1 = 0, n2 = 0;
+                for (const_iterator j = it; j != group_end; ++j)
+                    if (*j == *i)   ++n1;
+                for (const_iterator j = r.first; j != r.second; ++j)
+                    if (*j == *i)   ++n2;
+                if (n1 != n2)
+                    return false;
+            }
+            it = group_end;
         }
         return true;
     }
@@ -0,0 +1,314 @@
+#ifndef TINYSTL_LRU_CACHE_H_
+#define TINYSTL_LRU_CACHE_H_
+
+#include <functional>
+#include <utility>
+
+#include "hashtable.h"
+
+namespace STL
+{
+
+    // 最近使用链表的链接，嵌入在hashtable节点的实值中
+    struct lru_link
+    {
+        lru_link* prev;
+        lru_link* next;
+    };
+
+    // lru_cache中hashtable节点的实值：链接 + 键值/实值对
+    template <class Key, class T>
+    struct lru_entry : public lru_link
+    {
+        pair<const Key, T> value;
+
+        template <class... Args>
+        explicit lru_entry(Args&&... args) : lru_link(), value(std::forward<Args>(args)...) { }
+
+        lru_entry(const lru_entry&) = delete;
+        lru_entry& operator=(const lru_entry&) = delete;
+    };
+
+    template <class Key, class T>
+    struct lru_entry_key
+    {
+        const Key& operator()(const lru_entry<Key, T>& e) const { return e.value.first; }
+    };
+
+    // 缺省的权重：每个元素计1，容量即元素个数
+    struct lru_unit_weight
+    {
+        template <class Key, class T>
+        size_t operator()(const Key&, const T&) const { return 1; }
+    };
+
+    template <class Key, class T>
+    struct lru_cache_iterator
+    {
+        using iterator_category = STL::bidirectional_iterator_tag;
+        using value_type        = pair<const Key, T>;
+        using pointer           = value_type*;
+        using reference         = value_type&;
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+        using Self              = lru_cache_iterator;
+
+        lru_link* cur;
+
+        lru_cache_iterator() noexcept : cur(nullptr) { }
+        explicit lru_cache_iterator(lru_link* x) noexcept : cur(x) { }
+
+        reference operator*() const noexcept { return static_cast<lru_entry<Key, T>*>(cur)->value; }
+        pointer operator->() const noexcept { return &operator*(); }
+
+        Self& operator++() noexcept { cur = cur->next; return *this; }
+        Self operator++(int) noexcept { Self tmp = *this; cur = cur->next; return tmp; }
+        Self& operator--() noexcept { cur = cur->prev; return *this; }
+        Self operator--(int) noexcept { Self tmp = *this; cur = cur->prev; return tmp; }
+
+        bool operator==(const Self& x) const noexcept { return cur == x.cur; }
+        bool operator!=(const Self& x) const noexcept { return cur != x.cur; }
+    };
+
+
+    /**
+     *  容量有限、按最近最少使用（LRU）淘汰的缓存
+     *
+     *  @tparam  Key        键值类型
+     *  @tparam  T          实值类型
+     *  @tparam  HashFcn    hash函数类型
+     *  @tparam  EqualKey   判断键值是否相同的函数对象
+     *  @tparam  Weigher    元素权重函数 size_t(const Key&, const T&)，缺省每个元素计1；
+     *                      以字节数为权重时，容量即为字节数
+     *  @tparam  Alloc      空间分配器
+     *
+     *  最近使用链表的前后指针直接嵌在hashtable的节点中，每个元素只分配一个节点
+     *  hashtable重建时节点不移动，链表指针始终有效；get/put/erase/淘汰均为O(1)
+     *  链表以head为哨兵，head.next为最近使用的元素，head.prev为最久未使用的元素
+     */
+    template <class Key,
+              class T,
+              class HashFcn = std::hash<Key>,
+              class EqualKey = std::equal_to<Key>,
+              class Weigher = lru_unit_weight,
+              class Alloc = STL::pool_alloc>
+    class lru_cache
+    {
+    private:
+        using entry     = lru_entry<Key, T>;
+        using Hashtable = STL::hashtable<entry, Key, HashFcn, lru_entry_key<Key, T>, EqualKey, Alloc>;
+
+    public:
+        using key_type          = Key;
+        using mapped_type       = T;
+        using value_type        = pair<const Key, T>;
+        using hasher            = HashFcn;
+        using key_equal         = EqualKey;
+        using size_type         = size_t;
+        using iterator          = lru_cache_iterator<Key, T>;
+        using evict_callback    = std::function<void(const Key&, T&)>;
+
+    private:
+        Hashtable       rep;
+        lru_link        head;           // 最近使用链表的哨兵
+        size_type       max_weight;     // 容量
+        size_type       total_weight;   // 所有元素的权重之和
+        Weigher         weigh;
+        evict_callback  on_evict;
+
+    private:
+        static void unlink(lru_link* x)
+        {
+            x->prev->next = x->next;
+            x->next->prev = x->prev;
+        }
+
+        // 将x放到链表头部，成为最近使用的元素
+        void link_front(lru_link* x)
+        {
+            x->prev = &head;
+            x->next = head.next;
+            head.next->prev = x;
+            head.next = x;
+        }
+
+        void touch(lru_link* x)
+        {
+            if (head.next != x) {
+                unlink(x);
+                link_front(x);
+            }
+        }
+
+        // 移除元素e，不调用淘汰回调
+        void remove(entry* e)
+        {
+            unlink(e);
+            total_weight -= weigh(e->value.first, e->value.second);
+            rep.erase(e->value.first);
+        }
+
+        // 从链表尾部淘汰元素，直到总权重不超过容量；keep为刚写入的元素，不会被淘汰
+        void evict(const lru_link* keep)
+        {
+            while (total_weight > max_weight && head.prev != &head && head.prev != keep) {
+                entry* victim = static_cast<entry*>(head.prev);
+                if (on_evict)
+                    on_evict(victim->value.first, victim->value.second);
+                remove(victim);
+            }
+        }
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         *  @param  capacity  容量，即所有元素的权重之和的上限
+         */
+        explicit lru_cache(size_type capacity, const Weigher& w = Weigher(),
+                           const HashFcn& hf = HashFcn(), const EqualKey& eql = EqualKey())
+        : rep(100, hf, eql), max_weight(capacity), total_weight(0), weigh(w)
+        { head.prev = head.next = &head; }
+
+        lru_cache(const lru_cache&) = delete;
+        lru_cache& operator=(const lru_cache&) = delete;
+
+        /**
+         *  @brief  destructor，不调用淘汰回调
+         */
+        ~lru_cache() { rep.clear(); }
+
+    public:
+        // 迭代器，从最近使用的元素到最久未使用的元素；遍历不改变使用顺序
+        iterator begin() noexcept { return iterator(head.next); }
+        iterator end() noexcept { return iterator(&head); }
+
+    public:
+        // 容量
+        size_type size() const noexcept { return rep.size(); }
+        bool empty() const noexcept { return rep.empty(); }
+        size_type capacity() const noexcept { return max_weight; }
+        size_type weight() const noexcept { return total_weight; }
+
+        /**
+         *  @brief  修改容量，超出的部分立即淘汰
+         */
+        void set_capacity(size_type capacity)
+        {
+            max_weight = capacity;
+            evict(nullptr);
+        }
+
+        /**
+         *  @brief  设置淘汰回调，元素因超出容量被淘汰前以其键值与实值调用
+         *
+         *  回调不得抛出异常，也不得访问本缓存
+         */
+        void set_evict_callback(evict_callback f) { on_evict = std::move(f); }
+
+    public:
+        // 访问
+
+        /**
+         *  @brief  查找键值为k的元素并将其标记为最近使用
+         *  @return  指向实值的指针，不存在时为nullptr
+         */
+        T* get(const key_type& k)
+        {
+            typename Hashtable::iterator it = rep.find(k);
+            if (it == rep.end())
+                return nullptr;
+            touch(&*it);
+            return &it->value.second;
+        }
+
+        /**
+         *  @brief  查找键值为k的元素，不改变使用顺序
+         */
+        const T* peek(const key_type& k) const
+        {
+            typename Hashtable::const_iterator it = rep.find(k);
+            return it == rep.end() ? nullptr : &it->value.second;
+        }
+
+        size_type count(const key_type& k) const { return rep.count(k); }
+
+    public:
+        // 修改器
+
+        /**
+         *  @brief  写入键值k与实值obj，并将其标记为最近使用，总权重超过容量时淘汰最久未使用的元素
+         *  @return  是否插入了新元素，false表示覆盖了已有元素的实值
+         *
+         *  刚写入的元素不会被淘汰，因此单个元素的权重超过容量时，缓存中只留下这一个元素
+         */
+        template <class M>
+        bool put(const key_type& k, M&& obj)
+        {
+            pair<typename Hashtable::iterator, bool> p = rep.try_emplace(k, std::forward<M>(obj));
+            entry* e = &*p.first;
+            if (p.second) {
+                link_front(e);
+            } else {
+                const size_type old_weight = weigh(e->value.first, e->value.second);
+                e->value.second = std::forward<M>(obj);
+                total_weight -= old_weight;
+                touch(e);
+            }
+            total_weight += weigh(e->value.first, e->value.second);
+            evict(e);
+            return p.second;
+        }
+
+        /**
+         *  @brief  键值k不存在时以args构造实值并插入，存在时只将其标记为最近使用
+         *  @return  pair<指向实值的指针, 是否插入了新元素>
+         */
+        template <class... Args>
+        pair<T*, bool> try_emplace(const key_type& k, Args&&... args)
+        {
+            pair<typename Hashtable::iterator, bool> p = rep.try_emplace(k, std::forward<Args>(args)...);
+            entry* e = &*p.first;
+            if (p.second) {
+                link_front(e);
+                total_weight += weigh(e->value.first, e->value.second);
+                evict(e);
+            } else {
+                touch(e);
+            }
+            return pair<T*, bool>(&e->value.second, p.second);
+        }
+
+        /**
+         *  @brief  移除键值为k的元素，不调用淘汰回调
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        {
+            typename Hashtable::iterator it = rep.find(k);
+            if (it == rep.end())
+                return 0;
+            remove(&*it);
+            return 1;
+        }
+
+        /**
+         *  @brief  清除所有元素，不调用淘汰回调
+         */
+        void clear()
+        {
+            rep.clear();
+            head.prev = head.next = &head;
+            total_weight = 0;
+        }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return rep.hash_function(); }
+        key_equal key_eq() const { return rep.key_eq(); }
+    };
+
+} /* namespace STL */
+
+#endif
@@ -0,0 +1,405 @@
+#ifndef TINYSTL_MMAP_HASHTABLE_H_
+#define TINYSTL_MMAP_HASHTABLE_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+#include "hashtable.h"  // for next_prime()
+#include "vector.h"
+
+namespace STL
+{
+
+    /**
+     *  mmap_hashtable的文件格式，所有位置都以相对文件开头的偏移或下标表示，与映射地址无关
+     *
+     *  [header][buckets: uint64_t × (bucket_count + 1)][entries: entry × element_count]
+     *
+     *  元素按桶号排序后连续存放，桶i的元素为entries[buckets[i], buckets[i + 1])
+     *  以本机字节序写入，不能在字节序不同的机器间共享
+     */
+    struct mmap_hashtable_header
+    {
+        char        magic[8];           // "TSTLHT01"
+        uint32_t    key_size;
+        uint32_t    mapped_size;
+        uint32_t    entry_size;
+        uint32_t    entry_align;
+        uint64_t    bucket_count;
+        uint64_t    element_count;
+        uint64_t    buckets_offset;
+        uint64_t    entries_offset;
+        uint64_t    file_size;
+    };
+
+    template <class Key, class T>
+    struct mmap_hashtable_entry
+    {
+        Key first;
+        T   second;
+    };
+
+
+    /**
+     *  只读的持久化hashtable，以mmap打开文件，不需要反序列化
+     *
+     *  @tparam  Key        键值类型，须可平凡复制
+     *  @tparam  T          实值类型，须可平凡复制
+     *  @tparam  HashFcn    hash函数类型，写入与读取须得到相同的结果，缺省使用与进程无关的STL::hash
+     *  @tparam  EqualKey   判断键值是否相同的函数对象
+     *
+     *  write()把元素写成文件，open()映射文件后即可查找，多个进程映射同一个文件时共享物理内存
+     *  attach()可直接使用已在内存中的数据，如共享内存或嵌入程序的数据
+     */
+    template <class Key,
+              class T,
+              class HashFcn = STL::hash<Key>,
+              class EqualKey = std::equal_to<Key>>
+    class mmap_hashtable
+    {
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                      "mmap_hashtable requires trivially copyable key and mapped types");
+
+    public:
+        using key_type          = Key;
+        using mapped_type       = T;
+        using value_type        = mmap_hashtable_entry<Key, T>;
+        using hasher            = HashFcn;
+        using key_equal         = EqualKey;
+        using size_type         = size_t;
+        using const_iterator    = const value_type*;
+        using iterator          = const_iterator;
+
+    private:
+        const char*         base;           // 数据起始地址
+        size_type           length;
+        bool                mapped;         // base是否由open()映射，需要munmap
+        const uint64_t*     buckets;
+        const value_type*   entries;
+        uint64_t            n_buckets;
+        uint64_t            n_elements;
+        hasher              hash;
+        key_equal           equal;
+
+    private:
+        static const char* magic() { return "TSTLHT01"; }
+
+        static uint64_t align_up(uint64_t x, uint64_t a) { return (x + a - 1) / a * a; }
+
+        static void fail(const char* what) { throw std::runtime_error(std::string("mmap_hashtable: ") + what); }
+
+        static void fail_errno(const char* what)
+        { throw std::system_error(errno, std::generic_category(), std::string("mmap_hashtable: ") + what); }
+
+        // 检查头部与各段的范围，通过后设置各段指针
+        void validate(const char* p, size_type len)
+        {
+            mmap_hashtable_header h;
+            if (len < sizeof(h))
+                fail("file too small");
+            std::memcpy(&h, p, sizeof(h));
+            if (std::memcmp(h.magic, magic(), sizeof(h.magic)) != 0)
+                fail("bad magic");
+            if (h.key_size != sizeof(Key) || h.mapped_size != sizeof(T) ||
+                h.entry_size != sizeof(value_type) || h.entry_align != alignof(value_type))
+                fail("key or mapped type does not match the file");
+            // 以除法比较各段的长度，头部中的任何值都不会使检查溢出
+            if (h.file_size != len || h.bucket_count == 0 ||
+                h.buckets_offset % alignof(uint64_t) != 0 || h.entries_offset % alignof(value_type) != 0 ||
+                h.buckets_offset < sizeof(h) || h.buckets_offset > h.entries_offset || h.entries_offset > len ||
+                h.bucket_count >= (h.entries_offset - h.buckets_offset) / sizeof(uint64_t) ||
+                h.element_count > (len - h.entries_offset) / sizeof(value_type))
+                fail("corrupted header");
+            if (reinterpret_cast<uintptr_t>(p) % alignof(value_type) != 0 ||
+                reinterpret_cast<uintptr_t>(p) % alignof(uint64_t) != 0)
+                fail("misaligned data");
+            // 各桶的起始下标须单调不减且不超过元素个数，查找时才不会越出entries
+            const uint64_t* b = reinterpret_cast<const uint64_t*>(p + h.buckets_offset);
+            if (b[0] != 0 || b[h.bucket_count] != h.element_count)
+                fail("corrupted buckets");
+            for (uint64_t i = 0; i < h.bucket_count; ++i)
+                if (b[i] > b[i + 1])
+                    fail("corrupted buckets");
+            base = p;
+            length = len;
+            buckets = b;
+            entries = reinterpret_cast<const value_type*>(p + h.entries_offset);
+            n_buckets = h.bucket_count;
+            n_elements = h.element_count;
+        }
+
+        size_type bkt_num_key(const key_type& k) const
+        { return static_cast<size_type>(hash(k) % n_buckets); }
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor，不持有任何数据，查找均失败
+         */
+        explicit mmap_hashtable(const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : base(nullptr), length(0), mapped(false), buckets(nullptr), entries(nullptr),
+          n_buckets(0), n_elements(0), hash(hf), equal(eql) { }
+
+        /**
+         *  @brief  以只读方式映射文件path
+         */
+        explicit mmap_hashtable(const char* path, const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : mmap_hashtable(hf, eql)
+        { open(path); }
+
+        mmap_hashtable(mmap_hashtable&& x) noexcept
+        : base(x.base), length(x.length), mapped(x.mapped), buckets(x.buckets), entries(x.entries),
+          n_buckets(x.n_buckets), n_elements(x.n_elements), hash(x.hash), equal(x.equal)
+        {
+            x.base = nullptr;
+            x.mapped = false;
+            x.close();
+        }
+
+        mmap_hashtable& operator=(mmap_hashtable&& x) noexcept
+        {
+            if (this != &x) {
+                close();
+                swap(x);
+            }
+            return *this;
+        }
+
+        mmap_hashtable(const mmap_hashtable&) = delete;
+        mmap_hashtable& operator=(const mmap_hashtable&) = delete;
+
+        ~mmap_hashtable() { close(); }
+
+    public:
+        /**
+         *  @brief  以只读方式映射文件path，替换当前数据
+         *  @throw  std::system_error  无法打开或映射文件
+         *  @throw  std::runtime_error  文件格式不符
+         */
+        void open(const char* path)
+        {
+            close();
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+                fail_errno("open");
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                const int err = errno;
+                ::close(fd);
+                errno = err;
+                fail_errno("fstat");
+            }
+            const size_type len = static_cast<size_type>(st.st_size);
+            void* p = len ? ::mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+            const int err = errno;
+            ::close(fd);
+            if (p == MAP_FAILED) {
+                if (len == 0)
+                    fail("file too small");
+                errno = err;
+                fail_errno("mmap");
+            }
+            try {
+                validate(static_cast<const char*>(p), len);
+            } catch(...) {
+                ::munmap(p, len);
+                throw;
+            }
+            mapped = true;
+        }
+
+        /**
+         *  @brief  直接使用内存中[p, p + len)的数据，不复制；数据须在本对象使用期间保持有效
+         */
+        void attach(const void* p, size_type len)
+        {
+            close();
+            validate(static_cast<const char*>(p), len);
+        }
+
+        /**
+         *  @brief  解除映射，之后查找均失败
+         */
+        void close() noexcept
+        {
+            if (mapped)
+                ::munmap(const_cast<char*>(base), length);
+            base = nullptr;
+            length = 0;
+            mapped = false;
+            buckets = nullptr;
+            entries = nullptr;
+            n_buckets = 0;
+            n_elements = 0;
+        }
+
+        bool is_open() const noexcept { return base != nullptr; }
+
+        void swap(mmap_hashtable& x) noexcept
+        {
+            STL::swap(base, x.base);
+            STL::swap(length, x.length);
+            STL::swap(mapped, x.mapped);
+            STL::swap(buckets, x.buckets);
+            STL::swap(entries, x.entries);
+            STL::swap(n_buckets, x.n_buckets);
+            STL::swap(n_elements, x.n_elements);
+            STL::swap(hash, x.hash);
+            STL::swap(equal, x.equal);
+        }
+
+    public:
+        // 迭代器，按桶号顺序遍历所有元素
+        const_iterator begin() const noexcept { return entries; }
+        const_iterator end() const noexcept { return entries + n_elements; }
+
+        // 容量
+        size_type size() const noexcept { return static_cast<size_type>(n_elements); }
+        bool empty() const noexcept { return n_elements == 0; }
+        size_type bucket_count() const noexcept { return static_cast<size_type>(n_buckets); }
+
+    public:
+        // 查找
+
+        /**
+         *  @brief  返回键值为k的元素，不存在时返回end()
+         */
+        const_iterator find(const key_type& k) const
+        {
+            if (n_elements == 0)
+                return end();
+            const size_type n = bkt_num_key(k);
+            for (const value_type* p = entries + buckets[n], *last = entries + buckets[n + 1]; p != last; ++p)
+                if (equal(p->first, k))
+                    return p;
+            return end();
+        }
+
+        size_type count(const key_type& k) const
+        { return find(k) == end() ? 0 : 1; }
+
+        /**
+         *  @brief  返回键值为k的元素的实值
+         *  @throw  std::out_of_range  键值不存在
+         */
+        const mapped_type& at(const key_type& k) const
+        {
+            const_iterator it = find(k);
+            if (it == end())
+                throw std::out_of_range("mmap_hashtable::at");
+            return it->second;
+        }
+
+    public:
+        /**
+         *  @brief  将[first, last)中的元素写成文件path，元素须可转换为pair<Key, T>且键值不重复
+         *  @param  load  平均每个桶的元素个数
+         *  @throw  std::system_error  无法写入文件
+         *
+         *  先写入path.tmp再重命名为path，正在映射旧文件的进程不受影响
+         */
+        template <class InputIterator>
+        static void write(const char* path, InputIterator first, InputIterator last,
+                          float load = 1.0f, const hasher& hf = hasher())
+        {
+            STL::vector<value_type> items;
+            for ( ; first != last; ++first) {
+                value_type e;
+                std::memset(&e, 0, sizeof(e));
+                e.first = first->first;
+                e.second = first->second;
+                items.push_back(e);
+            }
+
+            mmap_hashtable_header h;
+            std::memset(&h, 0, sizeof(h));
+            std::memcpy(h.magic, magic(), sizeof(h.magic));
+            h.key_size = sizeof(Key);
+            h.mapped_size = sizeof(T);
+            h.entry_size = sizeof(value_type);
+            h.entry_align = alignof(value_type);
+            h.element_count = items.size();
+            h.bucket_count = next_prime(static_cast<unsigned long>(items.size() / load) + 1);
+            h.buckets_offset = align_up(sizeof(h), alignof(uint64_t));
+            h.entries_offset = align_up(h.buckets_offset + (h.bucket_count + 1) * sizeof(uint64_t),
+                                        alignof(value_type));
+            h.file_size = h.entries_offset + h.element_count * sizeof(value_type);
+
+            // 按桶号计数排序
+            STL::vector<uint64_t> bkt(static_cast<size_t>(h.bucket_count + 1), 0);
+            STL::vector<uint64_t> bkt_of(items.size());
+            for (size_type i = 0; i < items.size(); ++i) {
+                bkt_of[i] = hf(items[i].first) % h.bucket_count;
+                ++bkt[static_cast<size_t>(bkt_of[i] + 1)];
+            }
+            for (size_type i = 1; i < bkt.size(); ++i)
+                bkt[i] += bkt[i - 1];
+            // 复制元素会带出填充字节中的任意内容，因此先将写出的元素清零，再逐个成员赋值
+            // 文件内容只由元素决定，也不会泄露内存中的残留数据
+            STL::vector<value_type> sorted(items.size());
+            if (!sorted.empty())
+                std::memset(static_cast<void*>(&sorted[0]), 0, sorted.size() * sizeof(value_type));
+            STL::vector<uint64_t> pos(bkt.begin(), bkt.end() - 1);
+            for (size_type i = 0; i < items.size(); ++i) {
+                value_type& e = sorted[static_cast<size_t>(pos[static_cast<size_t>(bkt_of[i])]++)];
+                e.first = items[i].first;
+                e.second = items[i].second;
+            }
+
+            const std::string tmp = std::string(path) + ".tmp";
+            std::FILE* f = std::fopen(tmp.c_str(), "wb");
+            if (f == nullptr)
+                fail_errno("fopen");
+            static const char zeros[64] = { 0 };
+            const bool ok =
+                std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+                std::fwrite(zeros, 1, h.buckets_offset - sizeof(h), f) == h.buckets_offset - sizeof(h) &&
+                std::fwrite(&bkt[0], sizeof(uint64_t), bkt.size(), f) == bkt.size() &&
+                std::fwrite(zeros, 1, h.entries_offset - h.buckets_offset - bkt.size() * sizeof(uint64_t), f) ==
+                    h.entries_offset - h.buckets_offset - bkt.size() * sizeof(uint64_t) &&
+                (sorted.empty() || std::fwrite(&sorted[0], sizeof(value_type), sorted.size(), f) == sorted.size());
+            const int write_err = errno;
+            const bool closed = std::fclose(f) == 0;
+            if (!ok || !closed) {
+                const int e = ok ? errno : write_err;
+                std::remove(tmp.c_str());
+                errno = e;
+                fail_errno("write");
+            }
+            if (std::rename(tmp.c_str(), path) != 0) {
+                const int e = errno;
+                std::remove(tmp.c_str());
+                errno = e;
+                fail_errno("rename");
+            }
+        }
+
+        /**
+         *  @brief  将容器c中的所有元素写成文件path
+         */
+        template <class Container>
+        static void write(const char* path, const Container& c, float load = 1.0f, const hasher& hf = hasher())
+        { write(path, c.begin(), c.end(), load, hf); }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return hash; }
+        key_equal key_eq() const { return equal; }
+    };
+
+} /* namespace STL */
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef TINYSTL_NODE_HANDLE_H_
+#define TINYSTL_NODE_HANDLE_H_
+
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+#include "construct.h"
+
+namespace STL
+{
+
+    template <class Key, class Val, class KeyOfValue, class Compare, class Alloc, class Augment>
+    class rb_tree;
+
+    template <class Value, class Key, class HashFcn, class ExtractKey, class Equal, class Alloc>
+    class hashtable;
+
+    /**
+     *  节点句柄，持有一个从容器中摘下的节点
+     *
+     *  @tparam  Value  节点的实值类型
+     *  @tparam  Node   节点类型，须提供valptr()
+     *  @tparam  Alloc  空间分配器，与节点原属容器的分配器相同
+     *
+     *  extract()摘下节点时不析构实值也不释放内存，insert()直接把节点挂回容器
+     *  因此在容器之间移动元素既不分配内存也不复制实值
+     *  句柄析构时若仍持有节点，则析构实值并释放节点
+     */
+    template <class Value, class Node, class Alloc>
+    class node_handle
+    {
+    public:
+        using value_type    = Value;
+
+    private:
+        using node_allocator = STL::allocator<Node, Alloc>;
+
+        Node* ptr;
+
+        template <class, class, class, class, class, class>
+        friend class rb_tree;
+
+        template <class, class, class, class, class, class>
+        friend class hashtable;
+
+        explicit node_handle(Node* p) noexcept : ptr(p) { }
+
+        // 交出节点的所有权
+        Node* release() noexcept
+        {
+            Node* p = ptr;
+            ptr = nullptr;
+            return p;
+        }
+
+        void reset() noexcept
+        {
+            if (ptr) {
+                STL::destroy(ptr->valptr());
+                node_allocator::deallocate(ptr);
+                ptr = nullptr;
+            }
+        }
+
+    public:
+        // The big five
+
+        constexpr node_handle() noexcept : ptr(nullptr) { }
+
+        node_handle(node_handle&& nh) noexcept : ptr(nh.ptr) { nh.ptr = nullptr; }
+
+        node_handle& operator=(node_handle&& nh) noexcept
+        {
+            if (this != &nh) {
+                reset();
+                ptr = nh.ptr;
+                nh.ptr = nullptr;
+            }
+            return *this;
+        }
+
+        node_handle(const node_handle&) = delete;
+        node_handle& operator=(const node_handle&) = delete;
+
+        ~node_handle() { reset(); }
+
+    public:
+        bool empty() const noexcept { return ptr == nullptr; }
+        explicit operator bool() const noexcept { return ptr != nullptr; }
+
+        /**
+         *  @brief  节点的实值，句柄非空时才可调用
+         */
+        value_type& value() const { return *ptr->valptr(); }
+
+        /**
+         *  @brief  map节点的键值，摘下后可以修改键值再插回容器
+         */
+        template <class V = Value>
+        typename std::remove_const<typename V::first_type>::type& key() const
+        {
+            using key_type = typename std::remove_const<typename V::first_type>::type;
+            return const_cast<key_type&>(ptr->valptr()->first);
+        }
+
+        /**
+         *  @brief  map节点的实值
+         */
+        template <class V = Value>
+        typename V::second_type& mapped() const { return ptr->valptr()->second; }
+
+        void swap(node_handle& nh) noexcept
+        {
+            Node* tmp = ptr;
+            ptr = nh.ptr;
+            nh.ptr = tmp;
+        }
+    };
+
+    template <class Value, class Node, class Alloc>
+    inline void swap(node_handle<Value, Node, Alloc>& x, node_handle<Value, Node, Alloc>& y) noexcept
+    { x.swap(y); }
+
+    /**
+     *  键值不允许重复的容器insert(node_type&&)的返回值
+     *  插入失败时node仍持有原节点，position指向容器中键值相同的元素
+     */
+    template <class Iterator, class NodeHandle>
+    struct node_insert_return
+    {
+        Iterator    position;
+        bool        inserted;
+        NodeHandle  node;
+    };
+
+} /* namespace STL */
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TINYSTL_PARALLEL_H_
+#define TINYSTL_PARALLEL_H_
+
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace STL
+{
+
+    /**
+     *  @brief  并行执行f(0), f(1), ..., f(n - 1)，等待全部完成后返回
+     *
+     *  f(0)在调用线程上执行，其余各开一个线程；无法创建线程时改在调用线程上执行
+     *  任一f抛出异常时，等所有线程结束后重新抛出第一个异常
+     */
+    template <class Function>
+    void parallel_run(unsigned n, Function f)
+    {
+        std::vector<std::exception_ptr> errors(n);
+        std::vector<std::thread> threads;
+        threads.reserve(n);
+        auto task = [&f, &errors](unsigned i) {
+            try {
+                f(i);
+            } catch(...) {
+                errors[i] = std::current_exception();
+            }
+        };
+        for (unsigned i = 1; i < n; ++i) {
+            try {
+                threads.emplace_back(task, i);
+            } catch(...) {
+                task(i);
+            }
+        }
+        task(0);
+        for (std::thread& t : threads)
+            t.join();
+        for (unsigned i = 0; i < n; ++i)
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+    }
+
+    /**
+     *  @brief  决定并行处理n个元素所用的线程数
+     *  @param  threads  期望的线程数，0表示使用硬件线程数
+     *  @param  grain    每个线程至少处理的元素个数，元素太少时不值得开线程
+     */
+    inline unsigned parallel_degree(size_t n, unsigned threads, size_t grain)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+        const size_t limit = n / grain;
+        if (limit < threads)
+            threads = limit == 0 ? 1 : static_cast<unsigned>(limit);
+        return threads;
+    }
+
+} /* namespace STL */
+
+#endif
@@ -0,0 +1,539 @@
+#ifndef TINYSTL_PERSISTENT_MAP_H_
+#define TINYSTL_PERSISTENT_MAP_H_
+
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#include "algobase.h"
+#include "allocator.h"
+#include "iterator.h"
+
+using std::pair;
+
+namespace STL
+{
+
+    /**
+     *  持久化（不可变、结构共享）的有序map
+     *
+     *  @tparam  Key        键值类型
+     *  @tparam  T          实值类型
+     *  @tparam  Compare    键值的比较函数
+     *  @tparam  Alloc      空间分配器
+     *
+     *  以AVL树组织，节点一经构造便不再修改，由引用计数在各版本间共享：
+     *    复制即为快照，只增加根节点的引用计数，耗时O(1)
+     *    插入、删除沿查找路径复制节点（path copying），路径以外的子树原样共享，
+     *    每次修改分配O(log n)个节点，旧版本不受影响
+     *  引用计数是原子变量，共享节点的不同persistent_map对象可以在不同线程上同时读写、析构，
+     *  最后一个引用消失的线程负责释放节点；同一个对象的并发读写仍须由调用者同步，
+     *  例如写者持锁把新版本赋给共享的对象，读者持同一把锁复制出快照后即可放锁慢慢读
+     *  节点可能在任意线程上释放，pool_alloc不是线程安全的，因此Alloc缺省为malloc_alloc
+     */
+    template <class Key,
+              class T,
+              class Compare = std::less<Key>,
+              class Alloc = STL::malloc_alloc>
+    class persistent_map
+    {
+    public:
+        using key_type          = Key;
+        using mapped_type       = T;
+        using value_type        = pair<const Key, T>;
+        using key_compare       = Compare;
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+        using pointer           = const value_type*;
+        using const_pointer     = const value_type*;
+        using reference         = const value_type&;
+        using const_reference   = const value_type&;
+
+    private:
+        struct node
+        {
+            mutable std::atomic<size_t> refs;   // 引用此节点的版本与父节点个数
+            const node*     left;
+            const node*     right;
+            int             height;             // 以此节点为根的子树高度，叶节点为1
+            value_type      value;
+
+            template <class... Args>
+            node(const node* l, const node* r, Args&&... args)
+            : refs(1), left(l), right(r),
+              height(1 + (height_of(l) > height_of(r) ? height_of(l) : height_of(r))),
+              value(std::forward<Args>(args)...) { }
+        };
+
+        using node_allocator = STL::allocator<node, Alloc>;
+
+        static int height_of(const node* x) { return x ? x->height : 0; }
+
+        static const key_type& key(const node* x) { return x->value.first; }
+
+        // 减少x的引用计数，降为0时释放x并减少孩子的引用计数
+        // 沿左孩子递归、沿右孩子循环，递归深度不超过树高
+        static void release(const node* x) noexcept
+        {
+            while (x && x->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                release(x->left);
+                const node* r = x->right;
+                node* p = const_cast<node*>(x);
+                STL::destroy(p);
+                node_allocator::deallocate(p);
+                x = r;
+            }
+        }
+
+        // 持有一个引用的句柄，离开作用域时释放；构造新子树的过程中抛出异常时不泄漏节点
+        class node_ref
+        {
+        private:
+            const node* p;
+
+        public:
+            explicit node_ref(const node* x = nullptr) noexcept : p(x) { }
+            node_ref(node_ref&& x) noexcept : p(x.p) { x.p = nullptr; }
+            node_ref(const node_ref&) = delete;
+            node_ref& operator=(const node_ref&) = delete;
+            ~node_ref() { persistent_map::release(p); }
+
+            const node* get() const noexcept { return p; }
+            const node* operator->() const noexcept { return p; }
+            explicit operator bool() const noexcept { return p != nullptr; }
+
+            // 交出引用，不再负责释放
+            const node* release() noexcept
+            {
+                const node* x = p;
+                p = nullptr;
+                return x;
+            }
+        };
+
+        // 为x增加一个引用
+        static node_ref retain(const node* x) noexcept
+        {
+            if (x)
+                x->refs.fetch_add(1, std::memory_order_relaxed);
+            return node_ref(x);
+        }
+
+        // 以l、r为孩子构造新节点，接管l、r的引用
+        template <class... Args>
+        static node_ref make(node_ref l, node_ref r, Args&&... args)
+        {
+            node* x = node_allocator::allocate();
+            try {
+                STL::construct(x, l.get(), r.get(), std::forward<Args>(args)...);
+            } catch(...) {
+                node_allocator::deallocate(x);
+                throw;
+            }
+            l.release();
+            r.release();
+            return node_ref(x);
+        }
+
+        // 以v连接l与r，两者高度至多相差2，需要时以旋转恢复平衡
+        // 旋转涉及的节点都是共享的，一律构造新节点，不修改原节点
+        static node_ref balance(node_ref l, const value_type& v, node_ref r)
+        {
+            const int hl = height_of(l.get()), hr = height_of(r.get());
+            if (hl > hr + 1) {
+                const node* ll = l->left;
+                const node* lr = l->right;
+                if (height_of(ll) >= height_of(lr))
+                    return make(retain(ll), make(retain(lr), std::move(r), v), l->value);
+                return make(make(retain(ll), retain(lr->left), l->value),
+                            make(retain(lr->right), std::move(r), v), lr->value);
+            }
+            if (hr > hl + 1) {
+                const node* rl = r->left;
+                const node* rr = r->right;
+                if (height_of(rr) >= height_of(rl))
+                    return make(make(std::move(l), retain(rl), v), retain(rr), r->value);
+                return make(make(std::move(l), retain(rl->left), v),
+                            make(retain(rl->right), retain(rr), r->value), rl->value);
+            }
+            return make(std::move(l), std::move(r), v);
+        }
+
+    private:
+        const node*     root;
+        size_type       node_count;
+        Compare         compare;
+
+        // 在x子树中插入v，键值已存在时assign决定是否替换，返回新子树；x子树不变时返回空
+        node_ref M_insert(const node* x, const value_type& v, bool assign, bool& inserted) const
+        {
+            if (x == nullptr) {
+                inserted = true;
+                return make(node_ref(), node_ref(), v);
+            }
+            if (compare(v.first, key(x))) {
+                node_ref l = M_insert(x->left, v, assign, inserted);
+                if (!l)
+                    return node_ref();
+                return balance(std::move(l), x->value, retain(x->right));
+            }
+            if (compare(key(x), v.first)) {
+                node_ref r = M_insert(x->right, v, assign, inserted);
+                if (!r)
+                    return node_ref();
+                return balance(retain(x->left), x->value, std::move(r));
+            }
+            if (!assign)
+                return node_ref();
+            return make(retain(x->left), retain(x->right), v);
+        }
+
+        // 从x子树中摘下最小节点m，返回其余节点构成的新子树
+        static node_ref M_erase_min(const node* x, const node*& m)
+        {
+            if (x->left == nullptr) {
+                m = x;
+                return retain(x->right);
+            }
+            node_ref l = M_erase_min(x->left, m);
+            return balance(std::move(l), x->value, retain(x->right));
+        }
+
+        // 从x子树中删除键值k，返回新子树；erased为false时x子树不变，返回值无意义
+        node_ref M_erase(const node* x, const key_type& k, bool& erased) const
+        {
+            if (x == nullptr)
+                return node_ref();
+            if (compare(k, key(x))) {
+                node_ref l = M_erase(x->left, k, erased);
+                if (!erased)
+                    return node_ref();
+                return balance(std::move(l), x->value, retain(x->right));
+            }
+            if (compare(key(x), k)) {
+                node_ref r = M_erase(x->right, k, erased);
+                if (!erased)
+                    return node_ref();
+                return balance(retain(x->left), x->value, std::move(r));
+            }
+            erased = true;
+            if (x->left == nullptr)
+                return retain(x->right);
+            if (x->right == nullptr)
+                return retain(x->left);
+            // x的后继取代x；后继节点仍属于旧版本，在本函数返回前一直有效
+            const node* m = nullptr;
+            node_ref r = M_erase_min(x->right, m);
+            return balance(retain(x->left), m->value, std::move(r));
+        }
+
+        const node* M_find(const key_type& k) const
+        {
+            const node* x = root;
+            while (x) {
+                if (compare(k, key(x)))
+                    x = x->left;
+                else if (compare(key(x), k))
+                    x = x->right;
+                else
+                    return x;
+            }
+            return nullptr;
+        }
+
+        // 以新子树r作为根
+        void M_reset_root(node_ref r)
+        {
+            const node* old = root;
+            root = r.release();
+            release(old);
+        }
+
+    public:
+        /**
+         *  前向迭代器，以栈记录中序遍历中尚未访问的祖先节点
+         *  只要迭代器所在的版本还有persistent_map持有，迭代器就一直有效，不受其他版本修改的影响
+         */
+        class const_iterator
+        {
+        private:
+            friend class persistent_map;
+
+            // n个节点的AVL树高度小于1.45 log2(n + 2)，96足以容纳64位的size_type
+            enum { max_height = 96 };
+
+            const node* path[max_height];
+            int         depth;
+
+            void push_left(const node* x)
+            {
+                for ( ; x; x = x->left)
+                    path[depth++] = x;
+            }
+
+        public:
+            using iterator_category = STL::forward_iterator_tag;
+            using value_type        = typename persistent_map::value_type;
+            using difference_type   = ptrdiff_t;
+            using pointer           = const value_type*;
+            using reference         = const value_type&;
+
+            const_iterator() : depth(0) { }
+
+            reference operator*() const { return path[depth - 1]->value; }
+            pointer operator->() const { return &(operator*()); }
+
+            const_iterator& operator++()
+            {
+                const node* x = path[--depth];
+                push_left(x->right);
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            bool operator==(const const_iterator& x) const
+            { return depth == x.depth && (depth == 0 || path[depth - 1] == x.path[depth - 1]); }
+
+            bool operator!=(const const_iterator& x) const { return !(*this == x); }
+        };
+
+        using iterator = const_iterator;
+
+    private:
+        // 自根节点下降，pred(x)为true时x入栈并走向左孩子，否则走向右孩子，栈顶即所求节点
+        template <class Pred>
+        const_iterator M_descend(Pred pred) const
+        {
+            const_iterator it;
+            for (const node* x = root; x; ) {
+                if (pred(x)) {
+                    it.path[it.depth++] = x;
+                    x = x->left;
+                } else {
+                    x = x->right;
+                }
+            }
+            return it;
+        }
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor
+         */
+        explicit persistent_map(const Compare& cmp = Compare())
+        : root(nullptr), node_count(0), compare(cmp) { }
+
+        template <class InputIterator>
+        persistent_map(InputIterator first, InputIterator last, const Compare& cmp = Compare())
+        : root(nullptr), node_count(0), compare(cmp)
+        {
+            for ( ; first != last; ++first)
+                insert(*first);
+        }
+
+        persistent_map(std::initializer_list<value_type> l, const Compare& cmp = Compare())
+        : persistent_map(l.begin(), l.end(), cmp) { }
+
+        /**
+         *  @brief  copy constructor，与x共享全部节点，耗时O(1)
+         */
+        persistent_map(const persistent_map& x)
+        : root(retain(x.root).release()), node_count(x.node_count), compare(x.compare) { }
+
+        persistent_map(persistent_map&& x) noexcept
+        : root(x.root), node_count(x.node_count), compare(x.compare)
+        {
+            x.root = nullptr;
+            x.node_count = 0;
+        }
+
+        persistent_map& operator=(const persistent_map& x)
+        {
+            if (this != &x) {
+                M_reset_root(retain(x.root));
+                node_count = x.node_count;
+                compare = x.compare;
+            }
+            return *this;
+        }
+
+        persistent_map& operator=(persistent_map&& x) noexcept
+        {
+            swap(x);
+            return *this;
+        }
+
+        /**
+         *  @brief  destructor，只释放不再被其他版本共享的节点
+         */
+        ~persistent_map() { release(root); }
+
+        void swap(persistent_map& x) noexcept
+        {
+            STL::swap(root, x.root);
+            STL::swap(node_count, x.node_count);
+            STL::swap(compare, x.compare);
+        }
+
+    public:
+        // 观察器
+        key_compare key_comp() const { return compare; }
+
+        // 迭代器
+        const_iterator begin() const
+        {
+            const_iterator it;
+            it.push_left(root);
+            return it;
+        }
+
+        const_iterator end() const { return const_iterator(); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        // 容量
+        bool empty() const noexcept { return node_count == 0; }
+        size_type size() const noexcept { return node_count; }
+
+    public:
+        // 修改器，只改变本对象所持的版本，路径以外的节点与其他版本共享
+
+        /**
+         *  @brief  插入v，键值已存在时不做任何事
+         *  @return  是否插入成功
+         */
+        bool insert(const value_type& v)
+        {
+            bool inserted = false;
+            node_ref r = M_insert(root, v, false, inserted);
+            if (r) {
+                M_reset_root(std::move(r));
+                ++node_count;
+            }
+            return inserted;
+        }
+
+        /**
+         *  @brief  若键值k不存在，则插入pair(k, obj)；否则以新节点替换已有元素
+         *  @return  是否插入了新元素
+         */
+        template <class M>
+        bool insert_or_assign(const key_type& k, M&& obj)
+        {
+            bool inserted = false;
+            M_reset_root(M_insert(root, value_type(k, std::forward<M>(obj)), true, inserted));
+            if (inserted)
+                ++node_count;
+            return inserted;
+        }
+
+        /**
+         *  @brief  移除键值为k的元素
+         *  @return  移除元素的数量
+         */
+        size_type erase(const key_type& k)
+        {
+            bool erased = false;
+            node_ref r = M_erase(root, k, erased);
+            if (!erased)
+                return 0;
+            M_reset_root(std::move(r));
+            --node_count;
+            return 1;
+        }
+
+        /**
+         *  @brief  移除所有元素，与其他版本共享的节点不受影响
+         */
+        void clear() noexcept
+        {
+            release(root);
+            root = nullptr;
+            node_count = 0;
+        }
+
+    public:
+        // 查找
+
+        /**
+         *  @brief  返回键值为k的元素的实值的地址，不存在时返回nullptr
+         *
+         *  不构造迭代器，比find()更轻
+         */
+        const mapped_type* get(const key_type& k) const
+        {
+            const node* x = M_find(k);
+            return x ? &x->value.second : nullptr;
+        }
+
+        /**
+         *  @brief  返回键值为k的元素的实值
+         *  @throw  std::out_of_range  键值不存在
+         */
+        const mapped_type& at(const key_type& k) const
+        {
+            const mapped_type* p = get(k);
+            if (p == nullptr)
+                throw std::out_of_range("persistent_map::at");
+            return *p;
+        }
+
+        size_type count(const key_type& k) const { return M_find(k) ? 1 : 0; }
+
+        const_iterator find(const key_type& k) const
+        {
+            const_iterator it = lower_bound(k);
+            if (it != end() && compare(k, it->first))
+                return end();
+            return it;
+        }
+
+        /**
+         *  @brief  返回首个键值不小于k的元素
+         */
+        const_iterator lower_bound(const key_type& k) const
+        { return M_descend([&](const node* x) { return !compare(key(x), k); }); }
+
+        /**
+         *  @brief  返回首个键值大于k的元素
+         */
+        const_iterator upper_bound(const key_type& k) const
+        { return M_descend([&](const node* x) { return compare(k, key(x)); }); }
+
+    public:
+        // debug
+
+        /**
+         *  @brief  验证每个节点的高度正确且左右子树高度至多相差1，键值严格递增
+         */
+        bool verify() const { return M_verify(root) >= 0; }
+
+    private:
+        // 返回x子树的高度，不满足条件时返回-1
+        int M_verify(const node* x) const
+        {
+            if (x == nullptr)
+                return 0;
+            const int hl = M_verify(x->left), hr = M_verify(x->right);
+            if (hl < 0 || hr < 0 || hl - hr > 1 || hr - hl > 1)
+                return -1;
+            if ((x->left && !compare(key(x->left), key(x))) || (x->right && !compare(key(x), key(x->right))))
+                return -1;
+            const int h = 1 + (hl > hr ? hl : hr);
+            return h == x->height ? h : -1;
+        }
+    };
+
+} /* namespace STL */
+
+#endif
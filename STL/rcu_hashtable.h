@@ -0,0 +1,423 @@
+#ifndef TINYSTL_RCU_HASHTABLE_H_
+#define TINYSTL_RCU_HASHTABLE_H_
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "allocator.h"
+#include "epoch.h"
+#include "hashtable.h"
+#include "vector.h"
+
+namespace STL
+{
+
+    /**
+     *  读多写少的无锁读hashtable（键值唯一）
+     *
+     *  模板参数与hashtable相同，由ExtractKey从Value中取出键值
+     *
+     *  读者不加锁，也不写任何共享缓存行：
+     *    桶数组及每条链表的指针都是原子指针，写者以release语义发布，读者以acquire语义读取
+     *    读者通过epoch_guard进入临界区，被摘下的节点和桶数组要等到没有读者可能持有时才释放
+     *  写者之间由一把互斥锁串行化：
+     *    插入时把新节点挂到桶头；删除时把前驱的指针绕过该节点，节点本身保持不变
+     *    替换时构造新节点顶替旧节点，因此读者看到的元素永远不会被原地修改
+     *    扩容时把所有元素复制到新的桶数组（copy-on-resize）后一次性发布，旧数组连同旧节点整体回收
+     *
+     *  被摘下的对象在之后的写操作中回收，或在析构时释放
+     *  Value须可复制构造
+     *  写者虽然互斥，但pool_alloc的free-list为全进程共享，仍会与其他线程上的容器冲突，因此Alloc缺省为malloc_alloc
+     */
+    template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc = STL::malloc_alloc>
+    class rcu_hashtable
+    {
+    public:
+        using key_type          = Key;
+        using value_type        = Value;
+        using hasher            = HashFcn;
+        using key_equal         = EqualKey;
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+
+    private:
+        struct node
+        {
+            std::atomic<node*>  next;
+            Value               val;
+
+            template <class... Args>
+            node(Args&&... args) : next(nullptr), val(std::forward<Args>(args)...) { }
+        };
+
+        struct bucket_array
+        {
+            size_type           n;
+            std::atomic<node*>* buckets;
+        };
+
+        // 已摘下、等待回收的对象，epoch为摘下时的回收标记
+        struct retired
+        {
+            void*               p;
+            void                (*deleter)(void*);
+            unsigned long long  epoch;
+        };
+
+        using node_allocator    = STL::allocator<node, Alloc>;
+        using array_allocator   = STL::allocator<bucket_array, Alloc>;
+        using bucket_allocator  = STL::allocator<std::atomic<node*>, Alloc>;
+
+        hasher                      hash;
+        key_equal                   equals;
+        ExtractKey                  get_key;
+        std::atomic<bucket_array*>  table;
+        std::atomic<size_type>      num_elements;
+        std::mutex                  writer;         // 串行化写者
+        STL::vector<retired, Alloc> retired_list;   // 只由持有writer的写者访问
+
+    private:
+        template <class... Args>
+        static node* create_node(Args&&... args)
+        {
+            node* p = node_allocator::allocate();
+            try {
+                STL::construct(p, std::forward<Args>(args)...);
+            } catch(...) {
+                node_allocator::deallocate(p);
+                throw;
+            }
+            return p;
+        }
+
+        static void delete_node(void* p)
+        {
+            STL::destroy(static_cast<node*>(p));
+            node_allocator::deallocate(static_cast<node*>(p));
+        }
+
+        static bucket_array* create_array(size_type n)
+        {
+            bucket_array* t = array_allocator::allocate();
+            try {
+                t->buckets = bucket_allocator::allocate(n);
+            } catch(...) {
+                array_allocator::deallocate(t);
+                throw;
+            }
+            t->n = n;
+            for (size_type i = 0; i < n; ++i)
+                STL::construct(t->buckets + i, nullptr);
+            return t;
+        }
+
+        // 释放桶数组及其上仍挂着的所有节点
+        static void delete_table(void* p)
+        {
+            bucket_array* t = static_cast<bucket_array*>(p);
+            for (size_type i = 0; i < t->n; ++i) {
+                node* cur = t->buckets[i].load(std::memory_order_relaxed);
+                while (cur) {
+                    node* next = cur->next.load(std::memory_order_relaxed);
+                    delete_node(cur);
+                    cur = next;
+                }
+            }
+            bucket_allocator::deallocate(t->buckets, t->n);
+            array_allocator::deallocate(t);
+        }
+
+        size_type bkt_num_key(const key_type& key, size_type n) const
+        { return hash(key) % n; }
+
+        // 在当前桶数组中查找键值为k的节点，读者须处于epoch_guard内，写者须持有writer
+        const node* find_node(const key_type& k) const
+        {
+            const bucket_array* t = table.load(std::memory_order_acquire);
+            const node* cur = t->buckets[bkt_num_key(k, t->n)].load(std::memory_order_acquire);
+            for ( ; cur; cur = cur->next.load(std::memory_order_acquire))
+                if (equals(get_key(cur->val), k))
+                    return cur;
+            return nullptr;
+        }
+
+        // 返回指向键值为k的节点的那个原子指针（桶头或前驱的next），不存在时返回nullptr，须持有writer
+        std::atomic<node*>* find_link(const key_type& k)
+        {
+            bucket_array* t = table.load(std::memory_order_relaxed);
+            std::atomic<node*>* link = t->buckets + bkt_num_key(k, t->n);
+            for (node* cur; (cur = link->load(std::memory_order_relaxed)) != nullptr; link = &cur->next)
+                if (equals(get_key(cur->val), k))
+                    return link;
+            return nullptr;
+        }
+
+        // 将新节点挂到所在桶的头部并发布，须持有writer
+        void link_front(node* tmp)
+        {
+            bucket_array* t = table.load(std::memory_order_relaxed);
+            std::atomic<node*>& head = t->buckets[bkt_num_key(get_key(tmp->val), t->n)];
+            tmp->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            head.store(tmp, std::memory_order_release);
+            num_elements.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 为retire()预留空间，须在摘下对象之前调用，使之后的登记不会因分配失败而抛出异常
+        void reserve_retired()
+        { retired_list.reserve(retired_list.size() + 1); }
+
+        // 登记一个已摘下的对象，并尝试回收，须持有writer且已调用reserve_retired()
+        void retire(void* p, void (*deleter)(void*))
+        {
+            const unsigned long long e = epoch_domain::instance().advance();
+            retired_list.push_back(retired{p, deleter, e});
+            reclaim();
+        }
+
+        // 释放所有已不可能被读者持有的对象，须持有writer
+        void reclaim()
+        {
+            const unsigned long long m = epoch_domain::instance().min_active();
+            size_type j = 0;
+            for (size_type i = 0; i < retired_list.size(); ++i) {
+                if (retired_list[i].epoch < m)
+                    retired_list[i].deleter(retired_list[i].p);
+                else
+                    retired_list[j++] = retired_list[i];
+            }
+            retired_list.erase(retired_list.begin() + j, retired_list.end());
+        }
+
+        // 元素个数超过桶数时，将全部元素复制到新的桶数组后发布，须持有writer
+        void resize_aux(size_type num_elements_hint)
+        {
+            bucket_array* old = table.load(std::memory_order_relaxed);
+            if (num_elements_hint <= old->n)
+                return;
+            const size_type n = next_prime(num_elements_hint);
+            if (n <= old->n)
+                return;
+            bucket_array* tmp = create_array(n);
+            try {
+                for (size_type i = 0; i < old->n; ++i) {
+                    node* cur = old->buckets[i].load(std::memory_order_relaxed);
+                    for ( ; cur; cur = cur->next.load(std::memory_order_relaxed)) {
+                        node* p = create_node(cur->val);
+                        std::atomic<node*>& head = tmp->buckets[bkt_num_key(get_key(p->val), n)];
+                        p->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                        head.store(p, std::memory_order_relaxed);
+                    }
+                }
+                reserve_retired();
+            } catch(...) {
+                delete_table(tmp);
+                throw;
+            }
+            table.store(tmp, std::memory_order_release);
+            retire(old, delete_table);
+        }
+
+    public:
+        // The big five
+
+        explicit rcu_hashtable(size_type n = 100, const hasher& hf = hasher(),
+                               const key_equal& eql = key_equal(), const ExtractKey& ext = ExtractKey())
+        : hash(hf), equals(eql), get_key(ext), table(create_array(next_prime(n))), num_elements(0), writer(), retired_list()
+        { }
+
+        rcu_hashtable(const rcu_hashtable&) = delete;
+        rcu_hashtable& operator=(const rcu_hashtable&) = delete;
+
+        /**
+         *  @brief  destructor
+         *
+         *  析构时不得有其他线程仍在访问
+         */
+        ~rcu_hashtable()
+        {
+            delete_table(table.load(std::memory_order_relaxed));
+            for (size_type i = 0; i < retired_list.size(); ++i)
+                retired_list[i].deleter(retired_list[i].p);
+        }
+
+    public:
+        // 容量，读者可调用
+
+        size_type size() const noexcept { return num_elements.load(std::memory_order_relaxed); }
+        bool empty() const noexcept { return size() == 0; }
+
+        size_type bucket_count() const
+        {
+            epoch_guard guard;
+            return table.load(std::memory_order_acquire)->n;
+        }
+
+    public:
+        // 查找，读者可调用，不加锁
+
+        /**
+         *  @brief  返回键值为k的元素个数
+         */
+        size_type count(const key_type& k) const
+        {
+            epoch_guard guard;
+            return find_node(k) ? 1 : 0;
+        }
+
+        /**
+         *  @brief  对键值为k的元素调用f(const value_type&)
+         *  @return  是否找到
+         *
+         *  f在读临界区内执行，期间元素不会被释放；f返回后不得再持有该元素的引用
+         */
+        template <class F>
+        bool visit(const key_type& k, F f) const
+        {
+            epoch_guard guard;
+            const node* p = find_node(k);
+            if (!p)
+                return false;
+            f(p->val);
+            return true;
+        }
+
+        /**
+         *  @brief  对调用时刻所发布的桶数组上的所有元素调用f(const value_type&)
+         */
+        template <class F>
+        void visit_all(F f) const
+        {
+            epoch_guard guard;
+            const bucket_array* t = table.load(std::memory_order_acquire);
+            for (size_type i = 0; i < t->n; ++i) {
+                const node* cur = t->buckets[i].load(std::memory_order_acquire);
+                for ( ; cur; cur = cur->next.load(std::memory_order_acquire))
+                    f(cur->val);
+            }
+        }
+
+    public:
+        // 修改器，写者之间互斥
+
+        /**
+         *  @brief  插入元素x
+         *  @return  是否插入成功，键值已存在时返回false
+         */
+        bool insert(const value_type& x)
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            if (find_node(get_key(x)))
+                return false;
+            resize_aux(size() + 1);
+            link_front(create_node(x));
+            return true;
+        }
+
+        /**
+         *  @brief  以args原地构造元素并插入
+         *  @return  是否插入成功
+         */
+        template <class... Args>
+        bool emplace(Args&&... args)
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            node* tmp = create_node(std::forward<Args>(args)...);
+            if (find_node(get_key(tmp->val))) {
+                delete_node(tmp);
+                return false;
+            }
+            try {
+                resize_aux(size() + 1);
+            } catch(...) {
+                delete_node(tmp);
+                throw;
+            }
+            link_front(tmp);
+            return true;
+        }
+
+        /**
+         *  @brief  插入x，键值已存在时以x替换原有元素
+         *  @return  是否插入了新元素
+         *
+         *  原有元素不会被原地修改，仍在读取它的读者看到的是替换前的值
+         */
+        bool insert_or_replace(const value_type& x)
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            std::atomic<node*>* link = find_link(get_key(x));
+            if (!link) {
+                resize_aux(size() + 1);
+                link_front(create_node(x));
+                return true;
+            }
+            node* old = link->load(std::memory_order_relaxed);
+            node* tmp = create_node(x);
+            try {
+                reserve_retired();
+            } catch(...) {
+                delete_node(tmp);
+                throw;
+            }
+            tmp->next.store(old->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            link->store(tmp, std::memory_order_release);
+            retire(old, delete_node);
+            return false;
+        }
+
+        /**
+         *  @brief  移除键值等于k的元素
+         *  @return  移除的元素个数
+         */
+        size_type erase(const key_type& k)
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            std::atomic<node*>* link = find_link(k);
+            if (!link)
+                return 0;
+            reserve_retired();
+            node* old = link->load(std::memory_order_relaxed);
+            link->store(old->next.load(std::memory_order_relaxed), std::memory_order_release);
+            num_elements.fetch_sub(1, std::memory_order_relaxed);
+            retire(old, delete_node);
+            return 1;
+        }
+
+        /**
+         *  @brief  清除所有元素，发布一个同样大小的空桶数组
+         */
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            bucket_array* old = table.load(std::memory_order_relaxed);
+            bucket_array* tmp = create_array(old->n);
+            try {
+                reserve_retired();
+            } catch(...) {
+                delete_table(tmp);
+                throw;
+            }
+            table.store(tmp, std::memory_order_release);
+            num_elements.store(0, std::memory_order_relaxed);
+            retire(old, delete_table);
+        }
+
+        /**
+         *  @brief  预留至少容纳num_elements_hint个元素的桶
+         */
+        void resize(size_type num_elements_hint)
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            resize_aux(num_elements_hint);
+        }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return hash; }
+        key_equal key_eq() const { return equals; }
+    };
+
+} /* namespace STL */
+
+#endif
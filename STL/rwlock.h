@@ -0,0 +1,59 @@
+#ifndef TINYSTL_RWLOCK_H_
+#define TINYSTL_RWLOCK_H_ 
+
+#include <pthread.h>
+
+namespace STL
+{
+
+    // 读写锁，封装pthread_rwlock_t
+    // 多个读者可同时持有读锁，写者独占
+    class rw_lock
+    {
+    private:
+        pthread_rwlock_t rw;
+
+    public:
+        rw_lock() { pthread_rwlock_init(&rw, nullptr); }
+        ~rw_lock() { pthread_rwlock_destroy(&rw); }
+
+        rw_lock(const rw_lock&) = delete;
+        rw_lock& operator=(const rw_lock&) = delete;
+
+        void lock_shared() { pthread_rwlock_rdlock(&rw); }
+        void unlock_shared() { pthread_rwlock_unlock(&rw); }
+        void lock() { pthread_rwlock_wrlock(&rw); }
+        void unlock() { pthread_rwlock_unlock(&rw); }
+    };
+
+    // 作用域内持有读锁
+    class read_guard
+    {
+    private:
+        rw_lock& l;
+
+    public:
+        explicit read_guard(rw_lock& x) : l(x) { l.lock_shared(); }
+        ~read_guard() { l.unlock_shared(); }
+
+        read_guard(const read_guard&) = delete;
+        read_guard& operator=(const read_guard&) = delete;
+    };
+
+    // 作用域内持有写锁
+    class write_guard
+    {
+    private:
+        rw_lock& l;
+
+    public:
+        explicit write_guard(rw_lock& x) : l(x) { l.lock(); }
+        ~write_guard() { l.unlock(); }
+
+        write_guard(const write_guard&) = delete;
+        write_guard& operator=(const write_guard&) = delete;
+    };
+
+} /* namespace STL */
+
+#endif
@@ -3,14 +3,20 @@
 
 #include <functional>
 #include <initializer_list>
+#include <type_traits>
 
 #include "tree.h"
 
 namespace STL
 {
 
+    /**
+     *  集合
+     *
+     *  @tparam  Augment  红黑树节点附加数据策略；为rb_tree_count_augment时支持rank、select等顺序统计
+     */
     template <class Key, class Compare = std::less<Key>,
-              class Alloc = STL::pool_alloc>
+              class Alloc = STL::pool_alloc, class Augment = rb_tree_no_augment>
     class set
     { 
     public:
@@ -20,9 +26,12 @@ namespace STL
         using value_compare = Compare;
 
     private:
-        using Rep_type  = STL::rb_tree<key_type, value_type, std::_Identity<value_type>, key_compare>;
+        using Rep_type  = STL::rb_tree<key_type, value_type, std::_Identity<value_type>, key_compare, Alloc, Augment>;
         Rep_type t;     // 使用红黑树represent集合
 
+        template <class, class, class, class>
+        friend class set;
+
     public:
         using pointer           = typename Rep_type::pointer;
         using const_pointer     = typename Rep_type::const_pointer;
@@ -33,6 +42,19 @@ namespace STL
         using const_iterator    = typename Rep_type::const_iterator;
         using size_type         = typename Rep_type::size_type;
         using difference_type   = typename Rep_type::difference_type;
+        using node_type         = typename Rep_type::node_type;
+        using insert_return_type = node_insert_return<iterator, node_type>;
+
+    private:
+        // Compare声明了is_transparent时，查找接口接受任意可与key_type比较的类型K
+        template <class K>
+        using transparent_key = typename std::enable_if<STL::is_transparent<Compare>::value, K>::type;
+
+        // erase的异构版本还须排除能转换为迭代器的K，以免与erase(const_iterator)冲突
+        template <class K>
+        using transparent_erase_key = typename std::enable_if<!std::is_convertible<K, iterator>::value &&
+                                                              !std::is_convertible<K, const_iterator>::value,
+                                                              transparent_key<K>>::type;
 
     public:
         // The big five
@@ -51,6 +73,16 @@ namespace STL
         set(std::initializer_list<value_type> l, const Compare& cmp = Compare())
         : t(cmp) { t.insert_unique(l.begin(), l.end()); }
 
+        /**
+         *  @brief  以已升序排列的范围构造，耗时O(n)
+         */ 
+        template <class InputIterator>
+        set(sorted_range_t, InputIterator first, InputIterator last, const Compare& cmp = Compare())
+        : t(cmp) { t.insert_unique(sorted_range, first, last); }
+
+        set(sorted_range_t, std::initializer_list<value_type> l, const Compare& cmp = Compare())
+        : t(cmp) { t.insert_unique(sorted_range, l.begin(), l.end()); }
+
         /**
          *  @brief  copy constructor
          */ 
@@ -112,6 +144,24 @@ namespace STL
             return pair<iterator, bool>(p.first, p.second);
         }
 
+        pair<iterator, bool> insert(value_type&& x)
+        {
+            pair<typename Rep_type::iterator, bool> p = t.insert_unique(std::move(x));
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
+        /**
+         *  @brief  以pos为提示插入值为x的元素
+         *  @return  指向新插入元素或键值重复的旧元素
+         *
+         *  x恰好应插在pos之前时为均摊O(1)，例如按升序插入时以end()为提示
+         */ 
+        iterator insert(const_iterator pos, const value_type& x)
+        { return t.insert_unique(pos, x); }
+
+        iterator insert(const_iterator pos, value_type&& x)
+        { return t.insert_unique(pos, std::move(x)); }
+
         /**
          *  @brief  插入来自范围[first, last)的元素
          */ 
@@ -119,12 +169,39 @@ namespace STL
         void insert(InputIterator first, InputIterator last)
         { t.insert_unique(first, last); }
 
+        template <class InputIterator>
+        void insert(sorted_range_t, InputIterator first, InputIterator last)
+        { t.insert_unique(sorted_range, first, last); }
+
+        void insert(sorted_range_t, std::initializer_list<value_type> l)
+        { t.insert_unique(sorted_range, l.begin(), l.end()); }
+
         /**
          *  @brief  插入来自initialize list的元素
          */ 
         void insert(std::initializer_list<value_type> l)
         { this->insert(l.begin(), l.end()); }
 
+        /**
+         *  @brief  以args原地构造元素
+         *  @return  含义同insert
+         *
+         *  若唯一实参即为元素值，则元素已存在时不构造节点
+         */
+        template <class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        {
+            pair<typename Rep_type::iterator, bool> p = t.emplace_unique(std::forward<Args>(args)...);
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
+        /**
+         *  @brief  以pos为提示，以args原地构造元素
+         */
+        template <class... Args>
+        iterator emplace_hint(const_iterator pos, Args&&... args)
+        { return t.emplace_hint_unique(pos, std::forward<Args>(args)...); }
+
         /**
          *  @brief  移除位于pos的元素
          */ 
@@ -144,6 +221,70 @@ namespace STL
         size_type erase(const key_type& x)
         { return t.erase(x); }
 
+        template <class K, class = transparent_erase_key<K>>
+        size_type erase(const K& x)
+        { return t.erase(x); }
+
+        /**
+         *  @brief  将pos所指元素的节点从set中摘下，交给节点句柄
+         */
+        node_type extract(const_iterator pos) { return t.extract(pos); }
+        node_type extract(const key_type& k) { return t.extract(k); }
+
+        template <class K, class = transparent_erase_key<K>>
+        node_type extract(const K& k) { return t.extract(k); }
+
+        /**
+         *  @brief  插入节点句柄所持的节点，不分配内存也不复制元素
+         */
+        insert_return_type insert(node_type&& nh)
+        {
+            typename Rep_type::insert_return_type r = t.insert_unique(std::move(nh));
+            return insert_return_type{r.position, r.inserted, std::move(r.node)};
+        }
+
+        /**
+         *  @brief  将src中在本set中不存在的元素的节点移入本set
+         *
+         *  同类型的set按子树批量合并，耗时O(m log(n/m + 1))，m、n为两者中较小、较大的元素个数
+         *  threads为线程数，0表示使用硬件线程数
+         */
+        void merge(set& src, unsigned threads = 1) { t.set_union(src.t, threads); }
+        void merge(set&& src, unsigned threads = 1) { t.set_union(src.t, threads); }
+
+        template <class C2>
+        void merge(set<Key, C2, Alloc, Augment>& src) { t.merge_unique(src.t); }
+
+        template <class C2>
+        void merge(set<Key, C2, Alloc, Augment>&& src) { t.merge_unique(src.t); }
+
+        /**
+         *  以下集合运算将src的节点移入本set或销毁，运算后src为空，耗时同merge
+         */
+
+        /**
+         *  @brief  并集，键值重复时保留本set中的元素
+         */
+        void set_union(set& src, unsigned threads = 1)
+        {
+            t.set_union(src.t, threads);
+            src.clear();
+        }
+
+        void set_union(set&& src, unsigned threads = 1) { set_union(src, threads); }
+
+        /**
+         *  @brief  交集，保留本set中的元素
+         */
+        void set_intersection(set& src, unsigned threads = 1) { t.set_intersection(src.t, threads); }
+        void set_intersection(set&& src, unsigned threads = 1) { t.set_intersection(src.t, threads); }
+
+        /**
+         *  @brief  差集，移除键值在src中出现的元素
+         */
+        void set_difference(set& src, unsigned threads = 1) { t.set_difference(src.t, threads); }
+        void set_difference(set&& src, unsigned threads = 1) { t.set_difference(src.t, threads); }
+
         /**
          *  @brief  与set x交换数据
          */ 
@@ -158,6 +299,10 @@ namespace STL
         size_type count(const key_type& k) const 
         { return t.count(k); }
 
+        template <class K, class = transparent_key<K>>
+        size_type count(const K& k) const 
+        { return t.count(k); }
+
         /**
          *  @brief  查寻set中是否有键值等于k的元素
          *
@@ -169,6 +314,14 @@ namespace STL
         const_iterator find(const key_type& k) const 
         { return t.find(k); }
 
+        template <class K, class = transparent_key<K>>
+        iterator find(const K& k)
+        { return t.find(k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator find(const K& k) const 
+        { return t.find(k); }
+
         /**
          *  @brief  查寻set中所有键值为k的元素范围，范围以返回的两个迭代器定义
          *  @return  第一个迭代器指向首个键值不小于k的元素，第二个迭代器指向首个键值大于k的元素
@@ -177,12 +330,20 @@ namespace STL
          */ 
         pair<iterator, iterator> equal_range(const key_type& k) const 
         { return t.equal_range(k); }
+
+        template <class K, class = transparent_key<K>>
+        pair<iterator, iterator> equal_range(const K& k) const 
+        { return t.equal_range(k); }
         
         /**
          *  @brief  返回首个不小于k的元素的迭代器
          */
         iterator lower_bound(const key_type& k) const 
         { return t.lower_bound(k); } 
+
+        template <class K, class = transparent_key<K>>
+        iterator lower_bound(const K& k) const 
+        { return t.lower_bound(k); } 
         
         /**
          *  @brief  返回首个大于k的元素的迭代器
@@ -190,6 +351,60 @@ namespace STL
         iterator upper_bound(const key_type& k) const 
         { return t.upper_bound(k); }
 
+        template <class K, class = transparent_key<K>>
+        iterator upper_bound(const K& k) const 
+        { return t.upper_bound(k); }
+
+    public:
+        // 顺序统计，须以rb_tree_count_augment为Augment，均为O(log n)
+
+        /**
+         *  @brief  小于k的元素个数
+         */
+        size_type rank(const key_type& k) const
+        { return t.rank(k); }
+
+        template <class K, class = transparent_key<K>>
+        size_type rank(const K& k) const
+        { return t.rank(k); }
+
+        /**
+         *  @brief  返回第i + 1小的元素，i >= size()时返回end()
+         */
+        iterator select(size_type i) const
+        { return t.select(i); }
+
+        /**
+         *  @brief  返回pos所指元素的下标
+         */
+        size_type index_of(const_iterator pos) const
+        { return t.index_of(pos); }
+
+        difference_type distance(const_iterator first, const_iterator last) const
+        { return t.distance(first, last); }
+
+    public:
+        // 附加数据的查询，参见rb_tree
+        using meta_type = typename Rep_type::meta_type;
+
+        /**
+         *  @brief  键值在[lo, hi)内的元素的汇总值，Augment须为rb_tree_monoid_augment
+         */
+        meta_type aggregate(const key_type& lo, const key_type& hi) const
+        { return t.aggregate(lo, hi); }
+
+        meta_type aggregate() const
+        { return t.aggregate(); }
+
+        /**
+         *  @brief  与闭区间[lo, hi]相交的区间查询，Augment须为rb_tree_interval_augment
+         */
+        const_iterator find_overlap(const key_type& lo, const key_type& hi) const
+        { return t.find_overlap(lo, hi); }
+
+        template <class F>
+        void for_each_overlap(const key_type& lo, const key_type& hi, F f) const
+        { t.for_each_overlap(lo, hi, f); }
     };
 
 } /* namespace STL */ 
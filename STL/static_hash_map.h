@@ -0,0 +1,357 @@
+#ifndef TINYSTL_STATIC_HASH_MAP_H_
+#define TINYSTL_STATIC_HASH_MAP_H_
+
+#include <algorithm>    // for std::sort
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#include "allocator.h"
+#include "hash.h"
+#include "uninitialized.h"
+#include "vector.h"
+
+using std::pair;
+
+namespace STL
+{
+
+    /**
+     *  构造后不可修改的map，以最小完美hash定位元素，查找只需一次探测
+     *
+     *  @tparam  Key        键值类型
+     *  @tparam  T          实值类型
+     *  @tparam  HashFcn    hash函数类型，不同的键值须得到不同的hash值
+     *  @tparam  EqualKey   判断键值是否相同的函数对象
+     *  @tparam  Alloc      空间分配器
+     *
+     *  采用CHD（hash and displace）算法：键值按hash值分入约n/4个组，
+     *  每组记录一个位移d，组内键值以(hash值, d)算出各自的槽位，n个元素恰好占满n个槽位
+     *  构造时按组从大到小依次为每组寻找使组内键值都落在空槽位上的最小d
+     *  查找时读一个位移、算一次槽位、比较一次键值；每个元素额外只占约1字节（每组4字节）
+     */
+    template <class Key,
+              class T,
+              class HashFcn = STL::hash<Key>,
+              class EqualKey = std::equal_to<Key>,
+              class Alloc = STL::pool_alloc>
+    class static_hash_map
+    {
+    public:
+        using key_type          = Key;
+        using mapped_type       = T;
+        using value_type        = pair<const Key, T>;
+        using hasher            = HashFcn;
+        using key_equal         = EqualKey;
+
+        using size_type         = size_t;
+        using difference_type   = ptrdiff_t;
+        using pointer           = const value_type*;
+        using const_pointer     = const value_type*;
+        using reference         = const value_type&;
+        using const_reference   = const value_type&;
+        using iterator          = const value_type*;
+        using const_iterator    = const value_type*;
+
+    private:
+        using slot_allocator    = STL::allocator<value_type, Alloc>;
+
+        enum { bucket_load = 4, max_attempts = 16 };
+
+        value_type*         slots;          // n个槽位，恰好存放n个元素
+        size_type           n_elements;
+        STL::vector<uint32_t> disp;         // 每组的位移
+        uint64_t            seed;           // 分组所用的种子，构造失败重试时更换
+        hasher              hash;
+        key_equal           equal;
+
+    private:
+        // 将h均匀地映射到[0, n)，以乘法代替取模
+        static size_type reduce(uint64_t h, size_type n)
+        {
+            uint64_t lo = h, hi = n;
+            hash_mum(&lo, &hi);
+            return static_cast<size_type>(hi);
+        }
+
+        size_type bucket_of(uint64_t h) const
+        { return reduce(hash_mix(h ^ seed, hash_secret[0]), disp.size()); }
+
+        size_type slot_of(uint64_t h, uint32_t d) const
+        { return reduce(hash_mix(h ^ hash_secret[1], seed ^ (hash_secret[2] * (d + 1ull))), n_elements); }
+
+        /**
+         *  为所有键值寻找位移，成功时pos[i]为第i个键值的槽位
+         *  @return  是否成功，失败时应更换种子重试
+         */
+        bool build_aux(const STL::vector<uint64_t>& h, STL::vector<size_type>& pos)
+        {
+            const size_type n = h.size();
+            const size_type r = disp.size();
+
+            // 按组计数排序，members[first[b], first[b + 1])为第b组的键值下标
+            STL::vector<size_type> first(r + 1, size_type(0));
+            STL::vector<size_type> bkt(n);
+            for (size_type i = 0; i < n; ++i) {
+                bkt[i] = bucket_of(h[i]);
+                ++first[bkt[i] + 1];
+            }
+            for (size_type b = 0; b < r; ++b)
+                first[b + 1] += first[b];
+            STL::vector<size_type> members(n);
+            {
+                STL::vector<size_type> next(first.begin(), first.end() - 1);
+                for (size_type i = 0; i < n; ++i)
+                    members[next[bkt[i]]++] = i;
+            }
+
+            // 大组的约束最多，先处理
+            STL::vector<size_type> order(r);
+            for (size_type b = 0; b < r; ++b)
+                order[b] = b;
+            std::sort(order.begin(), order.end(), [&first](size_type x, size_type y) {
+                return first[x + 1] - first[x] > first[y + 1] - first[y];
+            });
+
+            STL::vector<char> taken(n, char(0));
+            STL::vector<size_type> tried;
+            const uint64_t max_disp = 64 * static_cast<uint64_t>(n) + 1024;
+            for (size_type k = 0; k < r; ++k) {
+                const size_type b = order[k];
+                const size_type lo = first[b], hi = first[b + 1];
+                if (lo == hi)
+                    break;
+                uint64_t d = 0;
+                for ( ; d < max_disp; ++d) {
+                    tried.clear();
+                    size_type i = lo;
+                    for ( ; i < hi; ++i) {
+                        const size_type p = slot_of(h[members[i]], static_cast<uint32_t>(d));
+                        if (taken[p])
+                            break;
+                        taken[p] = 1;
+                        tried.push_back(p);
+                    }
+                    if (i == hi)
+                        break;
+                    for (size_type j = 0; j < tried.size(); ++j)
+                        taken[tried[j]] = 0;
+                }
+                if (d == max_disp)
+                    return false;
+                disp[b] = static_cast<uint32_t>(d);
+                for (size_type i = lo; i < hi; ++i)
+                    pos[members[i]] = tried[i - lo];
+            }
+            return true;
+        }
+
+        // 以items中的元素构造，键值重复时保留先出现的元素
+        void build(STL::vector<pair<Key, T>>& items)
+        {
+            // 去除重复的键值；不同的键值hash值相同时无法区分，只能报错
+            STL::vector<uint64_t> h;
+            {
+                STL::vector<pair<uint64_t, size_type>> sorted(items.size());
+                for (size_type i = 0; i < items.size(); ++i)
+                    sorted[i] = pair<uint64_t, size_type>(hash(items[i].first), i);
+                std::sort(sorted.begin(), sorted.end());
+                STL::vector<char> keep(items.size(), char(1));
+                for (size_type i = 0; i < sorted.size(); ) {
+                    size_type j = i + 1;
+                    for ( ; j < sorted.size() && sorted[j].first == sorted[i].first; ++j) {
+                        if (!equal(items[sorted[j].second].first, items[sorted[i].second].first))
+                            throw std::invalid_argument("static_hash_map: distinct keys with the same hash value");
+                        keep[sorted[j].second] = 0;
+                    }
+                    i = j;
+                }
+                size_type m = 0;
+                for (size_type i = 0; i < items.size(); ++i) {
+                    if (keep[i]) {
+                        if (m != i)
+                            items[m] = std::move(items[i]);
+                        h.push_back(hash(items[m].first));
+                        ++m;
+                    }
+                }
+                items.erase(items.begin() + m, items.end());
+            }
+
+            const size_type n = items.size();
+            n_elements = n;
+            if (n == 0)
+                return;
+            disp.resize(n / bucket_load + 1, uint32_t(0));
+            STL::vector<size_type> pos(n);
+            uint64_t s = 0;
+            for (int attempt = 0; ; ++attempt) {
+                seed = hash_mix(s ^ hash_secret[3], hash_secret[attempt % 4]);
+                if (build_aux(h, pos))
+                    break;
+                if (attempt + 1 == max_attempts)
+                    throw std::runtime_error("static_hash_map: failed to build a perfect hash");
+                s = seed;
+            }
+
+            slots = slot_allocator::allocate(n);
+            size_type i = 0;
+            try {
+                // 按槽位顺序构造，异常时可以按同样的顺序析构
+                STL::vector<size_type> at(n);
+                for (size_type j = 0; j < n; ++j)
+                    at[pos[j]] = j;
+                for ( ; i < n; ++i)
+                    STL::construct(slots + i, std::move(items[at[i]]));
+            } catch(...) {
+                STL::destroy(slots, slots + i);
+                slot_allocator::deallocate(slots, n);
+                slots = nullptr;
+                n_elements = 0;
+                throw;
+            }
+        }
+
+        void init(STL::vector<pair<Key, T>>& items)
+        {
+            slots = nullptr;
+            n_elements = 0;
+            seed = 0;
+            build(items);
+        }
+
+    public:
+        // The big five
+
+        /**
+         *  @brief  constructor，以[first, last)中的元素构造，键值重复时保留先出现的元素
+         *  @throw  std::invalid_argument  不同的键值hash值相同
+         */
+        template <class InputIterator>
+        static_hash_map(InputIterator first, InputIterator last,
+                        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : hash(hf), equal(eql)
+        {
+            STL::vector<pair<Key, T>> items;
+            for ( ; first != last; ++first)
+                items.push_back(pair<Key, T>(first->first, first->second));
+            init(items);
+        }
+
+        static_hash_map(std::initializer_list<value_type> l,
+                        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : static_hash_map(l.begin(), l.end(), hf, eql) { }
+
+        static_hash_map()
+        : slots(nullptr), n_elements(0), seed(0) { }
+
+        /**
+         *  @brief  copy constructor，直接复制槽位与位移，不重新构造完美hash
+         */
+        static_hash_map(const static_hash_map& x)
+        : slots(nullptr), n_elements(0), disp(x.disp), seed(x.seed), hash(x.hash), equal(x.equal)
+        {
+            if (x.n_elements) {
+                slots = slot_allocator::allocate(x.n_elements);
+                try {
+                    STL::uninitialized_copy(x.slots, x.slots + x.n_elements, slots);
+                } catch(...) {
+                    slot_allocator::deallocate(slots, x.n_elements);
+                    throw;
+                }
+                n_elements = x.n_elements;
+            }
+        }
+
+        static_hash_map(static_hash_map&& x)
+        : slots(x.slots), n_elements(x.n_elements), disp(std::move(x.disp)), seed(x.seed), hash(x.hash), equal(x.equal)
+        {
+            x.slots = nullptr;
+            x.n_elements = 0;
+        }
+
+        static_hash_map& operator=(const static_hash_map& x)
+        {
+            if (this != &x) {
+                static_hash_map tmp(x);
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        ~static_hash_map()
+        {
+            if (slots) {
+                STL::destroy(slots, slots + n_elements);
+                slot_allocator::deallocate(slots, n_elements);
+            }
+        }
+
+        void swap(static_hash_map& x)
+        {
+            STL::swap(slots, x.slots);
+            STL::swap(n_elements, x.n_elements);
+            disp.swap(x.disp);
+            STL::swap(seed, x.seed);
+            STL::swap(hash, x.hash);
+            STL::swap(equal, x.equal);
+        }
+
+    public:
+        // 迭代器，按槽位顺序遍历
+        const_iterator begin() const noexcept { return slots; }
+        const_iterator end() const noexcept { return slots + n_elements; }
+        const_iterator cbegin() const noexcept { return begin(); }
+        const_iterator cend() const noexcept { return end(); }
+
+        // 容量
+        size_type size() const noexcept { return n_elements; }
+        bool empty() const noexcept { return n_elements == 0; }
+
+        /**
+         *  @brief  分组个数，位移数组占 4 * bucket_count() 字节
+         */
+        size_type bucket_count() const noexcept { return disp.size(); }
+
+    public:
+        // 查找
+
+        /**
+         *  @brief  返回键值为k的元素，不存在时返回end()
+         *
+         *  不在构造集合中的键值也会算出某个槽位，须比较键值才能确认
+         */
+        const_iterator find(const key_type& k) const
+        {
+            if (n_elements == 0)
+                return end();
+            const uint64_t h = hash(k);
+            const value_type* p = slots + slot_of(h, disp[bucket_of(h)]);
+            return equal(p->first, k) ? p : end();
+        }
+
+        size_type count(const key_type& k) const
+        { return find(k) == end() ? 0 : 1; }
+
+        /**
+         *  @brief  返回键值为k的元素的实值
+         *  @throw  std::out_of_range  键值不存在
+         */
+        const mapped_type& at(const key_type& k) const
+        {
+            const_iterator it = find(k);
+            if (it == end())
+                throw std::out_of_range("static_hash_map::at");
+            return it->second;
+        }
+
+    public:
+        // 观察器
+        hasher hash_function() const { return hash; }
+        key_equal key_eq() const { return equal; }
+    };
+
+} /* namespace STL */
+
+#endif
@@ -1,12 +1,18 @@
 #ifndef TINYSTL_TREE_H_ 
 #define TINYSTL_TREE_H_ 
 
+#include <cstdint>
 #include <memory>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "algo.h"
 #include "allocator.h"
 #include "iterator.h"
+#include "node_handle.h"
+#include "parallel.h"
+#include "type_traits.h"
 
 using std::pair;
 
@@ -20,10 +26,25 @@ namespace STL
         using Base_ptr          = rb_tree_node_base*;
         using Const_Base_ptr    = const rb_tree_node_base*;
 
-        rb_tree_color color;    // 节点颜色
-        Base_ptr parent;        // 父节点
+        // 父节点指针与颜色合为一个字：节点至少按2字节对齐，指针最低位恒为0，用来存放颜色
+        // 节点头部由4个字缩减为3个字
+        uintptr_t parent_color;
         Base_ptr left;          // 左节点
         Base_ptr right;         // 右节点
+
+        // 父节点
+        Base_ptr parent() const noexcept
+        { return reinterpret_cast<Base_ptr>(parent_color & ~static_cast<uintptr_t>(1)); }
+
+        void set_parent(Const_Base_ptr p) noexcept
+        { parent_color = reinterpret_cast<uintptr_t>(p) | (parent_color & 1); }
+
+        // 节点颜色
+        rb_tree_color color() const noexcept
+        { return static_cast<rb_tree_color>(parent_color & 1); }
+
+        void set_color(rb_tree_color c) noexcept
+        { parent_color = (parent_color & ~static_cast<uintptr_t>(1)) | static_cast<uintptr_t>(c); }
         
         // RB-tree最小值节点
         static Base_ptr minimum(Base_ptr x) 
@@ -70,10 +91,10 @@ namespace STL
             while (x_copy->left)
                 x_copy = x_copy->left;
         } else {    // 无右子节点
-            rb_tree_node_base* y = x_copy->parent;
+            rb_tree_node_base* y = x_copy->parent();
             while (x_copy == y->right) {    // 沿父节点向上找，直到现行节点x_copy是y的左子节点
                 x_copy = y;
-                y = y->parent;
+                y = y->parent();
             }
             if (x_copy->right != y)
                 x_copy = y;
@@ -89,10 +110,10 @@ namespace STL
             while (x_copy->left)
                 x_copy = x_copy->left;
         } else {    // 无右子节点
-            const rb_tree_node_base* y = x_copy->parent;
+            const rb_tree_node_base* y = x_copy->parent();
             while (x_copy == y->right) {    // 沿父节点向上找，直到现行节点x_copy是y的左子节点
                 x_copy = y;
-                y = y->parent;
+                y = y->parent();
             }
             if (x_copy->right != y)
                 x_copy = y;
@@ -104,7 +125,7 @@ namespace STL
     rb_tree_node_base* rb_tree_decrement(rb_tree_node_base* x) noexcept
     {
         rb_tree_node_base* x_copy = x;
-        if (x_copy->color == red && x_copy->parent->parent == x_copy)   // x为header时
+        if (x_copy->color() == red && x_copy->parent()->parent() == x_copy)   // x为header时
            x_copy = x_copy->right; 
         else if (x_copy->left) {  // x有左子节点
             rb_tree_node_base* y = x_copy->left;
@@ -112,10 +133,10 @@ namespace STL
                 y = y->right;
             x_copy = y;
         } else {    // 非header，也无左子节点
-            rb_tree_node_base* y = x_copy->parent;
+            rb_tree_node_base* y = x_copy->parent();
             while (x_copy == y->left) { // 沿父节点向上找，直到现行节点x_copy是y的右子节点
                 x_copy = y;
-                y = y->parent;
+                y = y->parent();
             }
             x_copy = y;
         }
@@ -125,7 +146,7 @@ namespace STL
     const rb_tree_node_base* rb_tree_decrement(const rb_tree_node_base* x)
     {
         const rb_tree_node_base* x_copy = x;
-        if (x_copy->color == red && x_copy->parent->parent == x_copy)   // x为header时
+        if (x_copy->color() == red && x_copy->parent()->parent() == x_copy)   // x为header时
            x_copy = x_copy->right; 
         else if (x_copy->left) {  // x有左子节点
             const rb_tree_node_base* y = x_copy->left;
@@ -133,10 +154,10 @@ namespace STL
                 y = y->right;
             x_copy = y;
         } else {    // 非header，也无左子节点
-            const rb_tree_node_base* y = x_copy->parent;
+            const rb_tree_node_base* y = x_copy->parent();
             while (x_copy == y->left) { // 沿父节点向上找，直到现行节点x_copy是y的右子节点
                 x_copy = y;
-                y = y->parent;
+                y = y->parent();
             }
             x_copy = y;
         }
@@ -251,99 +272,128 @@ namespace STL
         bool operator!=(const Self& x) const { return node != x.node; }
     };
 
-    // 在旋转点x处进行左旋转
-    void rb_tree_rotate_left(rb_tree_node_base* x, rb_tree_node_base*& root)
+    static_assert(alignof(rb_tree_node_base) >= 2, "the lowest bit of a node pointer holds the color");
+
+    // 节点附加数据的更新函数：子树结构改变后，以孩子的附加数据重新计算x的附加数据
+    // 普通rb_tree没有附加数据，使用什么都不做的rb_tree_no_update
+    struct rb_tree_no_update
+    {
+        void operator()(rb_tree_node_base*) const noexcept { }
+    };
+
+    // 自x向上至根节点，依次更新路径上各节点的附加数据
+    template <class Update>
+    inline void rb_tree_update_path(rb_tree_node_base* x, rb_tree_node_base& header, Update update)
+    {
+        for ( ; x != &header; x = x->parent())
+            update(x);
+    }
+
+    inline void rb_tree_update_path(rb_tree_node_base*, rb_tree_node_base&, rb_tree_no_update) noexcept { }
+
+    // 在旋转点x处进行左旋转，header.parent()为根节点
+    // 旋转只改变x与y两个节点的子树，先更新下移的x，再更新上移的y
+    template <class Update = rb_tree_no_update>
+    void rb_tree_rotate_left(rb_tree_node_base* x, rb_tree_node_base& header, Update update = Update())
     {
         rb_tree_node_base* y = x->right;    // y指向旋转点的右孩子
         x->right = y->left;
-        if (y->left)    y->left->parent = x;    // 设完A->child = B，记得设置B->parent = A
+        if (y->left)    y->left->set_parent(x);    // 设完A->child = B，记得设置B->parent = A
         
         // 令y完全接替x的位置
-        y->parent = x->parent;
-        if (x == root)                  // x为根节点  
-            root = y;
-        else if (x == x->parent->left)  // x为其父的左孩子
-            x->parent->left = y;
+        y->set_parent(x->parent());
+        if (x == header.parent())       // x为根节点  
+            header.set_parent(y);
+        else if (x == x->parent()->left)  // x为其父的左孩子
+            x->parent()->left = y;
         else                            // x为其父的右孩子
-            x->parent->right = y;
+            x->parent()->right = y;
         y->left = x;
-        x->parent = y;
+        x->set_parent(y);
+        update(x);
+        update(y);
     }
 
     // 在旋转点x处进行右旋转，代码与左旋转完全对称
-    void rb_tree_rotate_right(rb_tree_node_base* x, rb_tree_node_base*& root)
+    template <class Update = rb_tree_no_update>
+    void rb_tree_rotate_right(rb_tree_node_base* x, rb_tree_node_base& header, Update update = Update())
     {
         rb_tree_node_base* y = x->left;
         x->left = y->right;
-        if (y->right)    y->right->parent = x;
-        y->parent = x->parent;
-        if (x == root)  
-            root = y;
-        else if (x == x->parent->right)
-            x->parent->right = y;
+        if (y->right)    y->right->set_parent(x);
+        y->set_parent(x->parent());
+        if (x == header.parent())  
+            header.set_parent(y);
+        else if (x == x->parent()->right)
+            x->parent()->right = y;
         else 
-            x->parent->left = y;
+            x->parent()->left = y;
         y->right = x;
-        x->parent = y;
+        x->set_parent(y);
+        update(x);
+        update(y);
     }
 
     /**
      *  @brief  插入节点后，重新调整RB-tree至平衡
      *  @param  x  指向新增节点
-     *  @param  root  指向根节点
+     *  @param  header  rb_tree的header，header.parent()为根节点
+     *  @param  update  附加数据的更新函数，新节点至根节点的路径先全部更新，旋转时再更新旋转的两个节点
      */ 
-    void rb_tree_rebalance(rb_tree_node_base* x, rb_tree_node_base*& root)
+    template <class Update = rb_tree_no_update>
+    void rb_tree_rebalance(rb_tree_node_base* x, rb_tree_node_base& header, Update update = Update())
     {
-        x->color = red;     // 新节点必为红
-        while (x != root && x->parent->color == red) {
+        rb_tree_update_path(x, header, update);
+        x->set_color(red);     // 新节点必为红
+        while (x != header.parent() && x->parent()->color() == red) {
             // x的父节点为祖父节点的左孩子
-            if (x->parent == x->parent->parent->left) {
-                rb_tree_node_base* y = x->parent->parent->right;    // y为x的伯父节点
-                if (y && y->color == red) {    // 伯父节点存在且为红
-                    x->parent->color = black;
-                    y->color = black;           // 父节点、伯父节点改为黑
-                    y->parent->color = red;     // 祖父节点改为红
-                    x = y->parent;  // x指向祖父节点，继续向上判断
+            if (x->parent() == x->parent()->parent()->left) {
+                rb_tree_node_base* y = x->parent()->parent()->right;    // y为x的伯父节点
+                if (y && y->color() == red) {    // 伯父节点存在且为红
+                    x->parent()->set_color(black);
+                    y->set_color(black);           // 父节点、伯父节点改为黑
+                    y->parent()->set_color(red);     // 祖父节点改为红
+                    x = y->parent();  // x指向祖父节点，继续向上判断
                 } else {    // 无伯父节点，或伯父节点为黑
-                    if (x == x->parent->right) {    // x为父节点的右孩子，即内侧插入
-                        x = x->parent;
-                        rb_tree_rotate_left(x, root);   // 左旋转
+                    if (x == x->parent()->right) {    // x为父节点的右孩子，即内侧插入
+                        x = x->parent();
+                        rb_tree_rotate_left(x, header, update);   // 左旋转
                     }
-                    x->parent->color = black;
-                    x->parent->parent->color = red;
-                    rb_tree_rotate_right(x->parent->parent, root);  // 右旋转
+                    x->parent()->set_color(black);
+                    x->parent()->parent()->set_color(red);
+                    rb_tree_rotate_right(x->parent()->parent(), header, update);  // 右旋转
                 }
             } else {    // 与if部分完全对称
-                rb_tree_node_base* y = x->parent->parent->left;
-                if (y && y->color == red) {
-                    x->parent->color = black;
-                    y->color = black;      
-                    y->parent->color = red; 
-                    x = y->parent; 
+                rb_tree_node_base* y = x->parent()->parent()->left;
+                if (y && y->color() == red) {
+                    x->parent()->set_color(black);
+                    y->set_color(black);      
+                    y->parent()->set_color(red); 
+                    x = y->parent(); 
                 } else {   
-                    if (x == x->parent->left) {
-                        x = x->parent;
-                        rb_tree_rotate_right(x, root);
+                    if (x == x->parent()->left) {
+                        x = x->parent();
+                        rb_tree_rotate_right(x, header, update);
                     }
-                    x->parent->color = black;
-                    x->parent->parent->color = red;
-                    rb_tree_rotate_left(x->parent->parent, root);
+                    x->parent()->set_color(black);
+                    x->parent()->parent()->set_color(red);
+                    rb_tree_rotate_left(x->parent()->parent(), header, update);
                 }
 
             }
         } // while 
-        root->color = black;    // 根节点永远为黑
+        header.parent()->set_color(black);  // 根节点永远为黑
     }
 
     // 重新平衡rb_tree，以准备移除z指向的节点
+    template <class Update = rb_tree_no_update>
     rb_tree_node_base* 
     rb_tree_rebalance_for_erase(rb_tree_node_base* const z,
-                                rb_tree_node_base& header) noexcept
+                                rb_tree_node_base& header, Update update = Update())
     {
         rb_tree_node_base* y = z;
         rb_tree_node_base* x = nullptr;
         rb_tree_node_base* x_parent = nullptr;
-        rb_tree_node_base*& root = header.parent;
         rb_tree_node_base*& leftmost = header.left;
         rb_tree_node_base*& rightmost = header.right;
         if (y->left == nullptr) // z最多有一个孩子
@@ -360,122 +410,130 @@ namespace STL
         }
         // 将z指向的节点与rb_tree分离，未删除
         if (y != z) {               // y是z的后继，让y取代z，x取代y
-            z->left->parent = y;
+            z->left->set_parent(y);
             y->left = z->left;
             if (y != z->right) {    // y不是z的右孩子
-                x_parent = y->parent;
-                if (x)  x->parent = y->parent;
-                y->parent->left = x;
+                x_parent = y->parent();
+                if (x)  x->set_parent(y->parent());
+                y->parent()->left = x;
                 y->right = z->right;
-                z->right->parent = y;
+                z->right->set_parent(y);
             } else {
                 x_parent = y;
             }
             // 将y与z->parent接上
-            if (root == z)  root = y;
-            else if (z->parent->left == z)
-                z->parent->left = y;
+            if (header.parent() == z)  header.set_parent(y);
+            else if (z->parent()->left == z)
+                z->parent()->left = y;
             else 
-                z->parent->right = y;
-            y->parent = z->parent;
-            STL::swap(y->color, z->color);
+                z->parent()->right = y;
+            y->set_parent(z->parent());
+            const rb_tree_color c = y->color();
+            y->set_color(z->color());
+            z->set_color(c);
             y = z;  // y重新指向待删节点z
         } else {                    // y指向z，z只有一个孩子x，让x取代z
             // 将x与z->parent接上
-            x_parent = y->parent;
-            if (x)  x->parent = y->parent;
-            if (root == z)  root = x;
-            else if (z->parent->left == z)
-                z->parent->left = x;
+            x_parent = y->parent();
+            if (x)  x->set_parent(y->parent());
+            if (header.parent() == z)  header.set_parent(x);
+            else if (z->parent()->left == z)
+                z->parent()->left = x;
             else 
-                z->parent->right = x;
+                z->parent()->right = x;
             if (leftmost == z) {    // 删除的z是最小元素
                 if (z->right == nullptr)
-                    leftmost = z->parent;
+                    leftmost = z->parent();
                 else                // z->right == x
                     leftmost = rb_tree_node_base::minimum(x);
             }
             if (rightmost == z) {   // 删除的z是最大元素
                 if (z->left == nullptr)
-                    rightmost = z->parent;
+                    rightmost = z->parent();
                 else                // z->left == x
                     rightmost = rb_tree_node_base::maximum(x);
             }
         }
         // 此时y指向待删除节点z，该节点已与rb_tree分离
+        // 子树改变的节点都在x_parent至根节点的路径上（z的后继取代z时，后继也在此路径上）
+        rb_tree_update_path(x_parent, header, update);
         // 开始调整rb_tree的颜色，依据删除的颜色(而不是节点)y->color 
         // 删除的颜色为开始x->parent(不是x_parent)的颜色 
         // 上面if (y != z)的情况下，虽然y指向z，但y->color依然是x->parent节点的颜色
         // 若y->color == red，则直接删除即可
-        if (y->color == black) {    // 删除的颜色是黑色
+        if (y->color() == black) {    // 删除的颜色是黑色
             // case 1:
             // 若x为新的根节点，则删除节点为原根节点 或者 若x为红色
             // 最后将x变黑即可
-            while (x != root && (x == nullptr || x->color == black)) {  // x不为根节点且为黑
+            while (x != header.parent() && (x == nullptr || x->color() == black)) {  // x不为根节点且为黑
                 if (x == x_parent->left) {                  // x为左孩子
                     rb_tree_node_base* w = x_parent->right; // w为x的兄弟
                     // x和w都可能为nullptr
-                    if (w->color == red) {                  // case 2: x兄弟为红，则将其变为case 3
-                        w->color = black;
-                        x_parent->color = red;
-                        rb_tree_rotate_left(x_parent, root);
+                    if (w->color() == red) {                  // case 2: x兄弟为红，则将其变为case 3
+                        w->set_color(black);
+                        x_parent->set_color(red);
+                        rb_tree_rotate_left(x_parent, header, update);
                         w = x_parent->right;
                     }
                     // case 3: x兄弟为黑
-                    if ((w->left == nullptr || w->left->color == black)
-                    && (w->right == nullptr || w->right->color == black)) {     // case 3.1: w的两孩子都黑
-                        w->color = red;
+                    if ((w->left == nullptr || w->left->color() == black)
+                    && (w->right == nullptr || w->right->color() == black)) {     // case 3.1: w的两孩子都黑
+                        w->set_color(red);
                         x = x_parent;
-                        x_parent = x_parent -> parent;
+                        x_parent = x_parent->parent();
                     } else {
                         // case 3.2: w的孩子有红色
-                        if (w->right == nullptr || w->right->color == black) {  // case 3.2.1: w的左孩子红，右孩子黑，则将其变为case 3.2.2
-                            if (w->left)    w->left->color = black;
-                            w->color = red;
-                            rb_tree_rotate_right(w, root);
+                        if (w->right == nullptr || w->right->color() == black) {  // case 3.2.1: w的左孩子红，右孩子黑，则将其变为case 3.2.2
+                            if (w->left)    w->left->set_color(black);
+                            w->set_color(red);
+                            rb_tree_rotate_right(w, header, update);
                             w = x_parent->right;
                         }
                         // case 3.2.2: w的左孩子可黑可红，右孩子红
-                        w->color = x_parent->color;
-                        x_parent->color = black;
-                        if (w->right)   w->right->color = black;
-                        rb_tree_rotate_left(x_parent, root);
+                        w->set_color(x_parent->color());
+                        x_parent->set_color(black);
+                        if (w->right)   w->right->set_color(black);
+                        rb_tree_rotate_left(x_parent, header, update);
                         break;
                     }
                 } else {    // x == x_parent->right，和上面对称
                     rb_tree_node_base* w = x_parent->left;
-                    if (w->color == red) {                
-                        w->color = black;
-                        x_parent->color = red;
-                        rb_tree_rotate_right(x_parent, root);
+                    if (w->color() == red) {                
+                        w->set_color(black);
+                        x_parent->set_color(red);
+                        rb_tree_rotate_right(x_parent, header, update);
                         w = x_parent->left;
                     }
-                    if ((w->left == nullptr || w->left->color == black)
-                    && (w->right == nullptr || w->right->color == black)) {
-                        w->color = red;
+                    if ((w->left == nullptr || w->left->color() == black)
+                    && (w->right == nullptr || w->right->color() == black)) {
+                        w->set_color(red);
                         x = x_parent;
-                        x_parent = x_parent -> parent;
+                        x_parent = x_parent->parent();
                     } else {
-                        if (w->left == nullptr || w->left->color == black) {
-                            if (w->right)    w->right->color = black;
-                            w->color = red;
-                            rb_tree_rotate_left(w, root);
+                        if (w->left == nullptr || w->left->color() == black) {
+                            if (w->right)    w->right->set_color(black);
+                            w->set_color(red);
+                            rb_tree_rotate_left(w, header, update);
                             w = x_parent->left;
                         }
-                        w->color = x_parent->color;
-                        x_parent->color = black;
-                        if (w->left)   w->left->color = black;
-                        rb_tree_rotate_right(x_parent, root);
+                        w->set_color(x_parent->color());
+                        x_parent->set_color(black);
+                        if (w->left)   w->left->set_color(black);
+                        rb_tree_rotate_right(x_parent, header, update);
                         break;
                     }
                 }
             }
             // case 1
-            if (x)  x->color = black;
+            if (x)  x->set_color(black);
         }
         return y;
     }
 
+    // 标记输入范围已按键值升序排列，rb_tree可据此在线性时间内建树
+    struct sorted_range_t { };
+    constexpr sorted_range_t sorted_range = sorted_range_t();
+
     // 计算从node到root路径中的黑色节点数量
     inline int count_black(const rb_tree_node_base* node, const rb_tree_node_base* root)
     {
@@ -485,18 +543,130 @@ namespace STL
             if (node == root)
                 return 1;
             else {
-                int c = node->color == black ? 1 : 0;
-                return c + count_black(node->parent, root);
+                int c = node->color() == black ? 1 : 0;
+                return c + count_black(node->parent(), root);
             }
         }
     }
 
+    /**
+     *  节点附加数据（augmentation）策略
+     *
+     *  策略提供附加数据类型meta_type，以及函数调用
+     *      void operator()(meta_type& m, const Val& v, const meta_type* l, const meta_type* r) const
+     *  以节点值v及左右孩子的附加数据l、r（孩子不存在时为nullptr）重新计算节点的附加数据m
+     *  附加数据只能由以该节点为根的子树决定，rb_tree在插入、删除、旋转时自动维护
+     *  meta_type须为平凡可复制的类型
+     */
+
+    // 缺省策略：节点不附加数据，节点大小不变
+    struct rb_tree_no_augment { };
+
+    // 子树节点数，用于顺序统计：rank、select与O(log n)的distance
+    struct rb_tree_count_augment
+    {
+        using meta_type = size_t;
+
+        template <class Val>
+        void operator()(meta_type& m, const Val&, const meta_type* l, const meta_type* r) const noexcept
+        { m = 1 + (l ? *l : 0) + (r ? *r : 0); }
+    };
+
+    /**
+     *  由幺半群构造的附加数据策略，支持aggregate区间汇总查询
+     *
+     *  Monoid须提供meta_type，以及
+     *      meta_type identity() const                                      单位元
+     *      meta_type value(const Val& v) const                             单个元素的汇总值
+     *      meta_type combine(const meta_type& a, const meta_type& b) const 满足结合律，a中的元素在b之前
+     *  节点的附加数据为其子树中所有元素按顺序依次combine的结果
+     */
+    template <class Monoid>
+    struct rb_tree_monoid_augment : public Monoid
+    {
+        using meta_type = typename Monoid::meta_type;
+
+        template <class Val>
+        void operator()(meta_type& m, const Val& v, const meta_type* l, const meta_type* r) const
+        {
+            m = this->value(v);
+            if (l)  m = this->combine(*l, m);
+            if (r)  m = this->combine(m, *r);
+        }
+    };
+
+    // 求和的幺半群，ValueOf取出元素中参与求和的部分
+    template <class T, class ValueOf>
+    struct rb_tree_sum_monoid
+    {
+        using meta_type = T;
+
+        T identity() const { return T(); }
+
+        template <class Val>
+        T value(const Val& v) const { return ValueOf()(v); }
+
+        T combine(const T& a, const T& b) const { return a + b; }
+    };
+
+    template <class T, class ValueOf>
+    using rb_tree_sum_augment = rb_tree_monoid_augment<rb_tree_sum_monoid<T, ValueOf>>;
+
+    /**
+     *  区间树策略：元素表示闭区间[low, high]，以low为键值排序，附加数据为子树中high的最大值
+     *
+     *  @tparam  T            端点类型，与键值类型相同
+     *  @tparam  HighOfValue  取出元素的右端点
+     *  @tparam  Compare      端点的比较函数，须与rb_tree的Compare一致
+     *
+     *  支持find_overlap与for_each_overlap查询与给定区间相交的元素
+     */
+    template <class T, class HighOfValue, class Compare = std::less<T>>
+    struct rb_tree_interval_augment
+    {
+        using meta_type = T;
+
+        template <class Val>
+        const T& high(const Val& v) const { return HighOfValue()(v); }
+
+        template <class Val>
+        void operator()(T& m, const Val& v, const T* l, const T* r) const
+        {
+            m = high(v);
+            if (l && Compare()(m, *l))  m = *l;
+            if (r && Compare()(m, *r))  m = *r;
+        }
+    };
+
+    template <class Val, class Augment>
+    struct rb_tree_augmented_node : public rb_tree_node<Val>
+    {
+        using meta_type = typename Augment::meta_type;
+
+        static_assert(std::is_trivially_copyable<meta_type>::value, "augmented meta data must be trivially copyable");
+
+        meta_type meta;     // 子树的附加数据
+    };
+
+    // 由策略决定实际分配的节点类型
+    template <class Val, class Augment>
+    struct rb_tree_node_type { using type = rb_tree_augmented_node<Val, Augment>; };
+
+    template <class Val>
+    struct rb_tree_node_type<Val, rb_tree_no_augment> { using type = rb_tree_node<Val>; };
+
+    /**
+     *  红黑树
+     *
+     *  @tparam  Augment  节点附加数据策略，缺省不附加数据
+     */
     template <class Key, class Val, class KeyOfValue, class Compare,
-              class Alloc = STL::pool_alloc>
+              class Alloc = STL::pool_alloc, class Augment = rb_tree_no_augment>
     class rb_tree
     {
     protected:
-        using rb_tree_node_allocator    = STL::allocator<rb_tree_node<Val>, Alloc>;
+        using Node                      = typename rb_tree_node_type<Val, Augment>::type;
+        using rb_tree_node_allocator    = STL::allocator<Node, Alloc>;
         using Base_ptr                  = rb_tree_node_base*;
         using Const_Base_ptr            = const rb_tree_node_base*;
         using Link_type                 = rb_tree_node<Val>*;
@@ -514,17 +684,16 @@ namespace STL
 
     protected:
         Link_type get_node() { return rb_tree_node_allocator::allocate(); }
-        void put_node(Link_type p) { rb_tree_node_allocator::deallocate(p); }
+        void put_node(Link_type p) { rb_tree_node_allocator::deallocate(static_cast<Node*>(p)); }
         
-        // 构造节点
+        // 构造节点，只在原地构造节点值，指针与颜色由插入时设置
+        // 不对整个节点做placement new，以免先默认构造一次value_field
         template <class... Args>
         void construct_node(Link_type node, Args&&... args)
         {
             try {
-                ::new(node) rb_tree_node<value_type>;
                 STL::construct(node->valptr(), std::forward<Args>(args)...);
             } catch(...) {
-                node->~rb_tree_node<value_type>();
                 put_node(node);
                 throw;
             }
@@ -543,7 +712,6 @@ namespace STL
         void destroy_node(Link_type p) noexcept
         {
             STL::destroy(p->valptr());
-            p->~rb_tree_node<value_type>();
         }
 
         // 删除节点 = 析构节点 + 释放内存
@@ -553,15 +721,43 @@ namespace STL
             put_node(p);
         }
 
-        // 克隆节点（值和颜色）
-        Link_type clone_node(Const_Link_type x)
+        // 以pool链表的首块空间克隆节点（值、颜色和附加数据），成功后pool前进一块，失败时pool不变
+        Link_type clone_node(Const_Link_type x, Link_type& pool)
         {
-            Link_type tmp = create_node(*x->valptr());
-            tmp->color = x->color;
+            Link_type tmp = pool;
+            Link_type next = static_cast<Link_type>(rb_tree_node_allocator::chain_next(static_cast<Node*>(tmp)));
+            STL::construct(tmp->valptr(), *x->valptr());
+            pool = next;
+            tmp->set_color(x->color());
             tmp->left = tmp->right = nullptr;
+            copy_meta(tmp, x, is_augmented());
             return tmp;
         }
 
+    protected:
+        // 节点附加数据
+        using is_augmented = STL::integral_constant<bool, !std::is_same<Augment, rb_tree_no_augment>::value>;
+
+        // 以节点值与孩子的附加数据重新计算x的附加数据
+        struct node_update
+        {
+            void operator()(rb_tree_node_base* x) const
+            {
+                Node* n = static_cast<Node*>(x);
+                Augment()(n->meta, *n->valptr(),
+                          x->left ? &static_cast<Node*>(x->left)->meta : nullptr,
+                          x->right ? &static_cast<Node*>(x->right)->meta : nullptr);
+            }
+        };
+
+        // 传给旋转、平衡函数的更新函数，无附加数据时什么都不做
+        using updater = typename std::conditional<is_augmented::value, node_update, rb_tree_no_update>::type;
+
+        static void copy_meta(Link_type x, Const_Link_type y, STL::true_type)
+        { static_cast<Node*>(x)->meta = static_cast<const Node*>(y)->meta; }
+
+        static void copy_meta(Link_type, Const_Link_type, STL::false_type) { }
+
     protected:
         Compare             key_compare;    // 节点间的键值大小的比较函数对象
         rb_tree_node_base   header;
@@ -569,7 +765,7 @@ namespace STL
 
         void reset()
         {
-            header.parent = nullptr;
+            header.set_parent(nullptr);
             header.left = &header;
             header.right = &header;
             node_count = 0;
@@ -578,21 +774,21 @@ namespace STL
     private:
         void initialize()
         {
-            header.color = red;     // 令header为红色，以区分header和root
-            header.parent = nullptr;
+            header.set_color(red);  // 令header为红色，以区分header和root
+            header.set_parent(nullptr);
             header.left = header.right = &header;  // header的左/右子节点指向自己
         }
     
     protected:
         // 取得header的成员
-        Base_ptr& root() { return header.parent; }
-        Const_Base_ptr root() const { return header.parent; }
+        Base_ptr root() const { return header.parent(); }
+        void set_root(Base_ptr x) { header.set_parent(x); }
         Base_ptr& leftmost() { return header.left; }
         Const_Base_ptr leftmost() const { return header.left; }
         Base_ptr& rightmost() { return header.right; }
         Const_Base_ptr rightmost() const { return header.right; }
-        Link_type M_begin() { return static_cast<Link_type>(header.parent); }
-        Const_Link_type M_begin() const { return static_cast<Const_Link_type>(header.parent); }
+        Link_type M_begin() { return static_cast<Link_type>(header.parent()); }
+        Const_Link_type M_begin() const { return static_cast<Const_Link_type>(header.parent()); }
         Link_type M_end() { return static_cast<Link_type>(&header); }
         Const_Link_type M_end() const { return static_cast<Const_Link_type>(&header); }
 
@@ -605,8 +801,8 @@ namespace STL
         static Const_Link_type left(Const_Base_ptr x) { return static_cast<Const_Link_type>(x->left); }
         static Link_type right(Base_ptr x) { return static_cast<Link_type>(x->right); }
         static Const_Link_type right(Const_Base_ptr x) { return static_cast<Const_Link_type>(x->right); }
-        static Link_type parent(Base_ptr x) { return static_cast<Link_type>(x->parent); }
-        static Const_Link_type parent(Const_Base_ptr x) { return static_cast<Const_Link_type>(x->parent); }
+        static Link_type parent(Base_ptr x) { return static_cast<Link_type>(x->parent()); }
+        static Const_Link_type parent(Const_Base_ptr x) { return static_cast<Const_Link_type>(x->parent()); }
     
         // 求最小值、最大值
         static Base_ptr minimum(Base_ptr x) { return rb_tree_node_base::minimum(x); }
@@ -617,55 +813,203 @@ namespace STL
     public:
         using iterator          = rb_tree_iterator<value_type>;
         using const_iterator    = rb_tree_const_iterator<value_type>;
+        using node_type         = node_handle<value_type, Node, Alloc>;
+        using insert_return_type = node_insert_return<iterator, node_type>;
+
+    private:
+        // 比较函数声明了is_transparent时，查找接口接受任意类型K，避免构造临时key_type
+        template <class K>
+        using transparent_key = typename std::enable_if<STL::is_transparent<Compare>::value, K>::type;
+
+        // erase的异构版本还须排除能转换为迭代器的K，以免与erase(const_iterator)冲突
+        template <class K>
+        using transparent_erase_key = typename std::enable_if<!std::is_convertible<K, iterator>::value &&
+                                                              !std::is_convertible<K, const_iterator>::value,
+                                                              transparent_key<K>>::type;
     
     protected:
-        // 将x指向的rb_tree拷贝到p所指节点的孩子节点
-        Link_type M_copy(Const_Link_type x, Link_type p)
+        // 红黑树的高度不超过2 log2(n + 1)，以此为非递归遍历所用栈的容量
+        enum { max_height = 2 * 8 * sizeof(size_type) };
+
+        // 复制x的所有节点，返回新树的根，新根的parent为header
+        // 先一次从分配器取得x.size()个节点，再按先序遍历x逐个克隆，右孩子待复制的节点记在栈上，不递归
+        // 复制失败时删除已克隆的节点，未用的节点整批交还分配器
+        Link_type M_copy(const rb_tree& x)
+        {
+            size_type n = x.node_count;
+            Link_type pool = rb_tree_node_allocator::allocate_chain(n);
+            Link_type top = nullptr;
+            try {
+                Const_Link_type src[max_height];    // 右子树尚未复制的节点及其克隆
+                Link_type dst[max_height];
+                int depth = 0;
+                Const_Link_type s = x.M_begin();
+                Link_type d = top = clone_node(s, pool);
+                --n;
+                top->set_parent(M_end());
+                for (;;) {
+                    if (s->right) {
+                        src[depth] = s;
+                        dst[depth++] = d;
+                    }
+                    Link_type y;
+                    if (s->left) {
+                        s = left(s);
+                        y = clone_node(s, pool);
+                        d->left = y;
+                    } else if (depth) {
+                        s = right(src[--depth]);
+                        y = clone_node(s, pool);
+                        d = dst[depth];
+                        d->right = y;
+                    } else {
+                        return top;
+                    }
+                    --n;
+                    y->set_parent(d);
+                    d = y;
+                }
+            } catch(...) {
+                if (top)
+                    erase_tree(top);
+                if (n) {
+                    Link_type last = pool;
+                    for (size_type i = 1; i < n; ++i)
+                        last = static_cast<Link_type>(rb_tree_node_allocator::chain_next(static_cast<Node*>(last)));
+                    rb_tree_node_allocator::deallocate_chain(static_cast<Node*>(pool), static_cast<Node*>(last), n);
+                }
+                throw;
+            }
+        }
+
+        // 以list起、由right串起的n个有序节点建立平衡树，返回子树的根，list前进n个节点
+        // 左右子树的节点数至多相差1，所有叶节点的深度至多相差1：
+        // 不满的最底层（深度为red_depth）染红，其余染黑，各路径的黑色节点数相同
+        Link_type M_build_tree(Link_type& list, size_type n, size_type depth, size_type red_depth)
+        {
+            if (n == 0)
+                return nullptr;
+            Link_type l = M_build_tree(list, (n - 1) / 2, depth + 1, red_depth);
+            Link_type x = list;
+            list = right(x);
+            x->left = l;
+            if (l)  l->set_parent(x);
+            x->right = M_build_tree(list, n - 1 - (n - 1) / 2, depth + 1, red_depth);
+            if (x->right)   x->right->set_parent(x);
+            x->set_color(depth == red_depth ? red : black);
+            updater()(x);
+            return x;
+        }
+
+        // 空树时，以head起、由right串起的n个有序节点建树，tail为最后一个节点
+        void M_attach_list(Link_type head, Link_type tail, size_type n)
+        {
+            if (n == 0)
+                return;
+            size_type red_depth = 1;    // 满二叉树的层数，其下一层不满
+            while ((size_type(2) << red_depth) - 1 <= n)
+                ++red_depth;
+            Link_type list = head;
+            set_root(M_build_tree(list, n, 0, red_depth));
+            root()->set_parent(M_end());
+            leftmost() = head;
+            rightmost() = tail;
+            node_count = n;
+        }
+
+        // 空树时，以[first, last)中有序的最长前缀建树，返回尚未插入部分的起点
+        // unique为true时相邻的重复键值只保留第一个
+        template <class InputIterator>
+        InputIterator M_build_sorted(InputIterator first, InputIterator last, bool unique)
         {
-            Link_type top = clone_node(x);
-            top->parent = p;
+            Link_type head = nullptr;   // 已构造的节点，以right串成有序链表
+            Link_type tail = nullptr;
+            Link_type z = nullptr;      // 破坏有序性的节点，建树后再逐个插入
+            size_type n = 0;
             try {
-                if (x->right)
-                    top->right = M_copy(right(x), top);
-                p = top;
-                x = left(x);
-                while (x) {
-                    Link_type y = clone_node(x);
-                    p->left = y;
-                    y->parent = p;
-                    if (x->right)
-                        y->right = M_copy(right(x), y);
-                    p = y;
-                    x = left(x);
+                for ( ; first != last; ++first) {
+                    Link_type y = create_node(*first);
+                    y->right = nullptr;
+                    if (tail) {
+                        if (key_compare(key(y), key(tail))) {
+                            z = y;
+                            ++first;
+                            break;
+                        }
+                        if (unique && !key_compare(key(tail), key(y))) {
+                            drop_node(y);
+                            continue;
+                        }
+                        tail->right = y;
+                    } else {
+                        head = y;
+                    }
+                    tail = y;
+                    ++n;
                 }
             } catch(...) {
-                erase_tree(top);
+                while (head) {
+                    Link_type y = right(head);
+                    drop_node(head);
+                    head = y;
+                }
+                throw;
             }
-            return top;
+            M_attach_list(head, tail, n);
+            if (z) {
+                if (unique)
+                    insert_unique_node(z);
+                else
+                    insert_equal_node(z);
+            }
+            return first;
         }
 
         void move_data(rb_tree& x)
         {
-            root() = x.root();
+            set_root(x.root());
             leftmost() = x.leftmost();
             rightmost() = x.rightmost();
-            root()->parent = M_end();
+            root()->set_parent(M_end());
             node_count = x.node_count;
             // 重置x
             x.reset();
         }
 
-        // 清除x所指的rb_tree
-        void erase_tree(Link_type x)
+        // 删除x子树的所有节点，返回节点数
+        // 按先序遍历，右孩子记在栈上，不递归；每个节点先取出孩子再删除，只访问一次
+        // 节点析构后以块首按访问顺序串成链表，最后整批交还分配器；节点值可平凡析构时不调用析构函数
+        size_type erase_tree(Link_type x) noexcept
         {
+            Link_type pending[max_height];
+            int depth = 0;
+            Node* head = nullptr;
+            Node* tail = nullptr;
+            size_type n = 0;
             while (x) {
-                erase_tree(right(x));
-                Link_type y = left(x);
-                destroy_node(x);
-                x = y;
+                Link_type l = left(x);
+                Link_type r = right(x);
+                M_destroy_value(x, std::is_trivially_destructible<value_type>());
+                Node* p = static_cast<Node*>(x);
+                rb_tree_node_allocator::chain_next(p) = nullptr;
+                if (tail)   rb_tree_node_allocator::chain_next(tail) = p;
+                else        head = p;
+                tail = p;
+                ++n;
+                if (r)
+                    pending[depth++] = r;
+                if (l)
+                    x = l;
+                else
+                    x = depth ? pending[--depth] : nullptr;
             }
+            rb_tree_node_allocator::deallocate_chain(head, tail, n);
+            return n;
         }
 
+        void M_destroy_value(Link_type p, std::true_type) noexcept { (void)p; }
+        void M_destroy_value(Link_type p, std::false_type) noexcept { destroy_node(p); }
+
     public:
         // The big five
         
@@ -682,8 +1026,8 @@ namespace STL
         : key_compare(x.key_compare), header(), node_count(x.node_count)
         {
             if (x.root()) {
-                header.color = red;
-                root() = M_copy(x.M_begin(), M_end());
+                header.set_color(red);
+                set_root(M_copy(x));
                 leftmost() = minimum(root());
                 rightmost() = maximum(root());
             } else 
@@ -710,9 +1054,10 @@ namespace STL
                 clear();
                 key_compare = x.key_compare;
                 if (x.root()) {
-                    root() = M_copy(x.M_begin(), M_end());
+                    set_root(M_copy(x));
                     leftmost() = minimum(root());
                     rightmost() = maximum(root());
+                    node_count = x.node_count;
                 } else 
                     initialize();
             }
@@ -741,39 +1086,234 @@ namespace STL
     protected:
         // x - 新值插入点，初始为叶节点的孩子(nullptr)
         // y - x的父节点
-        // v - 新值
-        iterator M_insert(Base_ptr _x, Base_ptr _y, const value_type& v)
+        // z - 已构造好的新节点
+        iterator M_insert_node(Base_ptr _x, Base_ptr _y, Link_type z)
         {
             Link_type x = static_cast<Link_type>(_x);
             Link_type y = static_cast<Link_type>(_y);
-            Link_type z;
 
-            if (y == M_end() || x || key_compare(KeyOfValue()(v), key(y))) {
-                z = create_node(v);     // 创建值为v的节点z
+            if (y == M_end() || x || key_compare(key(z), key(y))) {
                 y->left = z;
                 if (y == M_end()) {      // 此时不用leftmost() = z，因为上一行有相同的作用
-                    root() = z;
+                    set_root(z);
                     rightmost() = z;
                 } else if (y == leftmost())
                     leftmost() = z;
             } else {
-                z = create_node(v);
                 y->right = z;
                 if (y == rightmost())
                     rightmost() = z;
             }
             // 设置新节点的父节点，左右孩子 
-            z->parent = y;
+            z->set_parent(y);
             z->left = z->right = nullptr;
-            rb_tree_rebalance(z, header.parent);
+            rb_tree_rebalance(z, header, updater());
             ++node_count;
             return iterator(z);
         }
 
+        // x - 新值插入点，初始为叶节点的孩子(nullptr)
+        // y - x的父节点
+        // v - 新值
+        iterator M_insert(Base_ptr x, Base_ptr y, const value_type& v)
+        { return M_insert_node(x, y, create_node(v)); }
+
+        // 为键值k寻找插入点，键值不允许重复
+        // 若可插入，返回(x, y)，含义同M_insert；若键值已存在，返回(重复节点, nullptr)
+        pair<Base_ptr, Base_ptr> M_get_insert_unique_pos(const key_type& k)
+        {
+            Link_type x = M_begin();
+            Link_type y = M_end();
+            bool cmp = true;
+            while (x) {     // x从根节点开始，往下寻找适当的插入点
+                y = x;
+                // k 小于 x 往左，k 大于等于 x 往右
+                cmp = key_compare(k, key(x));
+                x = cmp ? left(x) : right(x);
+            }
+            // x为插入点nullptr，y是x的父节点（叶节点）
+            iterator j = iterator(y);   // 迭代器j指向y
+            if (cmp) {   // 表示x插入y左孩子
+                if (j == begin())   // y为最左节点
+                    return pair<Base_ptr, Base_ptr>(x, y);
+                else    // j指向自己的前驱
+                    --j;
+            }
+            if (key_compare(key(j.node), k))  // j指向的节点键值 小于 新增键值k
+                return pair<Base_ptr, Base_ptr>(x, y);
+
+            // 键值重复
+            return pair<Base_ptr, Base_ptr>(j.node, nullptr);
+        }
+
+        // 为键值k寻找插入点，键值允许重复
+        pair<Base_ptr, Base_ptr> M_get_insert_equal_pos(const key_type& k)
+        {
+            Link_type x = M_begin();
+            Link_type y = M_end();
+            while (x) {     // x从根节点开始，往下寻找适当的插入点
+                y = x;
+                // k 小于 x 往左，k 大于等于 x 往右
+                x = key_compare(k, key(x)) ? left(x) : right(x);
+            }
+            return pair<Base_ptr, Base_ptr>(x, y);
+        }
+
+        // 以position为提示为键值k寻找插入点，键值不允许重复，返回值含义同M_get_insert_unique_pos
+        // k恰好应插在position之前（或position为end()且k大于所有键值）时只需比较一两次，
+        // 否则退化为从根节点查找
+        pair<Base_ptr, Base_ptr> M_get_insert_hint_unique_pos(const_iterator position, const key_type& k)
+        {
+            using Res = pair<Base_ptr, Base_ptr>;
+            iterator pos = position.M_const_cast();
+            if (pos.node == M_end()) {
+                if (size() > 0 && key_compare(key(rightmost()), k))
+                    return Res(nullptr, rightmost());
+                return M_get_insert_unique_pos(k);
+            }
+            if (key_compare(k, key(pos.node))) {        // k在pos之前
+                if (pos.node == leftmost())
+                    return Res(leftmost(), leftmost());
+                iterator before = pos;
+                --before;
+                if (key_compare(key(before.node), k)) { // k在before与pos之间
+                    // before无右孩子则作为其右孩子，否则pos必无左孩子，作为pos的左孩子
+                    if (before.node->right == nullptr)
+                        return Res(nullptr, before.node);
+                    return Res(pos.node, pos.node);
+                }
+                return M_get_insert_unique_pos(k);
+            }
+            if (key_compare(key(pos.node), k)) {        // k在pos之后
+                if (pos.node == rightmost())
+                    return Res(nullptr, rightmost());
+                iterator after = pos;
+                ++after;
+                if (key_compare(k, key(after.node))) {  // k在pos与after之间
+                    if (pos.node->right == nullptr)
+                        return Res(nullptr, pos.node);
+                    return Res(after.node, after.node);
+                }
+                return M_get_insert_unique_pos(k);
+            }
+            // 键值重复
+            return Res(pos.node, nullptr);
+        }
+
+        // 以position为提示为键值k寻找插入点，键值允许重复
+        pair<Base_ptr, Base_ptr> M_get_insert_hint_equal_pos(const_iterator position, const key_type& k)
+        {
+            using Res = pair<Base_ptr, Base_ptr>;
+            iterator pos = position.M_const_cast();
+            if (pos.node == M_end()) {
+                if (size() > 0 && !key_compare(k, key(rightmost())))
+                    return Res(nullptr, rightmost());
+                return M_get_insert_equal_pos(k);
+            }
+            if (!key_compare(key(pos.node), k)) {       // k不大于pos
+                if (pos.node == leftmost())
+                    return Res(leftmost(), leftmost());
+                iterator before = pos;
+                --before;
+                if (!key_compare(k, key(before.node))) {
+                    if (before.node->right == nullptr)
+                        return Res(nullptr, before.node);
+                    return Res(pos.node, pos.node);
+                }
+                return M_get_insert_equal_pos(k);
+            }
+            // k大于pos
+            if (pos.node == rightmost())
+                return Res(nullptr, rightmost());
+            iterator after = pos;
+            ++after;
+            if (!key_compare(key(after.node), k)) {
+                if (pos.node->right == nullptr)
+                    return Res(nullptr, pos.node);
+                return Res(after.node, after.node);
+            }
+            return M_get_insert_equal_pos(k);
+        }
+
+        // 以position为提示，仅当k不存在时才以args构造新节点
+        template <class... Args>
+        iterator emplace_hint_unique_key(const_iterator position, const key_type& k, Args&&... args)
+        {
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_hint_unique_pos(position, k);
+            if (pos.second)
+                return M_insert_node(pos.first, pos.second, create_node(std::forward<Args>(args)...));
+            return iterator(pos.first);
+        }
+
+        template <class Arg, class... Args>
+        iterator emplace_hint_unique_aux(STL::true_type, const_iterator position, Arg&& arg, Args&&... args)
+        {
+            using is_key = STL::integral_constant<bool, !STL::emplace_is_value<value_type, Arg, Args...>::value>;
+            return emplace_hint_unique_key(position, emplace_key(arg, is_key()),
+                                           std::forward<Arg>(arg), std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        iterator emplace_hint_unique_aux(STL::false_type, const_iterator position, Args&&... args)
+        {
+            Link_type z = create_node(std::forward<Args>(args)...);
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_hint_unique_pos(position, key(z));
+            if (pos.second)
+                return M_insert_node(pos.first, pos.second, z);
+            drop_node(z);
+            return iterator(pos.first);
+        }
+
+        // 先以键值k查找插入点，仅当k不存在时才以args构造新节点
+        template <class... Args>
+        pair<iterator, bool> emplace_unique_key(const key_type& k, Args&&... args)
+        {
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_unique_pos(k);
+            if (pos.second)
+                return pair<iterator, bool>(M_insert_node(pos.first, pos.second,
+                                                          create_node(std::forward<Args>(args)...)), true);
+            return pair<iterator, bool>(iterator(pos.first), false);
+        }
+
+        // 插入已构造好的节点z，键值不允许重复，若重复则删除z
+        pair<iterator, bool> insert_unique_node(Link_type z)
+        {
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_unique_pos(key(z));
+            if (pos.second)
+                return pair<iterator, bool>(M_insert_node(pos.first, pos.second, z), true);
+            drop_node(z);
+            return pair<iterator, bool>(iterator(pos.first), false);
+        }
+
+        // 插入已构造好的节点z，键值允许重复
+        iterator insert_equal_node(Link_type z)
+        {
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_equal_pos(key(z));
+            return M_insert_node(pos.first, pos.second, z);
+        }
+
+        // 从emplace的首个实参中取得键值
+        static const key_type& emplace_key(const key_type& k, STL::true_type) { return k; }
+        static const key_type& emplace_key(const value_type& v, STL::false_type) { return KeyOfValue()(v); }
+
+        // 实参能直接给出键值，先查找再构造节点
+        template <class Arg, class... Args>
+        pair<iterator, bool> emplace_unique_aux(STL::true_type, Arg&& arg, Args&&... args)
+        {
+            using is_key = STL::integral_constant<bool, !STL::emplace_is_value<value_type, Arg, Args...>::value>;
+            return emplace_unique_key(emplace_key(arg, is_key()),
+                                      std::forward<Arg>(arg), std::forward<Args>(args)...);
+        }
+
+        // 否则只能先构造节点，才能取得键值
+        template <class... Args>
+        pair<iterator, bool> emplace_unique_aux(STL::false_type, Args&&... args)
+        { return insert_unique_node(create_node(std::forward<Args>(args)...)); }
+
         // 移除迭代器pos所指节点 
         void erase_aux(const_iterator pos)
         {
-            Link_type y = static_cast<Link_type>(rb_tree_rebalance_for_erase(pos.M_const_cast().node, header));
+            Link_type y = static_cast<Link_type>(rb_tree_rebalance_for_erase(pos.M_const_cast().node, header, updater()));
             drop_node(y);
             --node_count;
         }
@@ -788,6 +1328,24 @@ namespace STL
                     erase(first++);
         }
 
+        // 摘下一个键值等于k的节点
+        template <class K>
+        node_type extract_key(const K& k)
+        {
+            iterator it = M_find(k);
+            return it == end() ? node_type() : extract(it);
+        }
+
+        // 移除键值等于k的所有节点
+        template <class K>
+        size_type erase_key(const K& k)
+        {
+            pair<iterator, iterator> p = M_equal_range(k);
+            const size_type old_size = size();
+            erase(p.first, p.second);
+            return old_size - size();
+        }
+
     public:
         // 修改器
 
@@ -807,116 +1365,384 @@ namespace STL
          *           bool       是否插入成功
          */ 
         pair<iterator, bool> insert_unique(const value_type& v)
-        {
-            Link_type x = M_begin();
-            Link_type y = M_end();
-            bool cmp = true;
-            while (x) {     // x从根节点开始，往下寻找适当的插入点
-                y = x;
-                // v 小于 x 往左，v 大于等于 x 往右
-                cmp = key_compare(KeyOfValue()(v), key(x));
-                x = cmp ? left(x) : right(x);
-            }
-            // x为插入点nullptr，y是x的父节点（叶节点）
-            iterator j = iterator(y);   // 迭代器j指向y
-            if (cmp) {   // 表示x插入y左孩子
-                if (j == begin())   // y为最左节点
-                    return pair<iterator, bool>(M_insert(x, y, v), true);
-                else    // j指向自己的前驱
-                    --j;
-            }
-            if (key_compare(key(j.node), KeyOfValue()(v)))  // j指向的节点键值 小于 新增键值v
-                return pair<iterator, bool>(M_insert(x, y, v), true);
+        { return emplace_unique_key(KeyOfValue()(v), v); }
 
-            // 插入重复值
-            return pair<iterator, bool>(j, false);
-        }
+        pair<iterator, bool> insert_unique(value_type&& v)
+        { return emplace_unique_key(KeyOfValue()(v), std::move(v)); }
         
         /** 
          *  @brief  插入新值v，节点键值允许重复
          */ 
         iterator insert_equal(const value_type& v)
         {
-            Link_type x = M_begin();
-            Link_type y = M_end();
-            while (x) {     // x从根节点开始，往下寻找适当的插入点
-                y = x;
-                // v 小于 x 往左，v 大于等于 x 往右
-                x = key_compare(KeyOfValue()(v), key(x)) ? left(x) : right(x);
-            }
-            return M_insert(x, y, v);
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_equal_pos(KeyOfValue()(v));
+            return M_insert(pos.first, pos.second, v);
         }
-        
+
+        iterator insert_equal(value_type&& v)
+        { return insert_equal_node(create_node(std::move(v))); }
+
         /**
-         *  @brief  插入来自范围[first, last)的元素
-         */ 
-        template <class InputIterator>
-        void insert_unique(InputIterator first, InputIterator last)
-        {
-            for ( ; first != last; ++first)
-                insert_unique(*first);
-        }
+         *  @brief  以position为提示插入新值v，节点键值不允许重复
+         *  @return  指向新插入元素或键值重复的旧元素
+         *
+         *  v恰好应插在position之前时，查找插入点为O(1)，例如按升序插入时以end()为提示
+         *  提示不正确时与insert_unique(v)相同
+         */
+        iterator insert_unique(const_iterator position, const value_type& v)
+        { return emplace_hint_unique_key(position, KeyOfValue()(v), v); }
 
-        template <class InputIterator>
-        void insert_equal(InputIterator first, InputIterator last)
-        {
-            for ( ; first != last; ++first)
-                insert_equal(*first);
-        }
+        iterator insert_unique(const_iterator position, value_type&& v)
+        { return emplace_hint_unique_key(position, KeyOfValue()(v), std::move(v)); }
 
         /**
-         *  @brief  移除迭代器pos所指节点
-         *  @return  删除节点的后继（用该后继取代删除节点的位置）
-         */ 
-        iterator erase(const_iterator pos)
+         *  @brief  以position为提示插入新值v，节点键值允许重复
+         */
+        iterator insert_equal(const_iterator position, const value_type& v)
         {
-            const_iterator result = pos;
-            ++result;
-            erase_aux(pos);
-            return result.M_const_cast();
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_hint_equal_pos(position, KeyOfValue()(v));
+            return M_insert(pos.first, pos.second, v);
         }
 
-        iterator erase(iterator pos)
+        iterator insert_equal(const_iterator position, value_type&& v)
+        { return emplace_hint_equal(position, std::move(v)); }
+
+        /**
+         *  @brief  以args原地构造元素，节点键值不允许重复
+         *  @return  pair<iterator, bool>，含义同insert_unique
+         *
+         *  若唯一实参即为元素值，或map形式的元素以键值为首个实参，则先查找，键值已存在时不构造节点
+         */
+        template <class... Args>
+        pair<iterator, bool> emplace_unique(Args&&... args)
         {
-            iterator result = pos;
-            ++result;
-            erase_aux(pos);
-            return result;
+            return emplace_unique_aux(STL::emplace_has_key<key_type, value_type, KeyOfValue, Args...>(),
+                                      std::forward<Args>(args)...);
         }
 
         /**
-         *  @brief  移除rb_tree内迭代器范围[first, last)内的节点
-         *  @return  last迭代器
+         *  @brief  以args原地构造元素，节点键值允许重复
          */
-        iterator erase(const_iterator first, const_iterator last)
+        template <class... Args>
+        iterator emplace_equal(Args&&... args)
+        { return insert_equal_node(create_node(std::forward<Args>(args)...)); }
+
+        /**
+         *  @brief  以position为提示，以args原地构造元素，节点键值不允许重复
+         *  @return  指向新插入元素或键值重复的旧元素
+         */
+        template <class... Args>
+        iterator emplace_hint_unique(const_iterator position, Args&&... args)
         {
-            erase_aux(first, last);
-            return last.M_const_cast();
+            return emplace_hint_unique_aux(STL::emplace_has_key<key_type, value_type, KeyOfValue, Args...>(),
+                                           position, std::forward<Args>(args)...);
         }
 
         /**
-         *  @brief  移除rb_tree内键值为x的所有节点
-         *  @return  删除节点的个数
-         */ 
-        size_type erase(const key_type& x)
+         *  @brief  以position为提示，以args原地构造元素，节点键值允许重复
+         */
+        template <class... Args>
+        iterator emplace_hint_equal(const_iterator position, Args&&... args)
         {
-            pair<iterator, iterator> p = equal_range(x);
-            const size_type old_size = size();
-            erase(p.first, p.second);
-            return old_size - size();
+            Link_type z = create_node(std::forward<Args>(args)...);
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_hint_equal_pos(position, key(z));
+            return M_insert_node(pos.first, pos.second, z);
         }
-        
+
         /**
-         *  @brief  移除rb_tree中指向[first, last)的节点
+         *  @brief  若键值k不存在，则以k和args原地构造元素pair(k, T(args...))
+         *  @return  pair<iterator, bool>，含义同insert_unique
          *
-         *  first和last是Key*类型的指针
-         */ 
-        void erase(const key_type* first, const key_type* last)
+         *  仅适用于value_type为pair<const Key, T>的情形，键值已存在时不构造节点，也不移动k和args
+         */
+        template <class... Args>
+        pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        {
+            return emplace_unique_key(k, std::piecewise_construct,
+                                      std::forward_as_tuple(k),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        template <class... Args>
+        pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+        {
+            return emplace_unique_key(k, std::piecewise_construct,
+                                      std::forward_as_tuple(std::move(k)),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        template <class... Args>
+        iterator try_emplace(const_iterator position, const key_type& k, Args&&... args)
+        {
+            return emplace_hint_unique_key(position, k, std::piecewise_construct,
+                                           std::forward_as_tuple(k),
+                                           std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        template <class... Args>
+        iterator try_emplace(const_iterator position, key_type&& k, Args&&... args)
+        {
+            return emplace_hint_unique_key(position, k, std::piecewise_construct,
+                                           std::forward_as_tuple(std::move(k)),
+                                           std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        /**
+         *  @brief  若键值k不存在，则插入pair(k, obj)；否则将obj赋值给已有元素的实值
+         *  @return  pair<iterator, bool>，bool表示是否插入了新元素
+         *
+         *  仅适用于value_type为pair<const Key, T>的情形
+         */
+        template <class M>
+        pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        {
+            pair<iterator, bool> p = try_emplace(k, std::forward<M>(obj));
+            if (!p.second) {
+                p.first->second = std::forward<M>(obj);
+                refresh(p.first);   // 实值可能参与附加数据的计算
+            }
+            return p;
+        }
+
+        template <class M>
+        pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj)
+        {
+            pair<iterator, bool> p = try_emplace(std::move(k), std::forward<M>(obj));
+            if (!p.second) {
+                p.first->second = std::forward<M>(obj);
+                refresh(p.first);   // 实值可能参与附加数据的计算
+            }
+            return p;
+        }
+        
+        /**
+         *  @brief  插入来自范围[first, last)的元素
+         */ 
+        template <class InputIterator>
+        void insert_unique(InputIterator first, InputIterator last)
+        {
+            for ( ; first != last; ++first)
+                insert_unique(end(), *first);   // 以end()为提示，升序输入时无需从根节点查找
+        }
+
+        template <class InputIterator>
+        void insert_equal(InputIterator first, InputIterator last)
+        {
+            for ( ; first != last; ++first)
+                insert_equal(end(), *first);
+        }
+
+        /**
+         *  @brief  插入来自范围[first, last)的元素，该范围已按键值升序排列
+         *
+         *  树为空时不逐个插入，而是自底向上直接建成平衡树，耗时O(n)
+         *  范围实际无序时，有序的前缀仍直接建树，其后的元素逐个插入，结果依然正确
+         */ 
+        template <class InputIterator>
+        void insert_unique(sorted_range_t, InputIterator first, InputIterator last)
+        {
+            if (empty())
+                first = M_build_sorted(first, last, true);
+            insert_unique(first, last);
+        }
+
+        template <class InputIterator>
+        void insert_equal(sorted_range_t, InputIterator first, InputIterator last)
+        {
+            if (empty())
+                first = M_build_sorted(first, last, false);
+            insert_equal(first, last);
+        }
+
+        /**
+         *  @brief  移除迭代器pos所指节点
+         *  @return  删除节点的后继（用该后继取代删除节点的位置）
+         */ 
+        iterator erase(const_iterator pos)
+        {
+            const_iterator result = pos;
+            ++result;
+            erase_aux(pos);
+            return result.M_const_cast();
+        }
+
+        iterator erase(iterator pos)
+        {
+            iterator result = pos;
+            ++result;
+            erase_aux(pos);
+            return result;
+        }
+
+        /**
+         *  @brief  移除rb_tree内迭代器范围[first, last)内的节点
+         *  @return  last迭代器
+         */
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            erase_aux(first, last);
+            return last.M_const_cast();
+        }
+
+        /**
+         *  @brief  移除rb_tree内键值为x的所有节点
+         *  @return  删除节点的个数
+         */ 
+        size_type erase(const key_type& x)
+        { return erase_key(x); }
+
+        template <class K, class = transparent_erase_key<K>>
+        size_type erase(const K& x)
+        { return erase_key(x); }
+        
+        /**
+         *  @brief  移除rb_tree中指向[first, last)的节点
+         *
+         *  first和last是Key*类型的指针
+         */ 
+        void erase(const key_type* first, const key_type* last)
         {
             while (first != last)
                 erase(*first++);
         }
 
+        /**
+         *  @brief  将pos所指节点从rb_tree中摘下，交给节点句柄
+         */
+        node_type extract(const_iterator pos)
+        {
+            Link_type y = static_cast<Link_type>(rb_tree_rebalance_for_erase(pos.M_const_cast().node, header, updater()));
+            --node_count;
+            return node_type(static_cast<Node*>(y));
+        }
+
+        /**
+         *  @brief  摘下一个键值等于k的节点，不存在时返回空句柄
+         */
+        node_type extract(const key_type& k)
+        { return extract_key(k); }
+
+        template <class K, class = transparent_erase_key<K>>
+        node_type extract(const K& k)
+        { return extract_key(k); }
+
+        /**
+         *  @brief  插入节点句柄所持的节点，键值不允许重复
+         *
+         *  插入成功时句柄变空；键值已存在时节点留在返回值的node中，position指向已有元素
+         */
+        insert_return_type insert_unique(node_type&& nh)
+        {
+            if (nh.empty())
+                return insert_return_type{end(), false, node_type()};
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_unique_pos(KeyOfValue()(nh.value()));
+            if (pos.second)
+                return insert_return_type{M_insert_node(pos.first, pos.second, nh.release()), true, node_type()};
+            return insert_return_type{iterator(pos.first), false, std::move(nh)};
+        }
+
+        /**
+         *  @brief  插入节点句柄所持的节点，键值允许重复
+         */
+        iterator insert_equal(node_type&& nh)
+        {
+            if (nh.empty())
+                return end();
+            pair<Base_ptr, Base_ptr> pos = M_get_insert_equal_pos(KeyOfValue()(nh.value()));
+            return M_insert_node(pos.first, pos.second, nh.release());
+        }
+
+        /**
+         *  @brief  将src中键值在*this中不存在的节点逐个摘下并挂入*this，键值不允许重复
+         *
+         *  不分配内存也不复制实值，键值重复的节点留在src中；src的键值可以重复
+         *  两树键值都不重复且顺序相同时，set_union按子树批量合并，更快
+         */
+        template <class Compare2>
+        void merge_unique(rb_tree<Key, Val, KeyOfValue, Compare2, Alloc, Augment>& src)
+        {
+            if (static_cast<void*>(&src) == static_cast<void*>(this))
+                return;
+            for (auto it = src.begin(); it != src.end(); ) {
+                pair<Base_ptr, Base_ptr> pos = M_get_insert_unique_pos(KeyOfValue()(*it));
+                if (pos.second == nullptr) {
+                    ++it;
+                    continue;
+                }
+                auto next = it;
+                ++next;
+                M_insert_node(pos.first, pos.second, src.extract(it).release());
+                it = next;
+            }
+        }
+
+        /**
+         *  @brief  将src中的所有节点摘下并挂入*this，键值允许重复
+         *  @param  threads  线程数，0表示使用硬件线程数
+         *
+         *  不分配内存也不复制实值，键值相同的节点中来自src的排在后面
+         *  Compare2与Compare相同时以split与join按子树合并，耗时O(m log(n/m + 1))，m、n为两树中较小、较大的节点数；
+         *  否则逐个摘下src的节点插入
+         */
+        template <class Compare2>
+        void merge_equal(rb_tree<Key, Val, KeyOfValue, Compare2, Alloc, Augment>& src, unsigned threads = 1)
+        {
+            if (static_cast<void*>(&src) == static_cast<void*>(this))
+                return;
+            M_merge_equal(src, threads, STL::integral_constant<bool, std::is_same<Compare, Compare2>::value>());
+        }
+
+        /**
+         *  以下集合运算用于键值不重复的两棵树，按子树批量进行，不分配内存也不复制实值
+         *  耗时O(m log(n/m + 1))，m、n为两树中较小、较大的节点数，另需逐个销毁丢弃的节点
+         *  threads为0时使用硬件线程数；比较函数须能在多个线程上同时调用，且不得抛出异常
+         */
+
+        /**
+         *  @brief  并集：将src中键值在*this中不存在的节点移入*this，键值重复的节点按序留在src中
+         */
+        void set_union(rb_tree& src, unsigned threads = 1)
+        {
+            if (&src == this)
+                return;
+            const unsigned t = M_set_op_degree(src, threads);
+            const size_type n = node_count + src.node_count;
+            node_list dup;
+            subtree r = M_union(M_detach(), src.M_detach(), true, dup, t);
+            M_attach(r, n - dup.n);
+            src.M_attach_list(dup.head, dup.tail, dup.n);
+        }
+
+        /**
+         *  @brief  交集，保留*this中的元素，运算后src为空
+         */
+        void set_intersection(rb_tree& src, unsigned threads = 1)
+        {
+            if (&src == this)
+                return;
+            const unsigned t = M_set_op_degree(src, threads);
+            const size_type n = node_count + src.node_count;
+            node_forest g;
+            subtree r = M_intersect(M_detach(), src.M_detach(), g, t);
+            M_attach(r, n - M_drop_forest(g));
+        }
+
+        /**
+         *  @brief  差集，移除*this中键值在src中出现的元素，运算后src为空
+         */
+        void set_difference(rb_tree& src, unsigned threads = 1)
+        {
+            if (&src == this) {
+                clear();
+                return;
+            }
+            const unsigned t = M_set_op_degree(src, threads);
+            const size_type n = node_count + src.node_count;
+            node_forest g;
+            subtree r = M_difference(M_detach(), src.M_detach(), g, t);
+            M_attach(r, n - M_drop_forest(g));
+        }
+
         /**
          *  @brief  与x树交换
          */ 
@@ -924,34 +1750,408 @@ namespace STL
         {
             if (root() == nullptr) {
                 if (x.root()) {
-                    root() = x.root();
+                    set_root(x.root());
                     leftmost() = x.leftmost();
                     rightmost() = x.rightmost();
-                    root()->parent = M_end();
+                    root()->set_parent(M_end());
                     node_count = x.node_count;
                     x.reset();
                 }
             } else if (x.root() == nullptr) {
-                x.root() = root();
+                x.set_root(root());
                 x.leftmost() = leftmost();
                 x.rightmost() = rightmost();
-                x.root()->parent = x.M_end();
+                x.root()->set_parent(x.M_end());
                 x.node_count = node_count;
                 reset();
             } else {
-                STL::swap(root(), x.root());
+                Base_ptr r = root();
+                set_root(x.root());
+                x.set_root(r);
                 STL::swap(leftmost(), x.leftmost());
                 STL::swap(rightmost(), x.rightmost());
-                root()->parent = M_end();
-                x.root()->parent = x.M_end();
+                root()->set_parent(M_end());
+                x.root()->set_parent(x.M_end());
                 STL::swap(node_count, x.node_count);
             }
             STL::swap(key_compare, x.key_compare);
         }
 
+    protected:
+        // 基于join的批量集合运算
+        // 运算中的子树与header分离，以根节点及黑高（根至叶路径上的黑色节点数，不含根为红时的根）表示，
+        // 子树的根可以为红色；运算只改动节点的指针、颜色与附加数据，不分配也不释放内存，
+        // 丢弃的节点先收集起来，运算结束后在调用线程上统一释放（分配器不一定线程安全）
+        struct subtree
+        {
+            Link_type node;
+            size_type bh;
+        };
+
+        // split的结果：键值小于k的子树、键值等于k的节点（可能为nullptr）、其余节点构成的子树
+        struct split_result
+        {
+            subtree left;
+            Link_type mid;
+            subtree right;
+        };
+
+        // 由right串起的有序节点链表
+        struct node_list
+        {
+            Link_type head;
+            Link_type tail;
+            size_type n;
+
+            node_list() : head(nullptr), tail(nullptr), n(0) { }
+
+            void push_back(Link_type x)
+            {
+                x->right = nullptr;
+                if (tail)   tail->right = x;
+                else        head = x;
+                tail = x;
+                ++n;
+            }
+
+            void splice(node_list& x)
+            {
+                if (x.head == nullptr)
+                    return;
+                if (tail)   tail->right = x.head;
+                else        head = x.head;
+                tail = x.tail;
+                n += x.n;
+            }
+        };
+
+        // 待释放的子树，各子树的根由parent串起
+        struct node_forest
+        {
+            Link_type head;
+            Link_type tail;
+
+            node_forest() : head(nullptr), tail(nullptr) { }
+
+            void push(Link_type x)
+            {
+                if (x == nullptr)
+                    return;
+                x->set_parent(nullptr);
+                if (tail)   tail->set_parent(x);
+                else        head = x;
+                tail = x;
+            }
+
+            // 单个节点，不带孩子
+            void push_node(Link_type x)
+            {
+                x->left = x->right = nullptr;
+                push(x);
+            }
+
+            void splice(node_forest& x)
+            {
+                if (x.head == nullptr)
+                    return;
+                if (tail)   tail->set_parent(x.head);
+                else        head = x.head;
+                tail = x.tail;
+            }
+        };
+
+        enum { parallel_grain = 1 << 14 };      // 每个线程至少处理的元素个数
+        enum { parallel_black_height = 10 };    // 两棵子树的黑高都不小于此值时才分出线程，即至少约1000个节点
+
+        static bool is_red(Const_Base_ptr x) { return x && x->color() == red; }
+
+        // t的孩子的黑高，t不为空
+        static size_type child_bh(subtree t) { return t.node->color() == black ? t.bh - 1 : t.bh; }
+
+        // 将整棵树摘下，作为与header分离的子树，*this变为空树
+        subtree M_detach()
+        {
+            subtree t = { M_begin(), 0 };
+            for (Const_Base_ptr x = root(); x; x = x->left)
+                if (x->color() == black)
+                    ++t.bh;
+            reset();
+            return t;
+        }
+
+        // 空树时，以子树t作为整棵树，t共有n个节点
+        void M_attach(subtree t, size_type n)
+        {
+            if (t.node == nullptr)
+                return;
+            set_root(t.node);
+            root()->set_parent(M_end());
+            root()->set_color(black);
+            leftmost() = minimum(root());
+            rightmost() = maximum(root());
+            node_count = n;
+        }
+
+        // 以k为根、l与r为左右子树，k的颜色为c
+        static Link_type M_link(Link_type l, Link_type k, Link_type r, rb_tree_color c)
+        {
+            k->left = l;
+            k->right = r;
+            if (l)  l->set_parent(k);
+            if (r)  r->set_parent(k);
+            k->set_color(c);
+            updater()(k);
+            return k;
+        }
+
+        // 与header分离的子树上的旋转，返回上移的节点，其parent由调用者设置
+        static Link_type M_rotate_left(Link_type x)
+        {
+            Link_type y = right(x);
+            x->right = y->left;
+            if (x->right)   x->right->set_parent(x);
+            y->left = x;
+            x->set_parent(y);
+            updater()(x);
+            updater()(y);
+            return y;
+        }
+
+        static Link_type M_rotate_right(Link_type x)
+        {
+            Link_type y = left(x);
+            x->left = y->right;
+            if (x->left)    x->left->set_parent(x);
+            y->right = x;
+            x->set_parent(y);
+            updater()(x);
+            updater()(y);
+            return y;
+        }
+
+        // 黑高为bh的t不矮于r：沿t的右脊下降到黑高与r相同的黑色节点，以红色的k接入r
+        // 返回子树的黑高仍为bh，但根可能为红且有红色的右孩子，由M_join修正
+        static Link_type M_join_right(Link_type t, size_type bh, Link_type k, subtree r)
+        {
+            if (!is_red(t) && bh == r.bh)
+                return M_link(t, k, r.node, red);
+            Link_type c = M_join_right(right(t), t->color() == black ? bh - 1 : bh, k, r);
+            t->right = c;
+            c->set_parent(t);
+            if (t->color() == black && is_red(c) && is_red(c->right)) {
+                c->right->set_color(black);
+                return M_rotate_left(t);
+            }
+            updater()(t);
+            return t;
+        }
+
+        // 与M_join_right对称
+        static Link_type M_join_left(subtree l, Link_type k, Link_type t, size_type bh)
+        {
+            if (!is_red(t) && bh == l.bh)
+                return M_link(l.node, k, t, red);
+            Link_type c = M_join_left(l, k, left(t), t->color() == black ? bh - 1 : bh);
+            t->left = c;
+            c->set_parent(t);
+            if (t->color() == black && is_red(c) && is_red(c->left)) {
+                c->left->set_color(black);
+                return M_rotate_right(t);
+            }
+            updater()(t);
+            return t;
+        }
+
+        // l中所有键值不大于k，r中所有键值不小于k，以k连接两棵子树，耗时O(|l.bh - r.bh| + 1)
+        static subtree M_join(subtree l, Link_type k, subtree r)
+        {
+            if (l.bh > r.bh) {
+                Link_type t = M_join_right(l.node, l.bh, k, r);
+                if (is_red(t) && is_red(t->right)) {
+                    t->set_color(black);
+                    return subtree{ t, l.bh + 1 };
+                }
+                return subtree{ t, l.bh };
+            }
+            if (l.bh < r.bh) {
+                Link_type t = M_join_left(l, k, r.node, r.bh);
+                if (is_red(t) && is_red(t->left)) {
+                    t->set_color(black);
+                    return subtree{ t, r.bh + 1 };
+                }
+                return subtree{ t, r.bh };
+            }
+            if (!is_red(l.node) && !is_red(r.node))
+                return subtree{ M_link(l.node, k, r.node, red), l.bh };
+            return subtree{ M_link(l.node, k, r.node, black), l.bh + 1 };
+        }
+
+        // 摘下t中的最大节点last，返回其余节点构成的子树
+        static subtree M_split_last(subtree t, Link_type& last)
+        {
+            Link_type x = t.node;
+            const size_type bh = child_bh(t);
+            if (x->right == nullptr) {
+                last = x;
+                return subtree{ left(x), bh };
+            }
+            subtree r = M_split_last(subtree{ right(x), bh }, last);
+            return M_join(subtree{ left(x), bh }, x, r);
+        }
+
+        // 没有中间节点的join，l中所有键值不大于r中的键值
+        static subtree M_join2(subtree l, subtree r)
+        {
+            if (l.node == nullptr)
+                return r;
+            Link_type k = nullptr;
+            l = M_split_last(l, k);
+            return M_join(l, k, r);
+        }
+
+        // 按键值k拆分t，耗时O(log n)
+        // unique为true时键值等于k的节点（至多一个）作为mid；否则不小于k的节点都归入right
+        split_result M_split(subtree t, const key_type& k, bool unique) const
+        {
+            if (t.node == nullptr)
+                return split_result{ t, nullptr, t };
+            Link_type x = t.node;
+            const size_type bh = child_bh(t);
+            if (key_compare(key(x), k)) {
+                split_result s = M_split(subtree{ right(x), bh }, k, unique);
+                s.left = M_join(subtree{ left(x), bh }, x, s.left);
+                return s;
+            }
+            if (unique && !key_compare(k, key(x)))
+                return split_result{ subtree{ left(x), bh }, x, subtree{ right(x), bh } };
+            split_result s = M_split(subtree{ left(x), bh }, k, unique);
+            s.right = M_join(s.right, x, subtree{ right(x), bh });
+            return s;
+        }
+
+        // t > 1且两棵子树都足够高时，fl与fr在两个线程上并行执行，各得一半线程数；否则依次执行
+        template <class F1, class F2>
+        static void M_fork(unsigned t, size_type bh, F1 fl, F2 fr)
+        {
+            if (t > 1 && bh >= parallel_black_height) {
+                parallel_run(2, [&](unsigned i) {
+                    if (i == 0) fl(t / 2);
+                    else        fr(t - t / 2);
+                });
+            } else {
+                fl(1);
+                fr(1);
+            }
+        }
+
+        // 并集，以a的根拆分b后对左右两半递归，耗时O(m log(n/m + 1))，m、n为两者中较小、较大的节点数
+        // unique为true时b中与a键值重复的节点按序放入dup；否则b中与a键值相同的节点排在a的节点之后
+        subtree M_union(subtree a, subtree b, bool unique, node_list& dup, unsigned t) const
+        {
+            if (a.node == nullptr)
+                return b;
+            if (b.node == nullptr)
+                return a;
+            Link_type x = a.node;
+            const size_type bh = child_bh(a);
+            split_result s = M_split(b, key(x), unique);
+            subtree l, r;
+            node_list rdup;
+            M_fork(t, a.bh < b.bh ? a.bh : b.bh,
+                   [&](unsigned u) { l = M_union(subtree{ left(x), bh }, s.left, unique, dup, u); },
+                   [&](unsigned u) { r = M_union(subtree{ right(x), bh }, s.right, unique, rdup, u); });
+            if (s.mid)
+                dup.push_back(s.mid);
+            dup.splice(rdup);
+            return M_join(l, x, r);
+        }
+
+        // 交集，保留a中的节点，其余节点放入g
+        subtree M_intersect(subtree a, subtree b, node_forest& g, unsigned t) const
+        {
+            if (a.node == nullptr || b.node == nullptr) {
+                g.push(a.node);
+                g.push(b.node);
+                return subtree{ nullptr, 0 };
+            }
+            Link_type x = a.node;
+            const size_type bh = child_bh(a);
+            split_result s = M_split(b, key(x), true);
+            subtree l, r;
+            node_forest rg;
+            M_fork(t, a.bh < b.bh ? a.bh : b.bh,
+                   [&](unsigned u) { l = M_intersect(subtree{ left(x), bh }, s.left, g, u); },
+                   [&](unsigned u) { r = M_intersect(subtree{ right(x), bh }, s.right, rg, u); });
+            g.splice(rg);
+            if (s.mid) {
+                g.push_node(s.mid);
+                return M_join(l, x, r);
+            }
+            g.push_node(x);
+            return M_join2(l, r);
+        }
+
+        // 差集a - b，b中的节点及a中被移除的节点放入g
+        subtree M_difference(subtree a, subtree b, node_forest& g, unsigned t) const
+        {
+            if (a.node == nullptr || b.node == nullptr) {
+                g.push(b.node);
+                return a;
+            }
+            Link_type y = b.node;
+            const size_type bh = child_bh(b);
+            split_result s = M_split(a, key(y), true);
+            subtree l, r;
+            node_forest rg;
+            M_fork(t, a.bh < b.bh ? a.bh : b.bh,
+                   [&](unsigned u) { l = M_difference(s.left, subtree{ left(y), bh }, g, u); },
+                   [&](unsigned u) { r = M_difference(s.right, subtree{ right(y), bh }, rg, u); });
+            g.splice(rg);
+            g.push_node(y);
+            if (s.mid)
+                g.push_node(s.mid);
+            return M_join2(l, r);
+        }
+
+        // 删除g中所有子树，返回节点数
+        size_type M_drop_forest(node_forest& g)
+        {
+            size_type n = 0;
+            for (Link_type x = g.head; x; ) {
+                Link_type next = parent(x);
+                n += erase_tree(x);
+                x = next;
+            }
+            return n;
+        }
+
+        // 两棵树共用的线程数，按较小的树的大小决定
+        unsigned M_set_op_degree(const rb_tree& x, unsigned threads) const
+        { return parallel_degree(node_count < x.node_count ? node_count : x.node_count, threads, parallel_grain); }
+
+        template <class Compare2>
+        void M_merge_equal(rb_tree<Key, Val, KeyOfValue, Compare2, Alloc, Augment>& src, unsigned, STL::false_type)
+        {
+            while (!src.empty()) {
+                auto it = src.begin();
+                pair<Base_ptr, Base_ptr> pos = M_get_insert_equal_pos(KeyOfValue()(*it));
+                M_insert_node(pos.first, pos.second, src.extract(it).release());
+            }
+        }
+
+        void M_merge_equal(rb_tree& src, unsigned threads, STL::true_type)
+        {
+            const unsigned t = M_set_op_degree(src, threads);
+            const size_type n = node_count + src.node_count;
+            node_list dup;
+            subtree r = M_union(M_detach(), src.M_detach(), false, dup, t);
+            M_attach(r, n);
+        }
+
     protected:
         // 从x节点开始查找，找到首个键值不小于k的节点的迭代器
-        iterator M_lower_bound(Link_type x, Link_type y, const key_type& k)
+        template <class K>
+        iterator M_lower_bound(Link_type x, Link_type y, const K& k)
         {
             while (x)
                 if (!key_compare(key(x), k))
@@ -961,7 +2161,8 @@ namespace STL
             return iterator(y);
         }
 
-        const_iterator M_lower_bound(Const_Link_type x, Const_Link_type y, const key_type& k) const
+        template <class K>
+        const_iterator M_lower_bound(Const_Link_type x, Const_Link_type y, const K& k) const
         {
             while (x)
                 if (!key_compare(key(x), k))
@@ -972,7 +2173,8 @@ namespace STL
         }
 
         // 从x节点开始查找，找到首个键值大于k的节点的迭代器
-        iterator M_upper_bound(Link_type x, Link_type y, const key_type& k)
+        template <class K>
+        iterator M_upper_bound(Link_type x, Link_type y, const K& k)
         {
             while (x)
                 if (key_compare(k, key(x)))
@@ -982,7 +2184,8 @@ namespace STL
             return iterator(y);
         }
 
-        const_iterator M_upper_bound(Const_Link_type x, Const_Link_type y, const key_type& k) const
+        template <class K>
+        const_iterator M_upper_bound(Const_Link_type x, Const_Link_type y, const K& k) const
         {
             while (x)
                 if (key_compare(k, key(x)))
@@ -993,16 +2196,9 @@ namespace STL
         }
         
 
-    public:
-        // 查找
-        
-        /**
-         *  @brief  查寻rb_tree中所有键值为k的节点范围，范围以返回的两个迭代器定义
-         *  @return  第一个迭代器指向首个键值不小于k的节点，第二个迭代器指向首个键值大于k的节点
-         *
-         *  若无节点的键值不小于k 或 大于k，则对应的迭代器将返回end()
-         */ 
-        pair<iterator, iterator> equal_range(const key_type& k)
+        // 查寻所有键值为k的节点范围
+        template <class K>
+        pair<iterator, iterator> M_equal_range(const K& k)
         {
             Link_type x = M_begin();
             Link_type y = M_end();
@@ -1021,7 +2217,8 @@ namespace STL
             return pair<iterator, iterator>(iterator(y), iterator(y));
         }
         
-        pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+        template <class K>
+        pair<const_iterator, const_iterator> M_equal_range(const K& k) const
         {
             Const_Link_type x = M_begin();
             Const_Link_type y = M_end();
@@ -1040,6 +2237,55 @@ namespace STL
             return pair<const_iterator, const_iterator>(const_iterator(y), const_iterator(y));
         }
 
+        // 查找键值为k的节点
+        template <class K>
+        iterator M_find(const K& k)
+        {
+            iterator j = M_lower_bound(M_begin(), M_end(), k);
+            // 若k不小于y，则y指向的节点键值为k；若k小于y，则节点不存在
+            return (j == end() || key_compare(k, key(j.node))) ? end() : j;
+        }
+
+        template <class K>
+        const_iterator M_find(const K& k) const
+        {
+            const_iterator j = M_lower_bound(M_begin(), M_end(), k);
+            return (j == end() || key_compare(k, key(j.node))) ? end() : j;
+        }
+
+        // 键值等于k的节点个数
+        template <class K>
+        size_type M_count(const K& k) const
+        {
+            pair<const_iterator, const_iterator> p = M_equal_range(k);
+            const size_type n = STL::distance(p.first, p.second);
+            return n;
+        }
+
+    public:
+        // 查找
+        // Compare声明了is_transparent时，以下接口另有接受任意类型K的版本
+        
+        /**
+         *  @brief  查寻rb_tree中所有键值为k的节点范围，范围以返回的两个迭代器定义
+         *  @return  第一个迭代器指向首个键值不小于k的节点，第二个迭代器指向首个键值大于k的节点
+         *
+         *  若无节点的键值不小于k 或 大于k，则对应的迭代器将返回end()
+         */ 
+        pair<iterator, iterator> equal_range(const key_type& k)
+        { return M_equal_range(k); }
+        
+        pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+        { return M_equal_range(k); }
+
+        template <class K, class = transparent_key<K>>
+        pair<iterator, iterator> equal_range(const K& k)
+        { return M_equal_range(k); }
+
+        template <class K, class = transparent_key<K>>
+        pair<const_iterator, const_iterator> equal_range(const K& k) const
+        { return M_equal_range(k); }
+
         /**
          *  @brief  返回rb_tree中指向首个键值不小于k的节点的迭代器
          */
@@ -1048,6 +2294,14 @@ namespace STL
 
         const_iterator lower_bound(const key_type& k) const 
         { return M_lower_bound(M_begin(), M_end(), k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator lower_bound(const K& k)
+        { return M_lower_bound(M_begin(), M_end(), k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator lower_bound(const K& k) const 
+        { return M_lower_bound(M_begin(), M_end(), k); }
         
         /**
          *  @brief  返回rb_tree中指向首个键值大于k的节点的迭代器
@@ -1058,31 +2312,258 @@ namespace STL
         const_iterator upper_bound(const key_type& k) const 
         { return M_upper_bound(M_begin(), M_end(), k); }
 
+        template <class K, class = transparent_key<K>>
+        iterator upper_bound(const K& k)
+        { return M_upper_bound(M_begin(), M_end(), k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator upper_bound(const K& k) const 
+        { return M_upper_bound(M_begin(), M_end(), k); }
+
         /**
          *  @brief  查找rb_tree中键值为k的节点
          */ 
         iterator find(const key_type& k)
-        {
-            iterator j = M_lower_bound(M_begin(), M_end(), k);
-            // 若k不小于y，则y指向的节点键值为k；若k小于y，则节点不存在
-            return (j == end() || key_compare(k, key(j.node))) ? end() : j;
-        }
+        { return M_find(k); }
 
         const_iterator find(const key_type& k) const
-        {
-            const_iterator j = M_lower_bound(M_begin(), M_end(), k);
-            // 若k不小于y，则y指向的节点键值为k；若k小于y，则节点不存在
-            return (j == end() || key_compare(k, key(j.node))) ? end() : j;
-        }
+        { return M_find(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator find(const K& k)
+        { return M_find(k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator find(const K& k) const
+        { return M_find(k); }
 
         /**
          *  @brief  返回rb_tree中键值等于k的节点个数
          */ 
         size_type count(const key_type& k) const
+        { return M_count(k); }
+
+        template <class K, class = transparent_key<K>>
+        size_type count(const K& k) const
+        { return M_count(k); }
+
+    private:
+        // 顺序统计的实现，附加数据为子树节点数
+        using order_statistics_check = std::is_same<Augment, rb_tree_count_augment>;
+
+        static size_type subtree_size(Const_Base_ptr x)
+        { return x ? static_cast<const Node*>(x)->meta : 0; }
+
+        template <class K>
+        size_type M_rank(const K& k) const
         {
-            pair<const_iterator, const_iterator> p = equal_range(k);
-            const size_type n = STL::distance(p.first, p.second);
-            return n;
+            static_assert(order_statistics_check::value, "rank() requires rb_tree_count_augment");
+            size_type r = 0;
+            Const_Base_ptr x = root();
+            while (x) {
+                if (key_compare(key(x), k)) {   // x及其左子树都小于k
+                    r += subtree_size(x->left) + 1;
+                    x = x->right;
+                } else {
+                    x = x->left;
+                }
+            }
+            return r;
+        }
+
+        Base_ptr M_select(size_type i) const
+        {
+            static_assert(order_statistics_check::value, "select() requires rb_tree_count_augment");
+            if (i >= node_count)
+                return const_cast<Base_ptr>(&header);
+            Base_ptr x = root();
+            for ( ; ; ) {
+                const size_type l = subtree_size(x->left);
+                if (i < l) {
+                    x = x->left;
+                } else if (i == l) {
+                    return x;
+                } else {
+                    i -= l + 1;
+                    x = x->right;
+                }
+            }
+        }
+
+    public:
+        // 顺序统计，须以rb_tree_count_augment为节点附加数据策略，均为O(log n)
+
+        /**
+         *  @brief  键值小于k的元素个数，即首个不小于k的元素的下标
+         */
+        size_type rank(const key_type& k) const
+        { return M_rank(k); }
+
+        template <class K, class = transparent_key<K>>
+        size_type rank(const K& k) const
+        { return M_rank(k); }
+
+        /**
+         *  @brief  返回下标为i的元素（从0开始，即第i + 1小的元素），i >= size()时返回end()
+         */
+        iterator select(size_type i)
+        { return iterator(M_select(i)); }
+
+        const_iterator select(size_type i) const
+        { return const_iterator(M_select(i)); }
+
+        /**
+         *  @brief  返回pos所指元素的下标，pos为end()时返回size()
+         */
+        size_type index_of(const_iterator pos) const
+        {
+            static_assert(order_statistics_check::value, "index_of() requires rb_tree_count_augment");
+            Const_Base_ptr x = pos.node;
+            if (x == M_end())
+                return node_count;
+            size_type r = subtree_size(x->left);
+            for ( ; x != root(); x = x->parent()) {
+                if (x == x->parent()->right)
+                    r += subtree_size(x->parent()->left) + 1;
+            }
+            return r;
+        }
+
+        /**
+         *  @brief  从first到last的元素个数，不必逐个遍历
+         */
+        difference_type distance(const_iterator first, const_iterator last) const
+        { return static_cast<difference_type>(index_of(last)) - static_cast<difference_type>(index_of(first)); }
+
+    public:
+        // 节点附加数据的类型，无附加数据时无意义
+        using meta_type = typename std::conditional<is_augmented::value, Augment, rb_tree_count_augment>::type::meta_type;
+
+    private:
+        static const meta_type& meta(Const_Base_ptr x)
+        { return static_cast<const Node*>(x)->meta; }
+
+        // 遍历x子树中与[lo, hi]相交的区间，f返回false时停止，返回值表示是否遍历完毕
+        template <class F>
+        bool M_for_each_overlap(Const_Base_ptr x, const key_type& lo, const key_type& hi, F& f) const
+        {
+            while (x) {
+                if (key_compare(meta(x), lo))   // 子树中的区间都在lo之前结束
+                    return true;
+                if (!M_for_each_overlap(x->left, lo, hi, f))
+                    return false;
+                if (key_compare(hi, key(x)))    // x及其右子树中的区间都在hi之后开始
+                    return true;
+                if (!key_compare(Augment().high(value(x)), lo) && !f(const_iterator(x)))
+                    return false;
+                x = x->right;
+            }
+            return true;
+        }
+
+    public:
+        // 附加数据的维护与查询
+
+        /**
+         *  @brief  元素中参与附加数据计算的部分被修改后，更新pos至根节点路径上的附加数据
+         *
+         *  例如以map的实值求和时，通过迭代器修改实值后须调用refresh，O(log n)
+         */
+        void refresh(const_iterator pos)
+        { rb_tree_update_path(pos.M_const_cast().node, header, updater()); }
+
+        /**
+         *  @brief  所有元素的汇总值，Augment须为rb_tree_monoid_augment
+         */
+        meta_type aggregate() const
+        { return root() ? meta(root()) : Augment().identity(); }
+
+        /**
+         *  @brief  键值在[lo, hi)内的元素按顺序的汇总值，Augment须为rb_tree_monoid_augment，O(log n)
+         */
+        meta_type aggregate(const key_type& lo, const key_type& hi) const
+        {
+            const Augment a;
+            // 找到两条查找路径分开的节点x，x在范围内
+            Const_Base_ptr x = root();
+            while (x) {
+                if (key_compare(key(x), lo))
+                    x = x->right;
+                else if (!key_compare(key(x), hi))
+                    x = x->left;
+                else
+                    break;
+            }
+            if (x == nullptr)
+                return a.identity();
+            // x的左子树中不小于lo的部分：y在范围内时，y与其右子树都在范围内，且在已汇总的部分之前
+            meta_type left = a.identity();
+            for (Const_Base_ptr y = x->left; y; ) {
+                if (key_compare(key(y), lo)) {
+                    y = y->right;
+                } else {
+                    meta_type m = a.value(value(y));
+                    if (y->right)   m = a.combine(m, meta(y->right));
+                    left = a.combine(m, left);
+                    y = y->left;
+                }
+            }
+            // x的右子树中小于hi的部分，与左侧对称
+            meta_type right = a.identity();
+            for (Const_Base_ptr y = x->right; y; ) {
+                if (key_compare(key(y), hi)) {
+                    meta_type m = a.value(value(y));
+                    if (y->left)    m = a.combine(meta(y->left), m);
+                    right = a.combine(right, m);
+                    y = y->right;
+                } else {
+                    y = y->left;
+                }
+            }
+            return a.combine(a.combine(left, a.value(value(x))), right);
+        }
+
+        /**
+         *  @brief  返回首个与闭区间[lo, hi]相交的元素，不存在时返回end()
+         *
+         *  Augment须为rb_tree_interval_augment，O(log n)
+         */
+        const_iterator find_overlap(const key_type& lo, const key_type& hi) const
+        {
+            const_iterator res = end();
+            auto f = [&res](const_iterator it) { res = it; return false; };
+            M_for_each_overlap(root(), lo, hi, f);
+            return res;
+        }
+
+        /**
+         *  @brief  按顺序对每个与闭区间[lo, hi]相交的元素调用f(const_reference)
+         *
+         *  Augment须为rb_tree_interval_augment，O(k log n)，k为相交的元素个数
+         */
+        template <class F>
+        void for_each_overlap(const key_type& lo, const key_type& hi, F f) const
+        {
+            auto g = [&f](const_iterator it) { f(*it); return true; };
+            M_for_each_overlap(root(), lo, hi, g);
+        }
+
+    private:
+        // 检查每个节点的附加数据与由孩子重新计算的结果相同，meta_type须支持==
+        bool M_verify_meta(STL::false_type) const { return true; }
+
+        bool M_verify_meta(STL::true_type) const
+        {
+            for (const_iterator it = begin(); it != end(); ++it) {
+                const Node* n = static_cast<const Node*>(it.node);
+                typename Augment::meta_type m;
+                Augment()(m, *n->valptr(),
+                          n->left ? &static_cast<const Node*>(n->left)->meta : nullptr,
+                          n->right ? &static_cast<const Node*>(n->right)->meta : nullptr);
+                if (!(m == n->meta))
+                    return false;
+            }
+            return true;
         }
 
     public:
@@ -1104,7 +2585,7 @@ namespace STL
                 Const_Link_type L = left(x);
                 Const_Link_type R = right(x);
                 // 节点为红，其子节点必须为黑
-                if (x->color == red && L && R && L->color == red && R->color == red)
+                if (x->color() == red && L && R && L->color() == red && R->color() == red)
                     return false;
                 // BST性质
                 if (L && key_compare(key(x), key(L)))
@@ -1121,21 +2602,22 @@ namespace STL
             // 最右节点不为最大节点
             if (rightmost() != rb_tree_node_base::maximum(root()))
                 return false;
-            return true;
+            // 附加数据与子树一致
+            return M_verify_meta(is_augmented());
         }
     };
 
-    template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-    inline bool operator==(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& x,
-                           const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& y)
+    template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+    inline bool operator==(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& x,
+                           const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& y)
     {
         return x.size() == y.size() &&
                 STL::equal(x.begin(), x.end(), y.begin());
     }
 
-    template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-    inline bool operator!=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& x,
-                           const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& y)
+    template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+    inline bool operator!=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& x,
+                           const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& y)
     { return !(x == y); }
 
 } /* namespace STL */
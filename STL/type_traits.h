@@ -1,6 +1,10 @@
 #ifndef TINYSTL_TYPE_TRAITS_H_
 #define TINYSTL_TYPE_TRAITS_H_ 
 
+#include <functional>
+#include <type_traits>
+#include <utility>
+
 namespace STL
 {
 
@@ -38,6 +42,44 @@ namespace STL
     template <class T>
     struct is_pod
     : public integral_constant<bool, __is_pod(T)> {};
+
+    template <class T>
+    struct void_type { typedef void type; };
+
+    // 函数对象是否声明了is_transparent，声明了则容器允许以任意类型K进行异构查找
+    template <class T, class = void>
+    struct is_transparent : public false_type {};
+
+    template <class T>
+    struct is_transparent<T, typename void_type<typename T::is_transparent>::type>
+    : public true_type {};
+
+    // emplace的唯一实参即为Value：键值可由ExtractKey从中取得，对任何ExtractKey都成立
+    template <class Value, class... Args>
+    struct emplace_is_value : public false_type {};
+
+    template <class Value, class Arg>
+    struct emplace_is_value<Value, Arg>
+    : public integral_constant<bool, std::is_same<typename std::decay<Arg>::type, Value>::value> {};
+
+    // Value为pair<const Key, T>且以_Select1st取出键值，即map形式的元素
+    // 只有这时才能断定类型为Key的首个实参就是元素的键值；自定义的ExtractKey可能取元素的其他部分
+    template <class Key, class Value, class ExtractKey>
+    struct is_map_value : public false_type {};
+
+    template <class Key, class T>
+    struct is_map_value<Key, std::pair<const Key, T>, std::_Select1st<std::pair<const Key, T>>> : public true_type {};
+
+    // emplace的实参能否在构造节点之前给出键值：唯一实参即为Value，或map形式的元素以Key为首个实参
+    // 若能，则容器可先查找，仅在键值不存在时才构造节点
+    template <class Key, class Value, class ExtractKey, class... Args>
+    struct emplace_has_key : public false_type {};
+
+    template <class Key, class Value, class ExtractKey, class Arg, class... Args>
+    struct emplace_has_key<Key, Value, ExtractKey, Arg, Args...>
+    : public integral_constant<bool, emplace_is_value<Value, Arg, Args...>::value ||
+                                     (is_map_value<Key, Value, ExtractKey>::value &&
+                                      std::is_same<typename std::decay<Arg>::type, Key>::value)> {};
     
 } /* namespace STL */ 
 
@@ -1,6 +1,8 @@
 #ifndef TINYSTL_UNORDERED_MAP_H_
 #define TINYSTL_UNORDERED_MAP_H_ 
 
+#include <type_traits>
+
 #include "hashtable.h"
 
 namespace STL 
@@ -16,6 +18,9 @@ namespace STL
         using Hashtable = STL::hashtable<pair<const Key, T>, Key, HashFcn, std::_Select1st<pair<const Key, T>>, EqualKey, Alloc>;
         Hashtable rep;
 
+        template <class, class, class, class, class>
+        friend class unordered_map;
+
     public:
         using key_type          = typename Hashtable::key_type;
         using data_type         = T;
@@ -33,6 +38,20 @@ namespace STL
 
         using iterator          = typename Hashtable::iterator;
         using const_iterator    = typename Hashtable::const_iterator;
+        using node_type         = typename Hashtable::node_type;
+        using insert_return_type = typename Hashtable::insert_return_type;
+
+    private:
+        // HashFcn与EqualKey都声明了is_transparent时，查找接口接受任意可与key_type比较的类型K
+        template <class K>
+        using transparent_key = typename std::enable_if<STL::is_transparent<HashFcn>::value &&
+                                                        STL::is_transparent<EqualKey>::value, K>::type;
+
+        // erase的异构版本还须排除能转换为迭代器的K，以免与erase(const_iterator)冲突
+        template <class K>
+        using transparent_erase_key = typename std::enable_if<!std::is_convertible<K, iterator>::value &&
+                                                              !std::is_convertible<K, const_iterator>::value,
+                                                              transparent_key<K>>::type;
 
     public:
         // The big five
@@ -98,6 +117,9 @@ namespace STL
             return pair<iterator, bool>(p.first, p.second);
         }
 
+        pair<iterator, bool> insert(value_type&& x)
+        { return rep.insert_unique(std::move(x)); }
+
         /**
          *  @brief  插入来自范围[first, last)的元素
          */ 
@@ -105,12 +127,53 @@ namespace STL
         void insert(InputIterator first, InputIterator last)
         { rep.insert_unique(first, last); }
 
+        /**
+         *  @brief  以threads个线程并行插入[first, last)中的元素，threads为0时使用硬件线程数
+         */
+        template <class RandomAccessIterator>
+        void insert_parallel(RandomAccessIterator first, RandomAccessIterator last, unsigned threads = 0)
+        { rep.insert_unique_parallel(first, last, threads); }
+
         /**
          *  @brief  插入来自initializer_list的元素
          */
         void insert(std::initializer_list<value_type> l)
         { rep.insert_unique(l.begin(), l.end(), STL::random_access_iterator_tag()); }
 
+        /**
+         *  @brief  以args原地构造元素
+         *  @return  含义同insert
+         *
+         *  若首个实参即为键值，则键值已存在时不构造节点
+         */
+        template <class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        { return rep.emplace_unique(std::forward<Args>(args)...); }
+
+        /**
+         *  @brief  若键值k不存在，则插入以k和args原地构造的元素，否则什么都不做
+         *  @return  含义同insert
+         */
+        template <class... Args>
+        pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        { return rep.try_emplace(k, std::forward<Args>(args)...); }
+
+        template <class... Args>
+        pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+        { return rep.try_emplace(std::move(k), std::forward<Args>(args)...); }
+
+        /**
+         *  @brief  若键值k不存在，则插入(k, obj)，否则将obj赋值给已有元素
+         *  @return  bool表示是否插入了新元素
+         */
+        template <class M>
+        pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        { return rep.insert_or_assign(k, std::forward<M>(obj)); }
+
+        template <class M>
+        pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj)
+        { return rep.insert_or_assign(std::move(k), std::forward<M>(obj)); }
+
         /**
          *  @brief  移除位于pos的元素
          *  @return  被移除元素的下一个节点的迭代器
@@ -134,6 +197,33 @@ namespace STL
         size_type erase(const key_type& k)
         { return rep.erase(k); }
 
+        template <class K, class = transparent_erase_key<K>>
+        size_type erase(const K& k)
+        { return rep.erase(k); }
+
+        /**
+         *  @brief  将pos所指元素的节点摘下，交给节点句柄
+         */
+        node_type extract(const_iterator pos) { return rep.extract(pos); }
+        node_type extract(const key_type& k) { return rep.extract(k); }
+
+        template <class K, class = transparent_erase_key<K>>
+        node_type extract(const K& k) { return rep.extract(k); }
+
+        /**
+         *  @brief  插入节点句柄所持的节点，不分配内存也不复制元素
+         */
+        insert_return_type insert(node_type&& nh) { return rep.insert_unique(std::move(nh)); }
+
+        /**
+         *  @brief  将src中键值在本容器中不存在的元素的节点移入本容器
+         */
+        template <class H2, class E2>
+        void merge(unordered_map<Key, T, H2, E2, Alloc>& src) { rep.merge_unique(src.rep); }
+
+        template <class H2, class E2>
+        void merge(unordered_map<Key, T, H2, E2, Alloc>&& src) { rep.merge_unique(src.rep); }
+
         /**
          *  @brief  与另一个unordered_set交换数据
          */
@@ -148,7 +238,11 @@ namespace STL
          */
         mapped_type&
         operator[](const key_type& k)
-        { return rep.find_or_insert(value_type(k, mapped_type())).second; }
+        { return rep.try_emplace(k).first->second; }
+
+        mapped_type&
+        operator[](key_type&& k)
+        { return rep.try_emplace(std::move(k)).first->second; }
 
         /**
          *  @brief  返回键值为k的元素个数
@@ -156,19 +250,62 @@ namespace STL
         size_type count(const key_type& k) const 
         { return rep.count(k); }
 
+        template <class K, class = transparent_key<K>>
+        size_type count(const K& k) const 
+        { return rep.count(k); }
+
         /**
          *  @brief  返回指向键值为k的元素的迭代器
          */
-        iterator find(const key_type& k) const 
+        iterator find(const key_type& k)
         { return rep.find(k); }
 
+        const_iterator find(const key_type& k) const 
+        { return rep.find(k); }
+
+        template <class K, class = transparent_key<K>>
+        iterator find(const K& k)
+        { return rep.find(k); }
+
+        template <class K, class = transparent_key<K>>
+        const_iterator find(const K& k) const 
+        { return rep.find(k); }
+
+        /**
+         *  @brief  批量查找keys[0, n)，out[i]为keys[i]的查找结果，交错预取以隐藏访存延迟
+         */
+        void find_batch(const key_type* keys, size_type n, iterator* out)
+        { rep.find_batch(keys, n, out); }
+
+        void find_batch(const key_type* keys, size_type n, const_iterator* out) const
+        { rep.find_batch(keys, n, out); }
+
+        template <class K, class = transparent_key<K>>
+        void find_batch(const K* keys, size_type n, iterator* out)
+        { rep.find_batch(keys, n, out); }
+
+        template <class K, class = transparent_key<K>>
+        void find_batch(const K* keys, size_type n, const_iterator* out) const
+        { rep.find_batch(keys, n, out); }
+
         /**
          *  @brief  查找hashtable中键值为k的节点范围
          *  @return  pair<iterator, iterator>
          *           第一个指向范围的首节点
          *           第二个指向范围的尾后一位节点
          */
-        pair<iterator, iterator> equal_range(const key_type& k) const 
+        pair<iterator, iterator> equal_range(const key_type& k)
+        { return rep.equal_range(k); }
+
+        pair<const_iterator, const_iterator> equal_range(const key_type& k) const 
+        { return rep.equal_range(k); }
+
+        template <class K, class = transparent_key<K>>
+        pair<iterator, iterator> equal_range(const K& k)
+        { return rep.equal_range(k); }
+
+        template <class K, class = transparent_key<K>>
+        pair<const_iterator, const_iterator> equal_range(const K& k) const 
         { return rep.equal_range(k); }
 
     public:
@@ -181,6 +318,11 @@ namespace STL
          */
         size_type bucket_size(size_type n) const { return rep.bucket_size(n); }
 
+        /**
+         *  @brief  桶分布统计：链长直方图、最长链、空桶比例与平均探测代价
+         */
+        hashtable_stats stats() const { return rep.stats(); }
+
     public:
         // 哈希策略
         
@@ -188,6 +330,22 @@ namespace STL
          *  @brief  负载系数
          */
         float load_factor() const noexcept { return rep.load_factor(); }
+
+        /**
+         *  @brief  最大负载系数
+         */
+        float max_load_factor() const noexcept { return rep.max_load_factor(); }
+        void max_load_factor(float z) { rep.max_load_factor(z); }
+
+        /**
+         *  @brief  将桶数重设为不小于n
+         */
+        void rehash(size_type n) { rep.rehash(n); }
+
+        /**
+         *  @brief  预留容纳n个元素的桶
+         */
+        void reserve(size_type n) { rep.reserve(n); }
 	
 public:
         // 观察器
@@ -1,6 +1,8 @@
 #ifndef TINYSTL_UNORDERED_SET_H_
 #define TINYSTL_UNORDERED_SET_H_ 
 
+#include <type_traits>
+
 #include "hashtable.h"
 
 namespace STL 
@@ -15,6 +17,9 @@ namespace STL
         using Hashtable = STL::hashtable<Value, Value, HashFcn, std::_Identity<Value>, EqualKey, Alloc>;
         Hashtable rep;
 
+        template <class, class, class, class>
+        friend class unordered_set;
+
     public:
         using key_type          = typename Hashtable::key_type;
         using value_type        = typename Hashtable::value_type;
@@ -30,6 +35,20 @@ namespace STL
 
         using iterator          = typename Hashtable::const_iterator;
         using const_iterator    = typename Hashtable::const_iterator;
+        using node_type         = typename Hashtable::node_type;
+        using insert_return_type = node_insert_return<iterator, node_type>;
+
+    private:
+        // HashFcn与EqualKey都声明了is_transparent时，查找接口接受任意可与key_type比较的类型K
+        template <class K>
+        using transparent_key = typename std::enable_if<STL::is_transparent<HashFcn>::value &&
+                                                        STL::is_transparent<EqualKey>::value, K>::type;
+
+        // erase的异构版本还须排除能转换为迭代器的K，以免与erase(const_iterator)冲突
+        template <class K>
+        using transparent_erase_key = typename std::enable_if<!std::is_convertible<K, iterator>::value &&
+                                                              !std::is_convertible<K, const_iterator>::value,
+                                                              transparent_key<K>>::type;
 
     public:
         // The big five
@@ -95,6 +114,12 @@ namespace STL
             return pair<iterator, bool>(p.first, p.second);
         }
 
+        pair<iterator, bool> insert(value_type&& x)
+        {
+            pair<typename Hashtable::iterator, bool> p = rep.insert_unique(std::move(x));
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
         /**
          *  @brief  插入来自范围[first, last)的元素
          */ 
@@ -102,12 +127,32 @@ namespace STL
         void insert(InputIterator first, InputIterator last)
         { rep.insert_unique(first, last); }
 
+        /**
+         *  @brief  以threads个线程并行插入[first, last)中的元素，threads为0时使用硬件线程数
+         */
+        template <class RandomAccessIterator>
+        void insert_parallel(RandomAccessIterator first, RandomAccessIterator last, unsigned threads = 0)
+        { rep.insert_unique_parallel(first, last, threads); }
+
         /**
          *  @brief  插入来自initializer_list的元素
          */
         void insert(std::initializer_list<value_type> l)
         { rep.insert_unique(l.begin(), l.end(), STL::random_access_iterator_tag()); }
 
+        /**
+         *  @brief  以args原地构造元素
+         *  @return  含义同insert
+         *
+         *  若唯一实参即为元素值，则元素已存在时不构造节点
+         */
+        template <class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        {
+            pair<typename Hashtable::iterator, bool> p = rep.emplace_unique(std::forward<Args>(args)...);
+            return pair<iterator, bool>(p.first, p.second);
+        }
+
         /**
          *  @brief  移除位于pos的元素
          *  @return  被移除元素的下一个节点的迭代器
@@ -131,6 +176,37 @@ namespace STL
         size_type erase(const key_type& k)
         { return rep.erase(k); }
 
+        template <class K, class = transparent_erase_key<K>>
+        size_type erase(const K& k)
+        { return rep.erase(k); }
+
+        /**
+         *  @brief  将pos所指元素的节点摘下，交给节点句柄
+         */
+        node_type extract(const_iterator pos) { return rep.extract(pos); }
+        node_type extract(const key_type& k) { return rep.extract(k); }
+
+        template <class K, class = transparent_erase_key<K>>
+        node_type extract(const K& k) { return rep.extract(k); }
+
+        /**
+         *  @brief  插入节点句柄所持的节点，不分配内存也不复制元素
+         */
+        insert_return_type insert(node_type&& nh)
+        {
+            typename Hashtable::insert_return_type r = rep.insert_unique(std::move(nh));
+            return insert_return_type{r.position, r.inserted, std::move(r.node)};
+        }
+
+        /**
+         *  @brief  将src中在本容器中不存在的元素的节点移入本容器
+         */
+        template <class H2, class E2>
+        void merge(unordered_set<Value, H2, E2, Alloc>& src) { rep.merge_unique(src.rep); }
+
+        template <class H2, class E2>
+        void merge(unordered_set<Value, H2, E2, Alloc>&& src) { rep.merge_unique(src.rep); }
+
         /**
          *  @brief  与另一个unordered_set交换数据
          */
@@ -146,12 +222,30 @@ namespace STL
         size_type count(const key_type& k) const 
         { return rep.count(k); }
 
+        template <class K, class = transparent_key<K>>
+        size_type count(const K& k) const 
+        { return rep.count(k); }
+
         /**
          *  @brief  返回指向键值为k的元素的迭代器
          */
         iterator find(const key_type& k) const 
         { return rep.find(k); }
 
+        template <class K, class = transparent_key<K>>
+        iterator find(const K& k) const 
+        { return rep.find(k); }
+
+        /**
+         *  @brief  批量查找keys[0, n)，out[i]为keys[i]的查找结果，交错预取以隐藏访存延迟
+         */
+        void find_batch(const key_type* keys, size_type n, iterator* out) const
+        { rep.find_batch(keys, n, out); }
+
+        template <class K, class = transparent_key<K>>
+        void find_batch(const K* keys, size_type n, iterator* out) const
+        { rep.find_batch(keys, n, out); }
+
         /**
          *  @brief  查找hashtable中键值为k的节点范围
          *  @return  pair<iterator, iterator>
@@ -161,6 +255,10 @@ namespace STL
         pair<iterator, iterator> equal_range(const key_type& k) const 
         { return rep.equal_range(k); }
 
+        template <class K, class = transparent_key<K>>
+        pair<iterator, iterator> equal_range(const K& k) const 
+        { return rep.equal_range(k); }
+
     public:
         // 桶接口
         size_type bucket_count() const { return rep.bucket_count(); }
@@ -171,6 +269,11 @@ namespace STL
          */
         size_type bucket_size(size_type n) const { return rep.bucket_size(n); }
 
+        /**
+         *  @brief  桶分布统计：链长直方图、最长链、空桶比例与平均探测代价
+         */
+        hashtable_stats stats() const { return rep.stats(); }
+
     public:
         // 哈希策略
         
@@ -179,6 +282,22 @@ namespace STL
          */
         float load_factor() const noexcept { return rep.load_factor(); }
 
+        /**
+         *  @brief  最大负载系数
+         */
+        float max_load_factor() const noexcept { return rep.max_load_factor(); }
+        void max_load_factor(float z) { rep.max_load_factor(z); }
+
+        /**
+         *  @brief  将桶数重设为不小于n
+         */
+        void rehash(size_type n) { rep.rehash(n); }
+
+        /**
+         *  @brief  预留容纳n个元素的桶
+         */
+        void reserve(size_type n) { rep.reserve(n); }
+
     public:
         // 观察器
         
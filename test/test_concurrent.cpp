@@ -0,0 +1,383 @@
+/*************************************************************************
+    > File Name: test_concurrent.cpp
+    > Author: Stewie
+    > E-mail: 793377164@qq.com
+    > Created Time: 2018-06-20
+*************************************************************************/
+#include "../STL/concurrent_map.h"
+#include "../STL/concurrent_set.h"
+#include "../STL/concurrent_unordered_map.h"
+#include "../STL/rcu_hashtable.h"
+#include "test_util.h"
+
+#include <thread>
+#include <vector>
+
+using cmap = STL::concurrent_unordered_map<int, int>;
+using rcu_map = STL::rcu_hashtable<pair<const int, int>, int, std::hash<int>,
+                                   std::_Select1st<pair<const int, int>>, std::equal_to<int>>;
+using skip_map = STL::concurrent_map<int, int>;
+using skip_set = STL::concurrent_set<int>;
+
+const int THREADS = 4;
+const int PER_THREAD = 10000;
+
+// 单线程下的基本操作
+void test_case1()
+{
+    cout << "<test_case01>" << endl;
+
+    cmap m(5);
+    assert(m.shard_count() == 8);
+    assert(m.empty());
+
+    assert(m.insert(pair<const int, int>(1, 10)));
+    assert(!m.insert(pair<const int, int>(1, 11)));
+    assert(m.try_emplace(2, 20));
+    assert(!m.try_emplace(2, 21));
+    assert(m.insert_or_assign(3, 30));
+    assert(!m.insert_or_assign(3, 31));
+    assert(m.size() == 3);
+
+    int v = 0;
+    assert(m.find(1, v) && v == 10);
+    assert(m.find(2, v) && v == 20);
+    assert(m.find(3, v) && v == 31);
+    assert(!m.find(4, v));
+    assert(m.count(1) == 1 && m.count(4) == 0);
+
+    assert(m.visit(1, [](pair<const int, int>& x) { x.second += 5; }));
+    assert(!m.visit(4, [](pair<const int, int>& x) { x.second += 5; }));
+    assert(m.cvisit(1, [&v](const pair<const int, int>& x) { v = x.second; }) && v == 15);
+
+    int sum = 0;
+    m.cvisit_all([&sum](const pair<const int, int>& x) { sum += x.second; });
+    assert(sum == 15 + 20 + 31);
+
+    assert(m.erase(2) == 1 && m.erase(2) == 0);
+    assert(m.size() == 2);
+    m.clear();
+    assert(m.empty());
+}
+
+// 多线程插入互不相交的键值，同时有读线程查找
+void test_case2()
+{
+    cout << "<test_case02>" << endl;
+
+    cmap m(16, THREADS * PER_THREAD);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&m, t]() {
+            for (int i = t * PER_THREAD; i < (t + 1) * PER_THREAD; ++i)
+                assert(m.try_emplace(i, i * 2));
+        });
+    }
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&m]() {
+            int v;
+            for (int i = 0; i < THREADS * PER_THREAD; ++i)
+                if (m.find(i, v))
+                    assert(v == i * 2);
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    assert(int(m.size()) == THREADS * PER_THREAD);
+    int v;
+    for (int i = 0; i < THREADS * PER_THREAD; ++i)
+        assert(m.find(i, v) && v == i * 2);
+}
+
+// 多线程对同一组键值计数，visit()在写锁内修改实值
+void test_case3()
+{
+    cout << "<test_case03>" << endl;
+
+    const int KEYS = 100;
+    cmap m;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&m]() {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                int k = i % KEYS;
+                m.try_emplace(k, 0);
+                m.visit(k, [](pair<const int, int>& x) { ++x.second; });
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    assert(int(m.size()) == KEYS);
+    int total = 0;
+    m.cvisit_all([&total](const pair<const int, int>& x) { total += x.second; });
+    assert(total == THREADS * PER_THREAD);
+
+    // 并发删除
+    threads.clear();
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&m, t]() {
+            for (int k = t; k < KEYS; k += THREADS)
+                assert(m.erase(k) == 1);
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    assert(m.empty());
+}
+
+// rcu_hashtable单线程下的基本操作
+void test_case4()
+{
+    cout << "<test_case04>" << endl;
+
+    rcu_map m(10);
+    assert(m.empty());
+    for (int i = 0; i < 1000; ++i)
+        assert(m.insert(pair<const int, int>(i, i)));
+    assert(!m.insert(pair<const int, int>(0, 1)));
+    assert(!m.emplace(1, 1));
+    assert(m.emplace(1000, 1000));
+    assert(m.size() == 1001 && m.bucket_count() >= 1001);
+
+    assert(!m.insert_or_replace(pair<const int, int>(5, 50)));
+    assert(m.insert_or_replace(pair<const int, int>(-1, -1)));
+    int v = 0;
+    assert(m.visit(5, [&v](const pair<const int, int>& x) { v = x.second; }) && v == 50);
+    assert(!m.visit(2000, [&v](const pair<const int, int>& x) { v = x.second; }));
+
+    assert(m.erase(5) == 1 && m.erase(5) == 0);
+    assert(m.count(5) == 0 && m.count(6) == 1);
+    assert(m.size() == 1001);
+
+    long long sum = 0;
+    m.visit_all([&sum](const pair<const int, int>& x) { sum += x.second; });
+    assert(sum == 1000LL * 1001 / 2 - 5 - 1);
+
+    m.clear();
+    assert(m.empty() && m.count(6) == 0);
+}
+
+// 读者不加锁并发查找，写者同时插入、替换、删除并触发扩容
+void test_case5()
+{
+    cout << "<test_case05>" << endl;
+
+    const int KEYS = 20000;
+    rcu_map m(10);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < THREADS; ++t) {
+        readers.emplace_back([&m, &done]() {
+            while (!done.load()) {
+                for (int i = 0; i < KEYS; i += 7) {
+                    // 元素的实值只可能是键值的2倍或3倍，读者永远看不到写了一半的元素
+                    m.visit(i, [i](const pair<const int, int>& x) {
+                        assert(x.first == i);
+                        assert(x.second == i * 2 || x.second == i * 3);
+                    });
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < KEYS; ++i)
+        m.insert(pair<const int, int>(i, i * 2));
+    for (int i = 0; i < KEYS; i += 2)
+        m.insert_or_replace(pair<const int, int>(i, i * 3));
+    for (int i = 0; i < KEYS; i += 3)
+        m.erase(i);
+    done.store(true);
+    for (auto& th : readers)
+        th.join();
+
+    for (int i = 0; i < KEYS; ++i) {
+        int v = -1;
+        bool found = m.visit(i, [&v](const pair<const int, int>& x) { v = x.second; });
+        if (i % 3 == 0)
+            assert(!found);
+        else
+            assert(found && v == (i % 2 == 0 ? i * 3 : i * 2));
+    }
+    assert(int(m.size()) == KEYS - (KEYS + 2) / 3);
+}
+
+// 并发跳表单线程下的基本操作
+void test_case6()
+{
+    cout << "<test_case06>" << endl;
+
+    skip_map m;
+    assert(m.empty() && m.verify());
+    for (int i = 0; i < 1000; i += 2)
+        assert(m.insert(pair<const int, int>(i, i * 2)));
+    assert(!m.insert(pair<const int, int>(0, 1)));
+    assert(m.emplace(1, 2) && !m.emplace(1, 3));
+    assert(m.try_emplace(3, 6) && !m.try_emplace(3, 7));
+    assert(m.size() == 502 && m.verify());
+
+    int v = 0;
+    assert(m.find(3, v) && v == 6);
+    assert(!m.find(5, v));
+    assert(m.count(998) == 1 && m.count(999) == 0);
+
+    {
+        STL::epoch_guard guard;
+        int prev = -1, n = 0;
+        for (skip_map::const_iterator it = m.begin(); it != m.end(); ++it, ++n) {
+            assert(it->first > prev && it->second == it->first * 2);
+            prev = it->first;
+        }
+        assert(n == 502);
+        assert(m.find(5) == m.end() && m.find(4)->second == 8);
+        assert(m.lower_bound(5)->first == 6 && m.lower_bound(6)->first == 6);
+        assert(m.upper_bound(6)->first == 8 && m.upper_bound(998) == m.end());
+    }
+
+    long long sum = 0;
+    assert(m.visit_range(10, 20, [&sum](const pair<const int, int>& x) { sum += x.first; }) == 5);
+    assert(sum == 10 + 12 + 14 + 16 + 18);
+
+    for (int i = 0; i < 1000; i += 4)
+        assert(m.erase(i) == 1);
+    assert(m.erase(0) == 0 && m.count(0) == 0 && m.count(2) == 1);
+    assert(m.size() == 252 && m.verify());
+    m.clear();
+    assert(m.empty() && m.verify());
+
+    skip_set s{5, 3, 9, 1, 3};
+    assert(s.size() == 4 && s.count(3) == 1 && s.verify());
+    STL::epoch_guard guard;
+    const int expected[] = {1, 3, 5, 9};
+    int i = 0;
+    for (skip_set::const_iterator it = s.begin(); it != s.end(); ++it)
+        assert(*it == expected[i++]);
+    assert(*s.lower_bound(4) == 5);
+}
+
+// 多线程插入交错的键值，同时有读线程查找并按序遍历
+void test_case7()
+{
+    cout << "<test_case07>" << endl;
+
+    skip_map m;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&m, t]() {
+            for (int i = t; i < THREADS * PER_THREAD; i += THREADS)
+                assert(m.try_emplace(i, i * 2));
+        });
+    }
+    std::vector<std::thread> readers;
+    for (int t = 0; t < THREADS; ++t) {
+        readers.emplace_back([&m, &done]() {
+            while (!done.load()) {
+                int v;
+                for (int i = 0; i < THREADS * PER_THREAD; i += 97)
+                    if (m.find(i, v))
+                        assert(v == i * 2);
+                // 遍历总是按键值严格递增
+                int prev = -1;
+                m.visit_all([&prev](const pair<const int, int>& x) {
+                    assert(x.first > prev && x.second == x.first * 2);
+                    prev = x.first;
+                });
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    done.store(true);
+    for (auto& th : readers)
+        th.join();
+
+    assert(int(m.size()) == THREADS * PER_THREAD && m.verify());
+    int v;
+    for (int i = 0; i < THREADS * PER_THREAD; ++i)
+        assert(m.find(i, v) && v == i * 2);
+}
+
+// 多线程在同一组键值上并发插入、删除，读线程同时做范围遍历
+void test_case8()
+{
+    cout << "<test_case08>" << endl;
+
+    const int KEYS = 512;
+    skip_set s;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&s, &done]() {
+            while (!done.load()) {
+                int prev = -1;
+                s.visit_range(KEYS / 4, KEYS / 2, [&prev](int x) {
+                    assert(x >= KEYS / 4 && x < KEYS / 2 && x > prev);
+                    prev = x;
+                });
+            }
+        });
+    }
+    std::vector<std::atomic<int>> balance(KEYS);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; ++t) {
+        writers.emplace_back([&s, &balance, t]() {
+            unsigned x = t + 1;
+            for (int i = 0; i < PER_THREAD; ++i) {
+                x = x * 1103515245 + 12345;
+                int k = (x >> 8) % KEYS;
+                if (x & 0x10000) {
+                    if (s.insert(k))
+                        ++balance[k];
+                } else {
+                    balance[k] -= int(s.erase(k));
+                }
+            }
+        });
+    }
+    for (auto& th : writers)
+        th.join();
+    done.store(true);
+    for (auto& th : readers)
+        th.join();
+
+    // 每个键值成功插入与成功删除的次数之差即为其是否仍在集合中
+    assert(s.verify());
+    size_t n = 0;
+    for (int k = 0; k < KEYS; ++k) {
+        assert(balance[k] == 0 || balance[k] == 1);
+        assert(int(s.count(k)) == balance[k]);
+        n += balance[k];
+    }
+    assert(s.size() == n);
+
+    // 与插入并发清空
+    std::thread inserter([&s]() {
+        for (int k = 0; k < KEYS; ++k)
+            s.insert(k + KEYS);
+    });
+    s.clear();
+    inserter.join();
+    s.clear();
+    assert(s.empty() && s.verify());
+}
+
+void test_all_cases()
+{
+    test_case1();
+    test_case2();
+    test_case3();
+    test_case4();
+    test_case5();
+    test_case6();
+    test_case7();
+    test_case8();
+}
+
+int main()
+{
+    test_all_cases();
+    return 0;
+}
@@ -4,11 +4,76 @@
     > E-mail: 793377164@qq.com
     > Created Time: 2018-06-11
 *************************************************************************/
+#include <cmath>
+#include <cstddef>
+#include <unordered_map>
+
 #include "../STL/hashtable.h"
+#include "../STL/compact_set.h"
+#include "../STL/compact_map.h"
+#include "../STL/hash.h"
+#include "../STL/lru_cache.h"
+#include "../STL/mmap_hashtable.h"
+#include "../STL/static_hash_map.h"
+#include "../STL/unordered_map.h"
 #include "test_util.h"
 
 using hashtable = STL::hashtable<int, int, std::hash<int>, std::_Identity<int>, std::equal_to<int>>;
 
+// 支持异构查找的字符串hash函数与相等性函数，string与const char*得到相同的hash值
+struct StrHash
+{
+    using is_transparent = void;
+
+    size_t operator()(const char* s) const 
+    {
+        size_t h = 14695981039346656037ull;     // FNV-1a
+        for ( ; *s; ++s)
+            h = (h ^ static_cast<unsigned char>(*s)) * 1099511628211ull;
+        return h;
+    }
+    size_t operator()(const string& s) const { return (*this)(s.c_str()); }
+};
+
+struct StrEqual
+{
+    using is_transparent = void;
+
+    bool operator()(const string& lhs, const string& rhs) const { return lhs == rhs; }
+    bool operator()(const string& lhs, const char* rhs) const { return lhs == rhs; }
+    bool operator()(const char* lhs, const string& rhs) const { return rhs == lhs; }
+};
+
+using str_hashtable = STL::hashtable<string, string, StrHash, std::_Identity<string>, StrEqual>;
+
+// 记录构造次数的实值类型
+struct Counted
+{
+    static int constructed;
+    int v;
+
+    Counted(int x = 0) : v(x) { ++constructed; }
+    Counted(const Counted& x) : v(x.v) { ++constructed; }
+};
+int Counted::constructed = 0;
+
+using map_hashtable = STL::hashtable<pair<const int, Counted>, int, std::hash<int>,
+                                     std::_Select1st<pair<const int, Counted>>, std::equal_to<int>>;
+
+// 键值不是首个成员的元素，以自定义的KeyOf取出键值
+struct Rec
+{
+    int id;
+    int key;
+
+    Rec(int i, int k) : id(i), key(k) { }
+};
+
+struct RecKey
+{
+    const int& operator()(const Rec& r) const { return r.key; }
+};
+
 void PrintHt(const hashtable& ht)
 {
     cout << "load_factor: " << ht.load_factor() << endl;
@@ -52,9 +117,20 @@ void test_case2()
     for (i = 0; i < 1000; ++i)
         ht.insert_unique(i);
 
+    // 节点串接在单向链表上，遍历顺序与桶的顺序无关，但每个元素恰好被访问一次
+    STL::vector<int> visited(size_t(1000), 0);
     i = 0;
     for (hashtable::const_iterator it = ht.begin(); it != ht.end(); ++it, ++i)
-        assert(*it == i);
+        ++visited[*it];
+    assert(i == 1000);
+    for (i = 0; i < 1000; ++i)
+        assert(visited[i] == 1);
+
+    // 大量删除后桶很稀疏，遍历依然只经过剩余节点
+    for (i = 0; i < 999; ++i)
+        ht.erase(i);
+    assert(*ht.begin() == 999);
+    assert(++ht.begin() == ht.end());
 }
 
 // 容量
@@ -191,6 +267,666 @@ void test_case9()
     assert(ht1 != ht3);
 }
 
+// 异构查找
+void test_case10()
+{
+    cout << "<test_case10>" << endl;
+
+    str_hashtable ht(50);
+    ht.insert_unique(string("apple"));
+    ht.insert_equal(string("banana"));
+    ht.insert_equal(string("banana"));
+    ht.insert_unique(string("cherry"));
+
+    // 以const char*查找，不构造临时string
+    assert(*ht.find("apple") == "apple");
+    assert(ht.find("durian") == ht.end());
+    assert(ht.count("banana") == 2);
+    auto r = ht.equal_range("banana");
+    assert(STL::distance(r.first, r.second) == 2);
+
+    const str_hashtable& cht = ht;
+    assert(*cht.find("cherry") == "cherry");
+
+    assert(ht.erase("banana") == 2);
+    assert(ht.erase("banana") == 0);
+    assert(ht.size() == 2);
+    // 迭代器版本的erase不受影响
+    ht.erase(ht.find("apple"));
+    assert(ht.size() == 1);
+}
+
+// try_emplace()、insert_or_assign()、emplace_unique()、emplace_equal()
+void test_case11()
+{
+    cout << "<test_case11>" << endl;
+
+    map_hashtable t(50);
+    Counted::constructed = 0;
+    assert(t.try_emplace(1, 10).second);
+    assert(Counted::constructed == 1);
+    // 键值已存在：不构造节点，也不构造实值
+    assert(!t.try_emplace(1, 99).second);
+    assert(Counted::constructed == 1);
+    assert(t.find(1)->second.v == 10);
+
+    assert(!t.insert_or_assign(1, Counted(20)).second);
+    assert(t.find(1)->second.v == 20);
+    assert(t.insert_or_assign(2, Counted(5)).second);
+    assert(t.find(2)->second.v == 5);
+
+    // 首个实参即为键值时，键值已存在则不构造节点
+    Counted::constructed = 0;
+    assert(!t.emplace_unique(2, 7).second);
+    assert(Counted::constructed == 0);
+    assert(t.emplace_unique(3, 7).second);
+    assert(Counted::constructed == 1);
+    // 否则先构造再判断
+    assert(!t.emplace_unique(pair<int, int>(3, 8)).second);
+    assert(t.find(3)->second.v == 7);
+    assert(t.size() == 3);
+
+    t.emplace_equal(1, 30);
+    assert(t.count(1) == 2);
+
+    // 元素不是map形式时，类型为键值的首个实参未必是键值，须先构造节点再取键值
+    STL::hashtable<Rec, int, std::hash<int>, RecKey, std::equal_to<int>> r(10);
+    assert(r.emplace_unique(1, 2).second);
+    assert(r.emplace_unique(2, 1).second);
+    assert(!r.emplace_unique(1, 1).second);
+    assert(r.size() == 2 && r.find(2)->id == 1 && r.find(1)->id == 2);
+    for (int i = 0; i < 100; ++i)
+        r.emplace_unique(i, 100 - i);
+    assert(r.size() == 100);
+    for (int k = 1; k <= 100; ++k)
+        assert(r.count(k) == 1);
+}
+
+// 哈希策略：max_load_factor()、rehash()、reserve()
+void test_case12()
+{
+    cout << "<test_case12>" << endl;
+
+    hashtable ht(10);
+    assert(ht.max_load_factor() == 1.0f);
+
+    // reserve之后插入不超过预留个数的元素不会重建table
+    ht.reserve(1000);
+    const size_t n = ht.bucket_count();
+    assert(n >= 1000);
+    for (int i = 0; i < 1000; ++i)
+        ht.insert_unique(i);
+    assert(ht.bucket_count() == n);
+
+    // 降低最大负载系数会立即扩容
+    ht.max_load_factor(0.25f);
+    assert(ht.max_load_factor() == 0.25f);
+    assert(ht.load_factor() <= 0.25f);
+    for (int i = 1000; i < 5000; ++i)
+        ht.insert_unique(i);
+    assert(ht.load_factor() <= 0.25f);
+    const size_t n2 = ht.bucket_count();
+
+    // 提高最大负载系数后，rehash可以缩减桶数，但不会少于容纳现有元素所需的桶数
+    ht.max_load_factor(4.0f);
+    ht.rehash(0);
+    assert(ht.bucket_count() < n2);
+    assert(ht.load_factor() <= 4.0f);
+    for (int i = 0; i < 5000; ++i)
+        assert(ht.count(i) == 1);
+
+    // 复制与交换保留最大负载系数
+    hashtable ht2(ht), ht3(10);
+    assert(ht2.max_load_factor() == 4.0f);
+    ht3.swap(ht2);
+    assert(ht3.max_load_factor() == 4.0f && ht2.max_load_factor() == 1.0f);
+    assert(Container_Equal(ht, ht3));
+
+    // 非正数与NaN按最小值1/8处理，桶数仍然有限
+    hashtable ht4(10);
+    for (int i = 0; i < 100; ++i)
+        ht4.insert_unique(i);
+    ht4.max_load_factor(0.0f);
+    assert(ht4.max_load_factor() == 0.125f && ht4.bucket_count() >= 800);
+    ht4.max_load_factor(-1.0f);
+    assert(ht4.max_load_factor() == 0.125f);
+    ht4.max_load_factor(std::nanf(""));
+    assert(ht4.max_load_factor() == 0.125f && ht4.bucket_count() < 100000);
+    for (int i = 0; i < 100; ++i)
+        assert(ht4.count(i) == 1);
+}
+
+// 并行批量插入
+void test_case13()
+{
+    cout << "<test_case13>" << endl;
+
+    // 含重复键值的输入，插入非空的hashtable
+    STL::vector<int> v;
+    for (int i = 0; i < 200000; ++i)
+        v.push_back(i * 7 % 150000);
+
+    hashtable ht1(10), ht2(10);
+    for (int i = -100; i < 100; ++i) {
+        ht1.insert_unique(i);
+        ht2.insert_unique(i);
+    }
+    ht1.insert_unique(v.begin(), v.end());
+    ht2.insert_unique_parallel(v.begin(), v.end(), 4);
+    assert(ht2.size() == 150100);
+    assert(ht1 == ht2);
+    for (int i = -100; i < 150000; ++i)
+        assert(ht2.count(i) == 1);
+
+    // 键值允许重复时，相同键值的节点保持相邻
+    hashtable ht3(10), ht4(10);
+    ht3.insert_equal(v.begin(), v.end());
+    ht4.insert_equal_parallel(v.begin(), v.end(), 4);
+    assert(ht4.size() == v.size());
+    assert(ht3 == ht4);
+    assert(ht4.count(0) == 2);
+
+    // 已有的元素优先，不会被范围内键值相同的元素替换
+    STL::hashtable<pair<const int, int>, int, std::hash<int>,
+                   std::_Select1st<pair<const int, int>>, std::equal_to<int>> mh(10);
+    mh.insert_unique(pair<const int, int>(1, -1));
+    STL::vector<pair<int, int>> kv;
+    for (int i = 0; i < 100000; ++i)
+        kv.push_back(pair<int, int>(i % 50000, i));
+    mh.insert_unique_parallel(kv.begin(), kv.end(), 3);
+    assert(mh.size() == 50000);
+    assert(mh.find(1)->second == -1);
+    assert(mh.find(2)->second == 2);
+
+    // 元素的复制经由pool_alloc分配空间时，元素只在调用线程上构造
+    STL::unordered_map<int, STL::vector<int>> um;
+    STL::vector<pair<int, STL::vector<int>>> kvv;
+    for (int i = 0; i < 40000; ++i)
+        kvv.push_back(pair<int, STL::vector<int>>(i, STL::vector<int>(size_t(i % 5 + 1), i)));
+    um.insert_parallel(kvv.begin(), kvv.end(), 4);
+    assert(um.size() == 40000);
+    for (int i = 0; i < 40000; i += 97)
+        assert(um.find(i)->second.size() == size_t(i % 5 + 1) && um.find(i)->second.back() == i);
+}
+
+// 批量查找
+void test_case14()
+{
+    cout << "<test_case14>" << endl;
+
+    hashtable ht(10);
+    for (int i = 0; i < 1000; i += 2)
+        ht.insert_unique(i);
+
+    // 键值个数不是batch_size的整数倍，且含有不存在的键值
+    STL::vector<int> keys;
+    for (int i = -5; i < 1040; ++i)
+        keys.push_back(i);
+    STL::vector<hashtable::iterator> out(keys.size());
+    ht.find_batch(&keys[0], keys.size(), &out[0]);
+    for (size_t i = 0; i < keys.size(); ++i)
+        assert(out[i] == ht.find(keys[i]));
+
+    const hashtable& cht = ht;
+    STL::vector<hashtable::const_iterator> cres(keys.size());
+    cht.find_batch(&keys[0], keys.size(), &cres[0]);
+    for (size_t i = 0; i < keys.size(); ++i)
+        assert(cres[i] == cht.find(keys[i]));
+
+    // 异构批量查找
+    str_hashtable sht(10);
+    sht.insert_unique("apple");
+    sht.insert_unique("banana");
+    const char* skeys[] = { "banana", "cherry", "apple" };
+    str_hashtable::iterator sout[3];
+    sht.find_batch(skeys, 3, sout);
+    assert(*sout[0] == "banana" && sout[1] == sht.end() && *sout[2] == "apple");
+}
+
+// 节点句柄：extract()、insert(node_type&&)、merge_unique()、merge_equal()
+void test_case15()
+{
+    cout << "<test_case15>" << endl;
+
+    map_hashtable h1(10), h2(10);
+    for (int i = 0; i < 100; ++i)
+        h1.emplace_unique(i, i);
+    for (int i = 50; i < 150; ++i)
+        h2.emplace_unique(i, -i);
+
+    // 摘下与插回都不构造新的实值
+    Counted::constructed = 0;
+    map_hashtable::node_type nh = h1.extract(10);
+    assert(!nh.empty() && nh.key() == 10 && nh.mapped().v == 10);
+    assert(h1.size() == 99 && h1.count(10) == 0);
+    assert(h1.extract(10).empty());
+
+    nh.key() = 1000;
+    map_hashtable::insert_return_type r = h2.insert_unique(std::move(nh));
+    assert(r.inserted && r.node.empty() && r.position->first == 1000);
+
+    r = h2.insert_unique(h1.extract(h1.find(60)));
+    assert(!r.inserted && r.node.key() == 60 && r.position->second.v == -60);
+    assert(h2.insert_equal(std::move(r.node))->second.v == 60);
+    assert(h2.count(60) == 2);
+
+    // 从各个位置摘下节点后，桶的前驱指针仍然正确，h1余下65个元素
+    for (int i = 0; i < 100; i += 3)
+        h1.extract(i);
+    for (auto it = h1.begin(); it != h1.end(); ++it)
+        assert(h1.find(it->first) == it);
+
+    // h2中51~99间3的倍数（含60）、100~149及1000共68个节点移入h1
+    h1.merge_unique(h2);
+    assert(Counted::constructed == 0);
+    assert(h1.size() == 65 + 68 && h2.size() == 102 - 68);
+    assert(h1.find(120)->second.v == -120 && h1.find(55)->second.v == 55);
+    assert(h1.find(51)->second.v == -51);
+
+    h1.merge_equal(h2);
+    assert(h2.empty() && h1.size() == 200 - 33);
+    assert(h1.count(55) == 2 && h1.count(60) == 2);
+    assert(Counted::constructed == 0);
+}
+
+// 紧凑set：随机插入、删除后与std::unordered_map对照，墓碑较多时仍能正确查找
+void test_case16()
+{
+    cout << "<test_case16>" << endl;
+
+    STL::compact_set<unsigned> s;
+    std::unordered_map<unsigned, int> ref;
+    std::mt19937 gen(16);
+    for (int i = 0; i < 200000; ++i) {
+        unsigned k = gen() % 5000;
+        if (gen() % 3) {
+            assert(s.insert(k).second == ref.emplace(k, 0).second);
+        } else {
+            assert(s.erase(k) == ref.erase(k));
+        }
+    }
+    assert(s.size() == ref.size());
+    assert(s.load_factor() <= s.max_load_factor());
+    size_t n = 0;
+    for (auto it = s.begin(); it != s.end(); ++it, ++n)
+        assert(ref.count(*it) == 1);
+    assert(n == s.size());
+    for (unsigned k = 0; k < 5000; ++k)
+        assert(s.count(k) == ref.count(k));
+
+    // 迭代时删除
+    STL::compact_set<unsigned> t(s);
+    for (auto it = t.begin(); it != t.end(); )
+        it = *it % 2 ? t.erase(it) : ++it;
+    for (auto it = t.begin(); it != t.end(); ++it)
+        assert(*it % 2 == 0 && s.count(*it) == 1);
+
+    // rehash可以缩小槽位数，reserve之后插入不再重建table
+    s.clear();
+    s.rehash(0);
+    assert(s.empty() && s.bucket_count() == 8);
+    s.reserve(1000);
+    STL::compact_set<unsigned>::size_type buckets = s.bucket_count();
+    for (unsigned k = 0; k < 1000; ++k)
+        s.insert(k * 7919);
+    assert(s.bucket_count() == buckets && s.size() == 1000);
+
+    STL::vector<unsigned> keys;
+    for (unsigned k = 0; k < 100; ++k)
+        keys.push_back(k * 7919 + (k % 2));
+    STL::vector<STL::compact_set<unsigned>::iterator> out(keys.size());
+    s.find_batch(&keys[0], keys.size(), &out[0]);
+    for (size_t i = 0; i < keys.size(); ++i)
+        assert(out[i] == s.find(keys[i]) && (out[i] == s.end()) == (i % 2 == 1));
+
+    // 最大负载系数被限制在[1/8, 15/16]内，table填满前总会重建，查找不存在的键值能终止
+    STL::compact_set<int> f;
+    f.max_load_factor(1.0f);
+    assert(f.max_load_factor() < 1.0f);
+    for (int k = 0; k < 8; ++k)
+        f.insert(k);
+    assert(f.count(100) == 0 && f.size() == 8 && f.bucket_count() > 8);
+    f.max_load_factor(0.0f);
+    assert(f.max_load_factor() > 0.0f && f.count(3) == 1);
+}
+
+// 紧凑map：operator[]、try_emplace、insert_or_assign与非平凡的实值
+void test_case17()
+{
+    cout << "<test_case17>" << endl;
+
+    using cmap = STL::compact_map<long long, std::string>;
+    cmap m;
+    for (long long i = 0; i < 1000; ++i)
+        m[i * 1000003] = std::to_string(i);
+    assert(m.size() == 1000 && m[5 * 1000003] == "5");
+
+    assert(!m.try_emplace(0, "x").second && m[0] == "0");
+    assert(m.try_emplace(-1, 3, 'a').second && m[-1] == "aaa");
+    assert(!m.insert_or_assign(-1, std::string("b")).second && m[-1] == "b");
+    assert(m.emplace(-2, "c").second && !m.emplace(-2, "d").second);
+
+    cmap c = m;
+    for (long long i = 0; i < 1000; i += 2)
+        assert(c.erase(i * 1000003) == 1);
+    assert(c.size() == 502 && m.size() == 1002);
+    for (long long i = 0; i < 1000; ++i) {
+        cmap::const_iterator it = c.find(i * 1000003);
+        assert(i % 2 ? it->second == std::to_string(i) : it == c.end());
+    }
+
+    c.swap(m);
+    assert(c.size() == 1002 && m.size() == 502);
+    m = c;
+    assert(m.size() == 1002 && m.find(-2)->second == "c");
+}
+
+// 桶分布统计：直方图与bucket_size()一致，分布不均的hash函数探测代价明显偏大
+struct CoarseHash
+{
+    size_t operator()(int k) const { return k / 100; }
+};
+
+void test_case18()
+{
+    cout << "<test_case18>" << endl;
+
+    hashtable good(1000);
+    STL::hashtable<int, int, CoarseHash, std::_Identity<int>, std::equal_to<int>> bad(1000);
+    for (int i = 0; i < 1000; ++i) {
+        good.insert_unique(i);
+        bad.insert_unique(i);
+    }
+
+    STL::hashtable_stats gs = good.stats();
+    assert(gs.element_count == 1000 && gs.bucket_count == good.bucket_count());
+    size_t buckets = 0, elements = 0, max_chain = 0;
+    for (size_t len = 0; len < gs.chain_histogram.size(); ++len) {
+        buckets += gs.chain_histogram[len];
+        elements += len * gs.chain_histogram[len];
+    }
+    for (size_t n = 0; n < good.bucket_count(); ++n)
+        max_chain = std::max(max_chain, good.bucket_size(n));
+    assert(buckets == gs.bucket_count && elements == 1000);
+    assert(gs.max_chain == max_chain && gs.chain_histogram.size() == max_chain + 1);
+    assert(gs.empty_buckets == gs.chain_histogram[0]);
+    assert(gs.probes_hit < 2.0 && gs.probes_miss < 3.0);
+
+    // 每100个连续的键值落入同一个桶
+    STL::hashtable_stats bs = bad.stats();
+    assert(bs.max_chain == 100 && bs.chain_histogram[100] == 10);
+    assert(bs.empty_buckets == bs.bucket_count - 10);
+    assert(bs.probes_hit == 50.5 && bs.probes_miss == 100.0);
+
+    hashtable empty(10);
+    STL::hashtable_stats es = empty.stats();
+    assert(es.max_chain == 0 && es.empty_bucket_ratio == 1.0f && es.probes_hit == 0.0);
+}
+
+// TinySTL的hash函数对象
+void test_case19()
+{
+    cout << "<test_case19>" << endl;
+
+    // 各种长度的字节串：std::string与C字符串一致，改动任一字节都改变hash值
+    STL::hash<std::string> hs;
+    std::string s;
+    for (int len = 0; len < 200; ++len) {
+        const size_t h = hs(s);
+        assert(h == hs(s.c_str()) && h == STL::hash<const char*>()(s.c_str()));
+        for (int i = 0; i < len; ++i) {
+            std::string t = s;
+            t[i] ^= 1;
+            assert(hs(t) != h);
+        }
+        s.push_back(static_cast<char>('a' + len % 26));
+        assert(hs(s) != h);
+    }
+    assert(STL::hash_bytes("abc", 3, 1) != STL::hash_bytes("abc", 3, 2));
+
+    // 步长为1024的整数用低10位分桶时，恒等hash全部落入0号桶，混合后应大致均匀
+    STL::hash<unsigned long long> hi;
+    size_t bins[1024] = { 0 };
+    for (unsigned long long i = 0; i < 1024 * 64; ++i)
+        ++bins[hi(i << 10) & 1023];
+    for (int i = 0; i < 1024; ++i)
+        assert(bins[i] > 16 && bins[i] < 160);
+
+    // 合并与顺序有关
+    STL::hash<std::pair<int, int>> hp;
+    assert(hp(std::make_pair(1, 2)) != hp(std::make_pair(2, 1)));
+    STL::hash<std::tuple<int, std::string, char>> ht;
+    assert(ht(std::make_tuple(1, std::string("a"), 'b')) == ht(std::make_tuple(1, std::string("a"), 'b')));
+    assert(ht(std::make_tuple(1, std::string("a"), 'b')) != ht(std::make_tuple(1, std::string("b"), 'a')));
+    size_t seed = 0;
+    STL::hash_combine(seed, 1);
+    STL::hash_combine(seed, 2);
+    assert(seed == hp(std::make_pair(1, 2)));
+
+    // 作为容器的HashFcn，并以const char*异构查找
+    STL::unordered_map<std::string, int, STL::hash<std::string>, STL::string_equal> m;
+    for (int i = 0; i < 1000; ++i)
+        m[std::to_string(i)] = i;
+    assert(m.find("500")->second == 500 && m.count("1000") == 0);
+    STL::unordered_map<std::pair<int, int>, int, STL::hash<std::pair<int, int>>> pm;
+    for (int i = 0; i < 100; ++i)
+        for (int j = 0; j < 100; ++j)
+            pm[std::make_pair(i, j)] = i * 100 + j;
+    assert(pm.size() == 10000 && pm[std::make_pair(42, 17)] == 4217);
+    assert(pm.stats().max_chain < 10);
+}
+
+// LRU缓存：按元素个数与按字节数限制容量，淘汰回调
+struct StrBytes
+{
+    size_t operator()(int, const std::string& s) const { return s.size(); }
+};
+
+void test_case20()
+{
+    cout << "<test_case20>" << endl;
+
+    STL::lru_cache<int, int> c(3);
+    STL::vector<int> evicted;
+    c.set_evict_callback([&evicted](const int& k, int&) { evicted.push_back(k); });
+    assert(c.put(1, 10) && c.put(2, 20) && c.put(3, 30));
+    assert(*c.get(1) == 10);            // 使用顺序：1 3 2
+    assert(c.put(4, 40));               // 淘汰2
+    assert(evicted.size() == 1 && evicted[0] == 2 && c.get(2) == nullptr);
+    assert(!c.put(3, 33) && *c.peek(3) == 33);  // 使用顺序：3 4 1
+    int order[] = { 3, 4, 1 };
+    int i = 0;
+    for (auto it = c.begin(); it != c.end(); ++it)
+        assert(it->first == order[i++]);
+    assert(*c.peek(1) == 10 && c.begin()->first == 3);  // peek不改变使用顺序
+    assert(c.try_emplace(5, 50).second && c.count(1) == 0 && evicted.back() == 1);
+    assert(!c.try_emplace(4, 0).second && *c.get(4) == 40);
+
+    c.set_capacity(1);
+    assert(c.size() == 1 && c.begin()->first == 4 && evicted.size() == 4);
+    assert(c.erase(4) == 1 && c.erase(4) == 0 && c.empty() && c.weight() == 0);
+    assert(evicted.size() == 4);
+
+    // 按字节数限制容量，刚写入的超大元素单独保留
+    STL::lru_cache<int, std::string, std::hash<int>, std::equal_to<int>, StrBytes> bc(10);
+    bc.put(1, std::string(4, 'a'));
+    bc.put(2, std::string(4, 'b'));
+    assert(bc.weight() == 8);
+    bc.put(1, std::string(5, 'a'));     // 9
+    bc.put(3, std::string(3, 'c'));     // 淘汰2
+    assert(bc.weight() == 8 && bc.count(2) == 0 && bc.size() == 2);
+    bc.put(4, std::string(20, 'd'));
+    assert(bc.size() == 1 && bc.weight() == 20 && bc.get(4)->size() == 20);
+
+    // 大量随机操作后，链表与hashtable一致
+    STL::lru_cache<int, int> big(1000);
+    std::mt19937 gen(20);
+    for (int n = 0; n < 100000; ++n) {
+        int k = gen() % 3000;
+        if (gen() % 4)
+            big.put(k, k);
+        else if (int* v = big.get(k))
+            assert(*v == k);
+    }
+    size_t n = 0;
+    for (auto it = big.begin(); it != big.end(); ++it, ++n)
+        assert(big.count(it->first) == 1 && it->second == it->first);
+    assert(n == big.size() && n == 1000 && big.weight() == 1000);
+    big.clear();
+    assert(big.empty() && big.begin() == big.end());
+}
+
+// 持久化hashtable：写成文件后mmap打开，直接查找
+void test_case21()
+{
+    cout << "<test_case21>" << endl;
+
+    using table = STL::mmap_hashtable<unsigned long long, unsigned long long>;
+    const char* path = "test_mmap_hashtable.bin";
+    STL::unordered_map<unsigned long long, unsigned long long> src;
+    for (unsigned long long i = 0; i < 100000; ++i)
+        src[i * 0x9e3779b97f4a7c15ull] = i;
+    table::write(path, src);
+
+    table t(path);
+    assert(t.is_open() && t.size() == src.size());
+    for (auto it = src.begin(); it != src.end(); ++it)
+        assert(t.find(it->first)->second == it->second && t.at(it->first) == it->second);
+    assert(t.count(1) == 0 && t.find(1) == t.end());
+    size_t n = 0;
+    for (table::const_iterator it = t.begin(); it != t.end(); ++it, ++n)
+        assert(src[it->first] == it->second);
+    assert(n == src.size());
+
+    // 映射与地址无关：复制到另一块内存后attach，结果相同
+    STL::vector<unsigned long long> copy(size_t(0));
+    {
+        std::FILE* f = std::fopen(path, "rb");
+        std::fseek(f, 0, SEEK_END);
+        const long len = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        copy.resize(len / sizeof(unsigned long long));
+        assert(std::fread(&copy[0], 1, len, f) == size_t(len));
+        std::fclose(f);
+    }
+    table a;
+    assert(a.find(0) == a.end());
+    a.attach(&copy[0], copy.size() * sizeof(unsigned long long));
+    assert(a.at(5 * 0x9e3779b97f4a7c15ull) == 5 && a.count(7) == 0);
+
+    // 移动后原对象为空；键值或实值类型不符、数据截断时拒绝打开
+    table m(std::move(t));
+    assert(!t.is_open() && m.size() == src.size());
+    bool thrown = false;
+    try {
+        STL::mmap_hashtable<unsigned long long, unsigned int> bad(path);
+    } catch(const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    thrown = false;
+    try {
+        a.attach(&copy[0], copy.size() * sizeof(unsigned long long) - 8);
+    } catch(const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown && !a.is_open());
+
+    // 桶下标不单调、桶数大到使段长度的计算溢出时拒绝打开
+    // 头部依次为magic、4个uint32_t，之后copy[3]为桶数，copy[5]为桶数组的偏移
+    const size_t bkt0 = size_t(copy[5] / sizeof(unsigned long long));
+    const unsigned long long saved = copy[bkt0 + 1];
+    copy[bkt0 + 1] = src.size() + 5;
+    thrown = false;
+    try {
+        a.attach(&copy[0], copy.size() * sizeof(unsigned long long));
+    } catch(const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    copy[bkt0 + 1] = saved;
+    const unsigned long long saved_count = copy[3];
+    copy[3] = 1ull << 61;
+    thrown = false;
+    try {
+        a.attach(&copy[0], copy.size() * sizeof(unsigned long long));
+    } catch(const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    copy[3] = saved_count;
+    a.attach(&copy[0], copy.size() * sizeof(unsigned long long));
+    assert(a.size() == src.size());
+
+    // 元素中的填充字节写为0
+    {
+        using padded = STL::mmap_hashtable<uint32_t, uint64_t>;
+        STL::vector<std::pair<uint32_t, uint64_t>> kv;
+        for (uint32_t i = 0; i < 1000; ++i)
+            kv.push_back(std::pair<uint32_t, uint64_t>(i, ~uint64_t(i)));
+        padded::write(path, kv.begin(), kv.end());
+        padded pt(path);
+        assert(pt.size() == 1000 && pt.at(7) == ~uint64_t(7));
+        for (padded::const_iterator it = pt.begin(); it != pt.end(); ++it) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&*it);
+            for (size_t j = sizeof(uint32_t); j < offsetof(padded::value_type, second); ++j)
+                assert(bytes[j] == 0);
+        }
+    }
+
+    // 空表
+    STL::vector<std::pair<int, int>> none;
+    STL::mmap_hashtable<int, int>::write(path, none.begin(), none.end());
+    STL::mmap_hashtable<int, int> e(path);
+    assert(e.empty() && e.find(0) == e.end());
+    std::remove(path);
+}
+
+// 最小完美hash的static_hash_map
+void test_case22()
+{
+    cout << "<test_case22>" << endl;
+
+    for (int n : { 1, 2, 7, 100, 5000, 100000 }) {
+        STL::vector<std::pair<int, int>> items;
+        for (int i = 0; i < n; ++i)
+            items.push_back(std::make_pair(i * 7 - n, i));
+        STL::static_hash_map<int, int> m(items.begin(), items.end());
+        assert(m.size() == size_t(n) && m.bucket_count() == size_t(n / 4 + 1));
+        for (int i = 0; i < n; ++i)
+            assert(m.find(i * 7 - n)->second == i && m.at(i * 7 - n) == i);
+        for (int i = 0; i < 100; ++i)
+            assert(m.count(i * 7 - n + 1) == 0);
+        size_t seen = 0;
+        for (auto it = m.begin(); it != m.end(); ++it, ++seen)
+            assert(it->second == (it->first + n) / 7);
+        assert(seen == size_t(n));
+    }
+
+    // 字符串键值，重复的键值保留先出现的元素
+    STL::static_hash_map<std::string, int> s = {
+        { "alpha", 1 }, { "beta", 2 }, { "gamma", 3 }, { "beta", 4 }
+    };
+    assert(s.size() == 3 && s.at("beta") == 2 && s.count("delta") == 0);
+    STL::static_hash_map<std::string, int> c(s);
+    STL::static_hash_map<std::string, int> e;
+    assert(e.empty() && e.find("alpha") == e.end());
+    e = c;
+    assert(e.at("gamma") == 3 && c.at("alpha") == 1);
+    STL::static_hash_map<std::string, int> mv(std::move(c));
+    assert(mv.at("alpha") == 1 && c.empty() && c.find("alpha") == c.end());
+
+    // 不同的键值hash值相同时无法构造
+    bool thrown = false;
+    try {
+        STL::vector<std::pair<int, int>> bad = { { 1, 1 }, { 2, 2 } };
+        STL::static_hash_map<int, int, CoarseHash> b(bad.begin(), bad.end());
+    } catch(const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
 void test_all_cases()
 {
     test_case1();
@@ -202,6 +938,19 @@ void test_all_cases()
     test_case7();
     test_case8();
     test_case9();
+    test_case10();
+    test_case11();
+    test_case12();
+    test_case13();
+    test_case14();
+    test_case15();
+    test_case16();
+    test_case17();
+    test_case18();
+    test_case19();
+    test_case20();
+    test_case21();
+    test_case22();
 }
 
 int main()
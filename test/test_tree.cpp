@@ -6,6 +6,22 @@
 *************************************************************************/
 #include "/usr/include/c++/5.4.0/bits/stl_tree.h"
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../STL/btree_map.h"
+#include "../STL/btree_set.h"
+#include "../STL/map.h"
+#include "../STL/persistent_map.h"
+#include "../STL/set.h"
 #include "../STL/tree.h"
 #include "../STL/vector.h"
 #include "profiler.h"
@@ -14,13 +30,52 @@
 using stdRbtree = std::_Rb_tree<int, int, std::_Identity<int>, std::less<int>>;
 using myRbtree = STL::rb_tree<int, int, std::_Identity<int>, std::less<int>>;
 
+// 支持异构查找的字符串比较函数
+struct StrLess
+{
+    using is_transparent = void;
+
+    bool operator()(const string& lhs, const string& rhs) const { return lhs < rhs; }
+    bool operator()(const string& lhs, const char* rhs) const { return lhs.compare(rhs) < 0; }
+    bool operator()(const char* lhs, const string& rhs) const { return rhs.compare(lhs) > 0; }
+};
+
+using strRbtree = STL::rb_tree<string, string, std::_Identity<string>, StrLess>;
+
+// 记录构造次数的实值类型
+struct Counted
+{
+    static int constructed;
+    int v;
+
+    Counted(int x = 0) : v(x) { ++constructed; }
+    Counted(const Counted& x) : v(x.v) { ++constructed; }
+};
+int Counted::constructed = 0;
+
+using mapRbtree = STL::rb_tree<int, pair<const int, Counted>, std::_Select1st<pair<const int, Counted>>, std::less<int>>;
+
+// 键值不是首个成员的元素，以自定义的KeyOf取出键值
+struct Rec
+{
+    int id;
+    int key;
+
+    Rec(int i, int k) : id(i), key(k) { }
+};
+
+struct RecKey
+{
+    const int& operator()(const Rec& r) const { return r.key; }
+};
+
 // 判断红黑树相等，包括颜色比较
 // 第一个参数为std::_Rb_tree，第二个参数为自己实现的STL::rb_tree 
 bool Rbtree_Equal(const stdRbtree& rbt1, const myRbtree& rbt2) {
     auto first1 = rbt1.begin(), last1 = rbt1.end();
     auto first2 = rbt2.begin(), last2 = rbt2.end();
     for ( ; first1 != last1 && first2 != last2; ++first1, ++first2) {
-        if (*first1 != *first2 || first1._M_node->_M_color ^ first2.node->color)
+        if (*first1 != *first2 || first1._M_node->_M_color ^ first2.node->color())
             return false;
     }
     return first1 == last1 && first2 == last2;
@@ -31,6 +86,9 @@ void test_case1()
 {
     cout << "<test_case01>" << endl;
     
+    // 颜色存放在父节点指针的最低位，节点头部只占3个指针
+    assert(sizeof(STL::rb_tree_node_base) == 3 * sizeof(void*));
+
     stdRbtree rbt1;
     myRbtree rbt2;
     for (int i = 0; i < 1000; ++i) {
@@ -222,6 +280,853 @@ void test_case10()
     assert(rbt.rb_verify());
 }
 
+// 异构查找
+void test_case11()
+{
+    cout << "<test_case11>" << endl;
+
+    strRbtree rbt;
+    for (const char* s : {"b", "d", "d", "f", "h"})
+        rbt.insert_equal(string(s));
+
+    // 以const char*查找，不构造临时string
+    assert(*rbt.find("f") == "f");
+    assert(rbt.find("e") == rbt.end());
+    assert(rbt.count("d") == 2);
+    assert(*rbt.lower_bound("c") == "d");
+    assert(*rbt.upper_bound("d") == "f");
+    auto r = rbt.equal_range("d");
+    assert(STL::distance(r.first, r.second) == 2);
+
+    const strRbtree& crbt = rbt;
+    assert(*crbt.find("h") == "h");
+
+    assert(rbt.erase("d") == 2);
+    assert(rbt.size() == 3);
+    rbt.erase(rbt.begin());
+    assert(*rbt.begin() == "f");
+    assert(rbt.rb_verify());
+}
+
+// try_emplace()、insert_or_assign()、emplace_unique()、emplace_equal()
+void test_case12()
+{
+    cout << "<test_case12>" << endl;
+
+    mapRbtree t;
+    Counted::constructed = 0;
+    assert(t.try_emplace(1, 10).second);
+    assert(Counted::constructed == 1);
+    // 键值已存在：不构造节点，也不构造实值
+    assert(!t.try_emplace(1, 99).second);
+    assert(Counted::constructed == 1);
+    assert(t.find(1)->second.v == 10);
+
+    assert(!t.insert_or_assign(1, Counted(20)).second);
+    assert(t.find(1)->second.v == 20);
+    assert(t.insert_or_assign(2, Counted(5)).second);
+    assert(t.find(2)->second.v == 5);
+
+    // 首个实参即为键值时，键值已存在则不构造节点
+    Counted::constructed = 0;
+    assert(!t.emplace_unique(2, 7).second);
+    assert(Counted::constructed == 0);
+    assert(t.emplace_unique(3, 7).second);
+    assert(Counted::constructed == 1);
+    // 否则先构造再判断
+    assert(!t.emplace_unique(pair<int, int>(3, 8)).second);
+    assert(t.find(3)->second.v == 7);
+    assert(t.size() == 3);
+
+    t.emplace_equal(1, 30);
+    assert(t.count(1) == 2);
+    assert(t.rb_verify());
+
+    // 元素不是map形式时，类型为键值的首个实参未必是键值，须先构造节点再取键值
+    STL::rb_tree<int, Rec, RecKey, std::less<int>> r;
+    assert(r.emplace_unique(1, 2).second);
+    assert(r.emplace_unique(2, 1).second);
+    assert(!r.emplace_unique(1, 1).second);
+    assert(r.size() == 2 && r.find(2)->id == 1 && r.find(1)->id == 2);
+    assert(r.emplace_hint_unique(r.end(), 9, 3) != r.end() && r.count(3) == 1);
+    assert(r.emplace_hint_unique(r.end(), 3, 9)->id == 3 && r.size() == 4);
+    STL::btree<int, Rec, RecKey, std::less<int>> b;
+    assert(b.emplace_unique(1, 2).second);
+    assert(b.emplace_unique(2, 1).second);
+    assert(!b.emplace_unique(1, 1).second);
+    assert(b.size() == 2 && b.find(2)->id == 1 && b.find(1)->id == 2);
+}
+
+// 节点句柄：extract()、insert(node_type&&)、merge_unique()、merge_equal()
+void test_case13()
+{
+    cout << "<test_case13>" << endl;
+
+    mapRbtree t1, t2;
+    for (int i = 0; i < 100; ++i)
+        t1.emplace_unique(i, i);
+    for (int i = 50; i < 150; ++i)
+        t2.emplace_unique(i, -i);
+
+    // 摘下与插回都不构造新的实值
+    Counted::constructed = 0;
+    mapRbtree::node_type nh = t1.extract(10);
+    assert(!nh.empty() && nh.key() == 10 && nh.mapped().v == 10);
+    assert(t1.size() == 99 && t1.count(10) == 0 && t1.rb_verify());
+    assert(t1.extract(10).empty());
+
+    // 修改键值后插入另一棵树
+    nh.key() = 1000;
+    mapRbtree::insert_return_type r = t2.insert_unique(std::move(nh));
+    assert(r.inserted && r.node.empty() && r.position->first == 1000);
+    assert(nh.empty());
+
+    // 键值已存在时节点留在返回值中
+    r = t2.insert_unique(t1.extract(t1.find(60)));
+    assert(!r.inserted && !r.node.empty() && r.node.key() == 60 && r.position->second.v == -60);
+    assert(t2.insert_equal(std::move(r.node))->second.v == 60);
+    assert(t2.count(60) == 2 && t2.rb_verify());
+
+    // t1缺少10和60：t2中键值在t1中不存在的节点（60、100~149、1000）移入t1，其余留在t2中
+    t1.merge_unique(t2);
+    assert(Counted::constructed == 0);
+    assert(t1.size() == 98 + 52);
+    assert(t2.size() == 50);
+    assert(t1.find(120)->second.v == -120 && t1.find(55)->second.v == 55);
+    assert(t1.count(60) == 1 && t2.count(60) == 1);
+    assert(t1.rb_verify() && t2.rb_verify());
+
+    t1.merge_equal(t2);
+    assert(t2.empty() && t1.size() == 200);
+    assert(t1.count(55) == 2 && t1.rb_verify());
+    assert(Counted::constructed == 0);
+}
+
+// B树：随机插入、删除后与std::multiset对照，元素较大时每个节点只有3个元素，树高较大
+struct Wide
+{
+    int k;
+    char pad[120];
+
+    Wide(int x = 0) : k(x) { pad[0] = static_cast<char>(x); }
+};
+
+struct WideKey
+{
+    const int& operator()(const Wide& w) const { return w.k; }
+};
+
+template <class Tree, class KeyOf>
+void btree_random_test(Tree& t, KeyOf key, int rounds, int range, unsigned seed)
+{
+    using value_type = typename Tree::value_type;
+    std::multiset<int> ref;
+    std::mt19937 gen(seed);
+    for (int i = 0; i < rounds; ++i) {
+        const int k = static_cast<int>(gen() % range);
+        const unsigned op = gen() % 4;
+        if (op < 2) {
+            assert(key(*t.insert_equal(value_type(k))) == k);
+            ref.insert(k);
+        } else if (op == 2) {
+            assert(t.erase(k) == ref.erase(k));
+        } else {
+            // 删除首个不小于k的元素，返回的迭代器指向其后继
+            auto it = t.lower_bound(k);
+            auto rit = ref.lower_bound(k);
+            assert((it == t.end()) == (rit == ref.end()));
+            if (it == t.end())
+                continue;
+            it = t.erase(it);
+            rit = ref.erase(rit);
+            assert(rit == ref.end() ? it == t.end() : key(*it) == *rit);
+        }
+        if (i % 1000 == 0)
+            assert(t.btree_verify());
+    }
+    assert(t.btree_verify() && t.size() == ref.size());
+    auto rit = ref.begin();
+    for (auto it = t.begin(); it != t.end(); ++it, ++rit)
+        assert(key(*it) == *rit);
+    auto it = t.end();
+    for (auto r = ref.rbegin(); r != ref.rend(); ++r)
+        assert(key(*--it) == *r);
+    assert(it == t.begin());
+    for (int k = -1; k <= range; k += 7)
+        assert(t.count(k) == ref.count(k));
+}
+
+void test_case14()
+{
+    cout << "<test_case14>" << endl;
+
+    STL::btree<int, int, std::_Identity<int>, std::less<int>> t;
+    btree_random_test(t, std::_Identity<int>(), 200000, 20000, 14);
+    assert(t.height() <= 4);
+
+    STL::btree<int, Wide, WideKey, std::less<int>> w;
+    btree_random_test(w, WideKey(), 50000, 3000, 41);
+    assert(w.height() > 4);
+
+    // 复制、赋值与清空
+    STL::btree<int, Wide, WideKey, std::less<int>> c(w);
+    assert(c.btree_verify() && c.size() == w.size());
+    auto ci = c.begin();
+    for (auto it = w.begin(); it != w.end(); ++it, ++ci)
+        assert(ci->k == it->k && ci->pad[0] == it->pad[0]);
+    c.erase(c.begin(), c.end());
+    assert(c.empty() && c.begin() == c.end() && c.btree_verify());
+    c = w;
+    assert(c.size() == w.size());
+    auto first = c.lower_bound(1000), last = c.upper_bound(2000);
+    const size_t n = STL::distance(first, last);
+    c.erase(first, last);
+    assert(c.size() == w.size() - n && c.btree_verify());
+    assert(c.lower_bound(1000) == c.upper_bound(2000));
+
+    // 依次删除到空
+    for (auto it = w.begin(); it != w.end(); )
+        it = w.erase(it);
+    assert(w.empty() && w.btree_verify());
+}
+
+// btree_set、btree_map
+void test_case15()
+{
+    cout << "<test_case15>" << endl;
+
+    STL::btree_set<int> s = { 5, 3, 9, 3, 1 };
+    assert(s.size() == 4 && *s.begin() == 1 && !s.insert(9).second);
+    assert(*s.lower_bound(4) == 5 && s.upper_bound(9) == s.end());
+    assert(s.erase(3) == 1 && s.count(3) == 0);
+
+    STL::btree_set<string, StrLess> ss;
+    ss.emplace("pear");
+    ss.insert("apple");
+    assert(ss.count("pear") == 1 && *ss.find("apple") == "apple");
+
+    STL::btree_map<int, string> m;
+    for (int i = 0; i < 10000; ++i)
+        m[(i * 7919) % 10000] = std::to_string(i);
+    assert(m.size() == 10000 && m.at(7919 % 10000) == "1");
+    int prev = -1;
+    for (auto it = m.begin(); it != m.end(); ++it) {
+        assert(it->first == prev + 1);
+        prev = it->first;
+    }
+    assert(!m.try_emplace(5, "x").second && m.insert_or_assign(5, "y").first->second == "y");
+    for (int i = 0; i < 10000; i += 2)
+        assert(m.erase(i) == 1);
+    assert(m.size() == 5000 && m.find(4) == m.end() && m.find(5)->second == "y");
+
+    STL::btree_map<int, string> m2(m);
+    assert(m2 == m);
+    m2[1] = "changed";
+    assert(m2 != m);
+    bool thrown = false;
+    try {
+        m.at(0);
+    } catch(const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+// 以有序范围构造：sorted_range标记，自底向上建树
+void test_case16()
+{
+    cout << "<test_case16>" << endl;
+
+    for (int n = 0; n < 300; ++n) {
+        STL::vector<int> v;
+        for (int i = 0; i < n; ++i)
+            v.push_back(i / 2);     // 有序，且每个键值出现两次
+        myRbtree t1, t2;
+        t1.insert_unique(STL::sorted_range, v.begin(), v.end());
+        t2.insert_equal(STL::sorted_range, v.begin(), v.end());
+        assert(t1.rb_verify() && t1.size() == static_cast<size_t>((n + 1) / 2));
+        assert(t2.rb_verify() && t2.size() == static_cast<size_t>(n));
+        assert(STL::equal(t2.begin(), t2.end(), v.begin()));
+        int k = 0;
+        for (auto it = t1.begin(); it != t1.end(); ++it)
+            assert(*it == k++);
+    }
+
+    // 范围实际无序时，有序前缀之后的元素逐个插入
+    STL::vector<int> v;
+    for (int i = 0; i < 1000; ++i)
+        v.push_back(i * 2);
+    for (int i = 0; i < 1000; ++i)
+        v.push_back((i * 7919) % 2000);
+    myRbtree t1, t2;
+    std::set<int> s(v.begin(), v.end());
+    std::multiset<int> ms(v.begin(), v.end());
+    t1.insert_unique(STL::sorted_range, v.begin(), v.end());
+    t2.insert_equal(STL::sorted_range, v.begin(), v.end());
+    assert(t1.rb_verify() && t1.size() == s.size() && STL::equal(t1.begin(), t1.end(), s.begin()));
+    assert(t2.rb_verify() && t2.size() == ms.size() && STL::equal(t2.begin(), t2.end(), ms.begin()));
+
+    // 建成的树可以继续插入、删除
+    for (int i = 0; i < 2000; i += 3)
+        t1.erase(i);
+    for (int i = 0; i < 500; ++i)
+        t1.insert_unique(-i);
+    assert(t1.rb_verify());
+
+    // 相同键值保持输入顺序
+    STL::vector<pair<const int, Counted>> pv;
+    for (int i = 0; i < 10; ++i)
+        pv.push_back(pair<const int, Counted>(i / 3, Counted(i)));
+    mapRbtree mt;
+    mt.insert_equal(STL::sorted_range, pv.begin(), pv.end());
+    int i = 0;
+    for (auto it = mt.begin(); it != mt.end(); ++it, ++i)
+        assert(it->first == i / 3 && it->second.v == i);
+    assert(mt.rb_verify());
+
+    // 非空树上退化为逐个插入
+    mt.insert_unique(STL::sorted_range, pv.begin(), pv.end());
+    assert(mt.size() == 10 && mt.rb_verify());
+}
+
+// 带提示的插入
+struct CountLess
+{
+    static int calls;
+    bool operator()(int x, int y) const { ++calls; return x < y; }
+};
+int CountLess::calls = 0;
+
+void test_case17()
+{
+    cout << "<test_case17>" << endl;
+
+    // 按升序以end()为提示、按降序以begin()为提示，每次插入只比较常数次
+    STL::rb_tree<int, int, std::_Identity<int>, CountLess> t;
+    CountLess::calls = 0;
+    for (int i = 0; i < 10000; ++i)
+        assert(*t.insert_unique(t.end(), i) == i);
+    for (int i = -1; i >= -10000; --i)
+        t.insert_unique(t.begin(), i);
+    assert(CountLess::calls <= 2 * 20000 && t.size() == 20000 && t.rb_verify());
+
+    // 提示位于新值的前驱之后
+    myRbtree t1;
+    for (int i = 0; i < 1000; i += 2)
+        t1.insert_unique(i);
+    for (int i = 1; i < 1000; i += 2) {
+        auto next = t1.find(i + 1);
+        auto it = t1.insert_unique(next, i);
+        assert(*it == i && ++it == next);
+    }
+    assert(t1.size() == 1000 && t1.rb_verify());
+
+    // 键值重复时返回已有元素，提示错误时结果不变
+    assert(t1.insert_unique(t1.begin(), 500) == t1.find(500) && t1.size() == 1000);
+    std::multiset<int> ref(t1.begin(), t1.end());
+    myRbtree t2(t1);
+    std::mt19937 gen(44);
+    for (int i = 0; i < 20000; ++i) {
+        const int k = static_cast<int>(gen() % 3000);
+        auto hint = t2.lower_bound(static_cast<int>(gen() % 3000));
+        auto it = (i & 1) ? t2.insert_equal(hint, k) : t2.emplace_hint_equal(hint, k);
+        assert(*it == k);
+        ref.insert(k);
+        auto u = t1.emplace_hint_unique(t1.lower_bound(k), k);
+        assert(u == t1.find(k));
+    }
+    assert(t2.rb_verify() && t2.size() == ref.size() && STL::equal(t2.begin(), t2.end(), ref.begin()));
+    assert(t1.rb_verify() && t1.size() == std::set<int>(ref.begin(), ref.end()).size());
+
+    // 相同键值以其后的元素为提示时插在其前
+    myRbtree t3;
+    t3.insert_equal(1);
+    auto last = t3.insert_equal(1);
+    auto mid = t3.insert_equal(last, 1);
+    assert(++mid == last);
+
+    // map：键值已存在时try_emplace不构造实值
+    mapRbtree m;
+    for (int i = 0; i < 100; ++i)
+        m.try_emplace(m.end(), i, i);
+    Counted::constructed = 0;
+    auto it = m.try_emplace(m.find(51), 50, 0);
+    assert(it->second.v == 50 && Counted::constructed == 0);
+    it = m.try_emplace(m.end(), 100, 7);
+    assert(it->second.v == 7 && Counted::constructed == 1 && m.rb_verify());
+}
+
+// 顺序统计：rank、select、index_of、distance
+void test_case18()
+{
+    cout << "<test_case18>" << endl;
+
+    using osTree = STL::rb_tree<int, int, std::_Identity<int>, std::less<int>,
+                                STL::pool_alloc, STL::rb_tree_count_augment>;
+    osTree t;
+    std::multiset<int> ref;
+    std::mt19937 gen(45);
+    for (int i = 0; i < 20000; ++i) {
+        const int k = static_cast<int>(gen() % 2000);
+        switch (gen() % 4) {
+        case 0: t.insert_equal(k); ref.insert(k); break;
+        case 1: t.insert_equal(t.lower_bound(k), k); ref.insert(k); break;
+        case 2: assert(t.erase(k) == ref.erase(k)); break;
+        default:
+            if (t.find(k) != t.end()) {
+                t.erase(t.find(k));
+                ref.erase(ref.find(k));
+            }
+        }
+        if (i % 500 == 0) {
+            assert(t.rb_verify());
+            const size_t r = static_cast<size_t>(std::distance(ref.begin(), ref.lower_bound(k)));
+            assert(t.rank(k) == r && t.index_of(t.lower_bound(k)) == r);
+            if (r < ref.size())
+                assert(*t.select(r) == *ref.lower_bound(k));
+        }
+    }
+    assert(t.rb_verify() && t.size() == ref.size());
+    size_t i = 0;
+    for (auto it = t.begin(); it != t.end(); ++it, ++i)
+        assert(t.select(i) == it && t.index_of(it) == i);
+    assert(t.select(t.size()) == t.end() && t.index_of(t.end()) == t.size());
+    assert(t.distance(t.lower_bound(500), t.upper_bound(1500)) ==
+           std::distance(ref.lower_bound(500), ref.upper_bound(1500)));
+
+    // 复制、有序构造、摘下与合并都维护子树节点数
+    osTree c(t);
+    assert(c.rb_verify() && c.select(100) != c.end() && *c.select(100) == *t.select(100));
+    STL::vector<int> v;
+    for (int k = 0; k < 1000; ++k)
+        v.push_back(k * 2);
+    osTree b;
+    b.insert_unique(STL::sorted_range, v.begin(), v.end());
+    assert(b.rb_verify() && b.rank(1001) == 501 && *b.select(999) == 1998);
+    osTree::node_type nh = b.extract(b.select(0));
+    assert(nh.value() == 0 && b.rb_verify() && *b.select(0) == 2);
+    b.insert_unique(std::move(nh));
+    b.merge_equal(c);
+    assert(b.rb_verify() && c.empty() && b.size() == 1000 + t.size());
+
+    // set与map
+    STL::set<int, std::less<int>, STL::pool_alloc, STL::rb_tree_count_augment> s;
+    for (int k = 100; k > 0; --k)
+        s.insert(k * 10);
+    assert(s.rank(555) == 55 && *s.select(0) == 10 && *s.select(99) == 1000 && s.select(100) == s.end());
+    assert(s.index_of(s.find(500)) == 49 && s.distance(s.find(100), s.find(200)) == 10);
+
+    STL::map<string, int, StrLess, STL::pool_alloc, STL::rb_tree_count_augment> m;
+    m["b"] = 2;
+    m["a"] = 1;
+    m["c"] = 3;
+    assert(m.rank("b") == 1 && m.select(2)->second == 3);
+}
+
+// 自定义附加数据：区间求和、非交换的汇总、区间树
+struct MappedOf
+{
+    long operator()(const pair<const int, long>& v) const { return v.second; }
+};
+
+// 多项式hash，combine不满足交换律，可检验汇总的顺序
+struct PolyHash
+{
+    uint64_t h, p;
+    bool operator==(const PolyHash& x) const { return h == x.h && p == x.p; }
+};
+
+struct PolyHashMonoid
+{
+    using meta_type = PolyHash;
+    PolyHash identity() const { return PolyHash{0, 1}; }
+    PolyHash value(int v) const { return PolyHash{static_cast<uint64_t>(v), 131}; }
+    PolyHash combine(const PolyHash& a, const PolyHash& b) const { return PolyHash{a.h * b.p + b.h, a.p * b.p}; }
+};
+
+struct HighOf
+{
+    const int& operator()(const pair<const int, int>& v) const { return v.second; }
+};
+
+void test_case19()
+{
+    cout << "<test_case19>" << endl;
+
+    // map的实值区间求和
+    STL::map<int, long, std::less<int>, STL::pool_alloc, STL::rb_tree_sum_augment<long, MappedOf>> m;
+    std::map<int, long> ref;
+    std::mt19937 gen(46);
+    for (int i = 0; i < 5000; ++i) {
+        const int k = static_cast<int>(gen() % 1000);
+        const long v = static_cast<long>(gen() % 100);
+        if (gen() % 3) {
+            m.insert_or_assign(k, v);
+            ref[k] = v;
+        } else {
+            m.erase(k);
+            ref.erase(k);
+        }
+        const int lo = static_cast<int>(gen() % 1000), hi = static_cast<int>(gen() % 1000);
+        long sum = 0;
+        for (auto it = ref.lower_bound(lo); it != ref.end() && it->first < hi; ++it)
+            sum += it->second;
+        assert(m.aggregate(lo, hi) == sum);
+    }
+    long total = 0;
+    for (auto& x : ref)
+        total += x.second;
+    assert(m.aggregate() == total && m.aggregate(0, 1000) == total);
+    m.begin()->second += 1000;
+    m.refresh(m.begin());   // 通过迭代器修改实值后须更新
+    assert(m.aggregate() == total + 1000);
+
+    // 汇总按元素顺序进行
+    using hashTree = STL::rb_tree<int, int, std::_Identity<int>, std::less<int>,
+                                  STL::pool_alloc, STL::rb_tree_monoid_augment<PolyHashMonoid>>;
+    hashTree h;
+    for (int i = 0; i < 3000; ++i)
+        h.insert_equal(static_cast<int>(gen() % 500));
+    assert(h.rb_verify());
+    for (int i = 0; i < 200; ++i) {
+        const int lo = static_cast<int>(gen() % 520) - 10, hi = lo + static_cast<int>(gen() % 100);
+        PolyHash e = PolyHashMonoid().identity();
+        for (auto it = h.lower_bound(lo); it != h.lower_bound(hi); ++it)
+            e = PolyHashMonoid().combine(e, PolyHashMonoid().value(*it));
+        assert(h.aggregate(lo, hi) == e);
+    }
+
+    // 区间树：以左端点为键值，查询与[lo, hi]相交的区间
+    using intervalTree = STL::rb_tree<int, pair<const int, int>, std::_Select1st<pair<const int, int>>, std::less<int>,
+                                      STL::pool_alloc, STL::rb_tree_interval_augment<int, HighOf>>;
+    intervalTree it;
+    STL::vector<pair<int, int>> all;
+    for (int i = 0; i < 2000; ++i) {
+        const int a = static_cast<int>(gen() % 10000);
+        const int b = a + static_cast<int>(gen() % 200);
+        it.insert_equal(pair<const int, int>(a, b));
+        all.push_back(pair<int, int>(a, b));
+    }
+    for (int i = 0; i < 200; ++i) {
+        auto e = it.find(all[i].first);
+        all[i] = all.back();
+        all.pop_back();
+        it.erase(e);
+    }
+    assert(it.rb_verify());
+    for (int i = 0; i < 300; ++i) {
+        const int lo = static_cast<int>(gen() % 10500) - 200, hi = lo + static_cast<int>(gen() % 300);
+        std::multiset<pair<int, int>> expect, got;
+        for (auto& x : all)
+            if (x.first <= hi && x.second >= lo)
+                expect.insert(x);
+        int prev = INT_MIN;
+        it.for_each_overlap(lo, hi, [&](const pair<const int, int>& x) {
+            assert(x.first >= prev);
+            prev = x.first;
+            got.insert(pair<int, int>(x.first, x.second));
+        });
+        assert(got == expect);
+        auto f = it.find_overlap(lo, hi);
+        assert(expect.empty() ? f == it.end() : f->first == expect.begin()->first);
+    }
+}
+
+// 基于split与join的批量集合运算
+template <class Tree>
+void fill_random(Tree& t, std::set<int>& ref, int n, int range, std::mt19937& gen)
+{
+    for (int i = 0; i < n; ++i) {
+        const int k = static_cast<int>(gen() % range);
+        t.insert_unique(k);
+        ref.insert(k);
+    }
+}
+
+void test_case20()
+{
+    cout << "<test_case20>" << endl;
+
+    using osTree = STL::rb_tree<int, int, std::_Identity<int>, std::less<int>,
+                                STL::pool_alloc, STL::rb_tree_count_augment>;
+    std::mt19937 gen(47);
+    const int sizes[][2] = { {0, 100}, {100, 0}, {1, 5000}, {5000, 1}, {30, 20000}, {20000, 30}, {3000, 3000} };
+    for (auto& sz : sizes) {
+        for (int op = 0; op < 4; ++op) {
+            osTree a, b;
+            std::set<int> ra, rb;
+            fill_random(a, ra, sz[0], 40000, gen);
+            fill_random(b, rb, sz[1], 40000, gen);
+            std::vector<int> expect, dup;
+            switch (op) {
+            case 0:
+            case 1:
+                // 并集：键值重复的节点留在b中；按子树合并与逐个插入的结果相同
+                std::set_union(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(expect));
+                std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(dup));
+                if (op == 0)
+                    a.set_union(b);
+                else
+                    a.merge_unique(b);
+                assert(b.rb_verify() && b.size() == dup.size() && STL::equal(b.begin(), b.end(), dup.begin()));
+                b.clear();
+                break;
+            case 2:
+                std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(expect));
+                a.set_intersection(b);
+                break;
+            default:
+                std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(expect));
+                a.set_difference(b);
+            }
+            assert(a.rb_verify() && a.size() == expect.size() && STL::equal(a.begin(), a.end(), expect.begin()));
+            assert(b.empty());
+            if (!a.empty())
+                assert(*a.select(a.size() / 2) == expect[expect.size() / 2]);
+        }
+    }
+
+    // 键值允许重复：来自src的节点排在相同键值的节点之后
+    using pairTree = STL::rb_tree<int, pair<const int, int>, std::_Select1st<pair<const int, int>>, std::less<int>>;
+    pairTree m1, m2;
+    std::multimap<int, int> rm;
+    for (int i = 0; i < 3000; ++i) {
+        const int k = static_cast<int>(gen() % 500);
+        m1.insert_equal(pair<const int, int>(k, i));
+        rm.insert(pair<const int, int>(k, i));
+    }
+    for (int i = 0; i < 200; ++i) {
+        const int k = static_cast<int>(gen() % 600);
+        m2.insert_equal(pair<const int, int>(k, 10000 + i));
+        rm.insert(pair<const int, int>(k, 10000 + i));
+    }
+    m1.merge_equal(m2);
+    assert(m1.rb_verify() && m2.empty() && m1.size() == rm.size());
+    assert(std::equal(m1.begin(), m1.end(), rm.begin()));
+
+    // 附加数据在join中得到维护；多线程的结果与单线程相同
+    using sumTree = STL::rb_tree<int, int, std::_Identity<int>, std::less<int>,
+                                 STL::pool_alloc, STL::rb_tree_sum_augment<long, std::_Identity<int>>>;
+    sumTree s1, s2, s3, s4;
+    std::set<int> r1, r2;
+    fill_random(s1, r1, 200000, 1000000, gen);
+    fill_random(s2, r2, 100000, 1000000, gen);
+    s3 = s1;
+    s4 = s2;
+    s1.set_union(s2, 4);
+    s3.set_union(s4);
+    assert(s1.rb_verify() && s1.size() == s3.size() && STL::equal(s1.begin(), s1.end(), s3.begin()));
+    long sum = 0;
+    for (int x : s1)
+        sum += x;
+    assert(s1.aggregate() == sum);
+    s2.insert_unique(r2.begin(), r2.end());
+    s4 = s2;
+    s3 = s1;
+    s1.set_difference(s2, 0);
+    s3.set_intersection(s4, 4);
+    // s1为r1与r2的并集
+    const size_t common = static_cast<size_t>(std::count_if(r1.begin(), r1.end(), [&](int k) { return r2.count(k) != 0; }));
+    assert(s1.rb_verify() && s1.size() == r1.size() - common);
+    assert(s3.rb_verify() && s3.size() == r2.size() && STL::equal(s3.begin(), s3.end(), r2.begin()));
+
+    // set与map
+    STL::set<int> x = {1, 3, 5, 7, 9}, y = {3, 4, 5, 6};
+    STL::set<int> z(x);
+    x.set_union(STL::set<int>(y));
+    assert(x.size() == 7 && *x.begin() == 1 && *--x.end() == 9);
+    z.set_intersection(STL::set<int>(y));
+    assert(z.size() == 2 && *z.begin() == 3);
+    x.set_difference(y);
+    assert(x.size() == 3 && y.empty());
+    STL::map<int, int> p = {{1, 1}, {2, 2}}, q = {{2, 20}, {3, 30}};
+    p.merge(q);
+    assert(p.size() == 3 && p[2] == 2 && q.size() == 1 && q[2] == 20);
+}
+
+// 持久化map：快照共享节点，修改只复制查找路径
+struct CountingAlloc
+{
+    static std::atomic<long> live;
+    static void* allocate(size_t n) { ++live; return STL::malloc_alloc::allocate(n); }
+    static void deallocate(void* p, size_t n) { --live; STL::malloc_alloc::deallocate(p, n); }
+};
+std::atomic<long> CountingAlloc::live(0);
+
+void test_case21()
+{
+    cout << "<test_case21>" << endl;
+
+    using pMap = STL::persistent_map<int, int, std::less<int>, CountingAlloc>;
+    {
+        pMap m;
+        assert(m.key_comp()(1, 2) && !m.key_comp()(2, 1));
+        std::map<int, int> ref;
+        std::vector<pair<pMap, std::map<int, int>>> snapshots;
+        std::mt19937 gen(48);
+        for (int i = 0; i < 20000; ++i) {
+            const int k = static_cast<int>(gen() % 3000);
+            switch (gen() % 3) {
+            case 0:
+                assert(m.insert(pair<const int, int>(k, i)) == ref.insert(pair<const int, int>(k, i)).second);
+                break;
+            case 1:
+                assert(m.insert_or_assign(k, i) == (ref.count(k) == 0));
+                ref[k] = i;
+                break;
+            default:
+                assert(m.erase(k) == ref.erase(k));
+            }
+            if (i % 2000 == 0) {
+                assert(m.verify());
+                snapshots.push_back(pair<pMap, std::map<int, int>>(m, ref));
+            }
+        }
+        assert(m.verify() && m.size() == ref.size() && std::equal(m.begin(), m.end(), ref.begin()));
+        // 旧版本不受之后修改的影响
+        for (auto& s : snapshots)
+            assert(s.first.verify() && s.first.size() == s.second.size() &&
+                   std::equal(s.first.begin(), s.first.end(), s.second.begin()));
+
+        // 查找
+        for (int k = -1; k <= 3000; k += 7) {
+            auto it = ref.lower_bound(k);
+            assert(it == ref.end() ? m.lower_bound(k) == m.end() : m.lower_bound(k)->first == it->first);
+            it = ref.upper_bound(k);
+            assert(it == ref.end() ? m.upper_bound(k) == m.end() : m.upper_bound(k)->first == it->first);
+            assert(m.count(k) == ref.count(k) && (m.find(k) == m.end()) == (ref.count(k) == 0));
+            assert(m.get(k) == nullptr ? ref.count(k) == 0 : *m.get(k) == ref[k]);
+        }
+
+        // 复制不分配节点，修改只分配O(log n)个节点
+        const long before = CountingAlloc::live;
+        pMap c(m);
+        assert(CountingAlloc::live == before);
+        c.insert_or_assign(ref.begin()->first, -1);
+        assert(CountingAlloc::live - before <= 30);
+        assert(m.at(ref.begin()->first) == ref.begin()->second && c.at(ref.begin()->first) == -1);
+        c = pMap();
+        assert(CountingAlloc::live == before);
+    }
+    assert(CountingAlloc::live == 0);
+
+    // 写者发布新版本，读者持锁复制快照后放锁读取，版本内的实值都相同
+    {
+        pMap shared;
+        for (int k = 0; k < 1000; ++k)
+            shared.insert(pair<const int, int>(k, 0));
+        std::mutex mtx;
+        std::atomic<bool> done(false);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 3; ++r) {
+            readers.push_back(std::thread([&]() {
+                while (!done) {
+                    pMap snap;
+                    {
+                        std::lock_guard<std::mutex> lock(mtx);
+                        snap = shared;
+                    }
+                    const int v = snap.begin()->second;
+                    size_t n = 0;
+                    for (auto& x : snap) {
+                        assert(x.second == v);
+                        ++n;
+                    }
+                    assert(n == 1000);
+                }
+            }));
+        }
+        for (int v = 1; v <= 200; ++v) {
+            pMap next;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                next = shared;
+            }
+            for (int k = 0; k < 1000; ++k)
+                next.insert_or_assign(k, v);
+            std::lock_guard<std::mutex> lock(mtx);
+            shared = std::move(next);
+        }
+        done = true;
+        for (auto& t : readers)
+            t.join();
+        assert(shared.at(999) == 200);
+    }
+    assert(CountingAlloc::live == 0);
+}
+
+// 复制与删除：整批分配节点，不递归；复制中途抛出异常时不泄漏节点
+struct ThrowOnCopy
+{
+    static int countdown;   // 再复制这么多次后抛出异常，负数表示不抛出
+    int v;
+    ThrowOnCopy(int x) : v(x) { }
+    ThrowOnCopy(const ThrowOnCopy& x) : v(x.v)
+    {
+        if (countdown >= 0 && countdown-- == 0)
+            throw std::runtime_error("ThrowOnCopy");
+    }
+    bool operator<(const ThrowOnCopy& x) const { return v < x.v; }
+};
+int ThrowOnCopy::countdown = -1;
+
+void test_case22()
+{
+    cout << "<test_case22>" << endl;
+
+    // 大树的复制与清除，附加数据随节点复制
+    using osTree = STL::rb_tree<int, int, std::_Identity<int>, std::less<int>,
+                                STL::pool_alloc, STL::rb_tree_count_augment>;
+    osTree t;
+    std::mt19937 gen(49);
+    for (int i = 0; i < 100000; ++i)
+        t.insert_equal(static_cast<int>(gen() % 50000));
+    osTree c(t);
+    assert(c.rb_verify() && c.size() == t.size() && STL::equal(c.begin(), c.end(), t.begin()));
+    assert(*c.select(12345) == *t.select(12345));
+    c.clear();
+    assert(c.empty() && c.begin() == c.end());
+    c = t;
+    assert(c.rb_verify() && c.size() == t.size());
+    c.clear();
+    osTree e;
+    c = e;
+    assert(c.empty() && c.rb_verify());
+
+    // 分配器没有整批接口时逐块分配；复制失败后已分配的节点全部归还
+    using thrTree = STL::rb_tree<ThrowOnCopy, ThrowOnCopy, std::_Identity<ThrowOnCopy>, std::less<ThrowOnCopy>, CountingAlloc>;
+    {
+        thrTree x;
+        for (int i = 0; i < 1000; ++i)
+            x.insert_unique(ThrowOnCopy(static_cast<int>(gen() % 5000)));
+        const long live = CountingAlloc::live;
+        for (int k : {0, 1, 500, static_cast<int>(x.size()) - 1}) {
+            ThrowOnCopy::countdown = k;
+            bool thrown = false;
+            try {
+                thrTree y(x);
+            } catch(const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown && CountingAlloc::live == live);
+            thrTree z;
+            z.insert_unique(ThrowOnCopy(-1));
+            ThrowOnCopy::countdown = k;
+            thrown = false;
+            try {
+                z = x;
+            } catch(const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown && z.empty() && z.rb_verify());
+        }
+        ThrowOnCopy::countdown = -1;
+        thrTree y(x);
+        assert(y.rb_verify() && y.size() == x.size() && CountingAlloc::live == live + static_cast<long>(x.size()));
+    }
+    assert(CountingAlloc::live == 0);
+}
+
 void test_all_cases()
 {
     test_case1();
@@ -234,6 +1139,18 @@ void test_all_cases()
     test_case8();
     test_case9();
     test_case10();
+    test_case11();
+    test_case12();
+    test_case13();
+    test_case14();
+    test_case15();
+    test_case16();
+    test_case17();
+    test_case18();
+    test_case19();
+    test_case20();
+    test_case21();
+    test_case22();
 }
 
 // 性能测试